@@ -0,0 +1,266 @@
+// FILE: ComplexityCheck.cpp
+//       Empirical complexity check for IntSet: times each operation
+//       at geometrically increasing set sizes, fits the growth
+//       exponent k of time ~ n^k by least squares on log time against
+//       log n, and fails if k is above the operation's limit.
+//       CTest runs it when the build is configured with
+//       -DINTSET_PERF_TESTS=ON.
+//
+// USAGE: intset_complexity [--min-size=N] [--steps=S] [operation ...]
+//   --min-size:  smallest set size (default 2000)
+//   --steps:     # of sizes, each twice the one before (default 5)
+//   operation:   operations to check (default: all of them)
+//
+// LIMITS (time of ONE call, as a function of set size n):
+//   contains, add                          O(1) expected; limit 0.5
+//   remove                                 O(n) (members after the
+//                                          removed one shift down to
+//                                          keep membership order);
+//                                          limit 1.5
+//   copy, assignment, unionWith,
+//   intersect, subtract, isSubsetOf, ==    O(n); limit 1.5
+// The limits leave room for O(log n) factors and for the jump in
+// time as the sets outgrow each level of cache, while still sitting
+// halfway to the next complexity class up.
+// A quadratic operation fits k close to 2 and fails by a wide margin.
+//
+// Exit status is 0 if every operation checked is within its limit,
+// otherwise 1.
+
+#include "IntSet.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace
+{
+    const int REPEATS = 5;              // best-of-REPEATS is used
+    const double MIN_SECONDS = 0.01;    // per timing
+
+    struct Operation
+    {
+        const char* name;
+        double      limit;
+    };
+
+    const Operation OPERATIONS[] = {
+        { "contains", 0.5 }, { "add", 0.5 }, { "remove", 1.5 },
+        { "copy", 1.5 }, { "assignment", 1.5 }, { "unionWith", 1.5 },
+        { "intersect", 1.5 }, { "subtract", 1.5 }, { "isSubsetOf", 1.5 },
+        { "equal", 1.5 }
+    };
+    const int NUM_OPERATIONS = int(sizeof(OPERATIONS) / sizeof(OPERATIONS[0]));
+
+    // Keeps results alive so the compiler can't drop the work.
+    volatile long sink;
+
+    // Operands of size n: lhs, rhs overlapping lhs by half, same (equal
+    // to lhs but built in another order, so == and isSubsetOf have to
+    // look at every member), and probe keys half of which are members.
+    struct Operands
+    {
+        vector<int> values;
+        vector<int> keys;
+        IntSet      lhs;
+        IntSet      rhs;
+        IntSet      same;
+    };
+
+    void makeOperands(int n, Operands& ops)
+    {
+        mt19937 rng(static_cast<unsigned>(n));
+        ops.values.clear();
+        for (int i = 0; i < 2 * n; ++i)
+            ops.values.push_back(i * 13);
+        shuffle(ops.values.begin(), ops.values.end(), rng);
+
+        ops.lhs.reset();
+        ops.rhs.reset();
+        ops.same.reset();
+        ops.keys.assign(ops.values.begin() + n / 2,
+                        ops.values.begin() + n / 2 + n);
+        for (int i = 0; i < n; ++i)
+            ops.lhs.add(ops.values[i]);
+        for (int i = n - 1; i >= 0; --i)
+            ops.same.add(ops.values[i]);
+        for (int i = 0; i < n; ++i)
+            ops.rhs.add(ops.keys[i]);
+    }
+
+    // Seconds for one run of op on operands of size n; calls made per
+    // run is returned through calls.
+    double runOnce(const string& op, int n, const Operands& ops, long& calls)
+    {
+        chrono::steady_clock::time_point t0, t1;
+        calls = 1;
+        if (op == "contains") {
+            long hits = 0;
+            t0 = chrono::steady_clock::now();
+            for (int i = 0; i < n; ++i)
+                hits += ops.lhs.contains(ops.keys[i]);
+            t1 = chrono::steady_clock::now();
+            sink += hits;
+            calls = n;
+        } else if (op == "add") {
+            IntSet is;
+            t0 = chrono::steady_clock::now();
+            for (int i = 0; i < n; ++i)
+                is.add(ops.values[i]);
+            t1 = chrono::steady_clock::now();
+            sink += is.size();
+            calls = n;
+        } else if (op == "remove") {
+            IntSet is(ops.lhs);
+            t0 = chrono::steady_clock::now();
+            for (int i = 0; i < n; ++i)
+                is.remove(ops.keys[i]);
+            t1 = chrono::steady_clock::now();
+            sink += is.size();
+            calls = n;
+        } else if (op == "copy") {
+            t0 = chrono::steady_clock::now();
+            IntSet is(ops.lhs);
+            t1 = chrono::steady_clock::now();
+            sink += is.size();
+        } else if (op == "assignment") {
+            IntSet is;
+            t0 = chrono::steady_clock::now();
+            is = ops.lhs;
+            t1 = chrono::steady_clock::now();
+            sink += is.size();
+        } else {
+            t0 = chrono::steady_clock::now();
+            if (op == "unionWith")
+                sink += ops.lhs.unionWith(ops.rhs).size();
+            else if (op == "intersect")
+                sink += ops.lhs.intersect(ops.rhs).size();
+            else if (op == "subtract")
+                sink += ops.lhs.subtract(ops.rhs).size();
+            else if (op == "isSubsetOf")
+                sink += ops.lhs.isSubsetOf(ops.same);
+            else
+                sink += ops.lhs == ops.same;
+            t1 = chrono::steady_clock::now();
+        }
+        return chrono::duration<double>(t1 - t0).count();
+    }
+
+    // Best seconds per call of op at size n.
+    double timeCall(const string& op, int n, const Operands& ops)
+    {
+        double best = 0;
+        for (int r = 0; r < REPEATS; ++r) {
+            double seconds = 0;
+            long calls = 0;
+            while (seconds < MIN_SECONDS) {
+                long c;
+                seconds += runOnce(op, n, ops, c);
+                calls += c;
+            }
+            double perCall = seconds / double(calls);
+            if (r == 0 || perCall < best)
+                best = perCall;
+        }
+        return best;
+    }
+
+    // Least-squares slope of log(seconds) against log(sizes).
+    double fitExponent(const vector<int>& sizes, const vector<double>& seconds)
+    {
+        double n = double(sizes.size());
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            double x = log(double(sizes[i]));
+            double y = log(seconds[i]);
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+        }
+        return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    }
+
+    bool parseOption(const char* arg, const char* flag, string& value)
+    {
+        size_t len = strlen(flag);
+        if (strncmp(arg, flag, len) != 0 || arg[len] != '=')
+            return false;
+        value = arg + len + 1;
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int minSize = 2000;
+    int steps = 5;
+    vector<int> chosen;
+
+    for (int a = 1; a < argc; ++a) {
+        string value;
+        if (parseOption(argv[a], "--min-size", value)) {
+            minSize = atoi(value.c_str());
+        } else if (parseOption(argv[a], "--steps", value)) {
+            steps = atoi(value.c_str());
+        } else {
+            int o = 0;
+            while (o < NUM_OPERATIONS && strcmp(argv[a], OPERATIONS[o].name) != 0)
+                ++o;
+            if (o == NUM_OPERATIONS) {
+                cerr << "Unknown option or operation " << argv[a] << endl;
+                return EXIT_FAILURE;
+            }
+            chosen.push_back(o);
+        }
+    }
+    if (minSize < 1) { minSize = 1; }
+    if (steps < 2) { steps = 2; }
+    if (chosen.empty())
+        for (int o = 0; o < NUM_OPERATIONS; ++o)
+            chosen.push_back(o);
+
+    vector<int> sizes;
+    for (int s = 0, n = minSize; s < steps; ++s, n *= 2)
+        sizes.push_back(n);
+
+    // seconds[o][s]: per-call time of chosen[o] at sizes[s].
+    vector< vector<double> > seconds(chosen.size());
+    Operands ops;
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        makeOperands(sizes[s], ops);
+        for (size_t o = 0; o < chosen.size(); ++o)
+            seconds[o].push_back(
+                timeCall(OPERATIONS[chosen[o]].name, sizes[s], ops));
+    }
+
+    cout << left << setw(12) << "operation" << right;
+    for (size_t s = 0; s < sizes.size(); ++s)
+        cout << setw(12) << sizes[s];
+    cout << setw(10) << "exponent" << setw(8) << "limit" << endl;
+
+    bool passed = true;
+    for (size_t o = 0; o < chosen.size(); ++o) {
+        const Operation& op = OPERATIONS[chosen[o]];
+        double k = fitExponent(sizes, seconds[o]);
+        cout << left << setw(12) << op.name << right << fixed;
+        for (size_t s = 0; s < sizes.size(); ++s)
+            cout << setw(12) << setprecision(0) << seconds[o][s] * 1e9;
+        cout << setw(10) << setprecision(2) << k << setw(8) << op.limit;
+        if (k > op.limit) {
+            cout << "  FAIL" << endl;
+            passed = false;
+        } else {
+            cout << "  ok" << endl;
+        }
+    }
+    cout << "(times are ns per call)" << endl;
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,1293 @@
+// FILE: Driver.cpp
+//       Command dispatch and input helpers for the interactive IntSet
+//       test program (See Driver.h for documentation.)
+
+#include "Driver.h"
+#include "IntSetExpr.h"
+#include "IntSetQuery.h"
+#include "IntSetServer.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace
+{
+   struct CommandRun
+   {
+      long long nanoseconds;
+      size_t    sizes[3];    // sizes of is1, is2, is3 at dispatch
+   };
+
+   map<char, vector<CommandRun> > profile;
+
+   unique_ptr<IntSetRegistry> registry;
+   mutex                      registry_lock;   // for serve_named_sets
+   IntSetServer*              server = NULL;   // while serving
+
+   // SIGINT/SIGTERM handler while serving.
+   void stop_serving(int)
+   {
+      if (server != NULL)
+         server->stop();
+   }
+
+   const size_t QUIET_BUFFER = 1 << 16;
+
+   // Whitespace-separated tokens from a FILE*, read a buffer at a time.
+   class FastReader
+   {
+   public:
+      explicit FastReader(FILE* f) : file(f), buffer(QUIET_BUFFER), pos(0), len(0) {}
+      int peek()
+      {
+         if (pos == len)
+         {
+            len = fread(&buffer[0], 1, buffer.size(), file);
+            pos = 0;
+            if (len == 0)
+               return EOF;
+         }
+         return static_cast<unsigned char>(buffer[pos]);
+      }
+      int get()
+      {
+         int c = peek();
+         if (c != EOF)
+            ++pos;
+         return c;
+      }
+      void skip_blanks()
+      {
+         while (peek() != EOF && isspace(peek()))
+            ++pos;
+      }
+      // The next token as an int; false (the token is consumed) if it
+      // isn't one.
+      bool integer(int& value)
+      {
+         skip_blanks();
+         bool negative = peek() == '-';
+         if (negative || peek() == '+')
+            ++pos;
+         long long magnitude = 0;
+         int digits = 0;
+         while (peek() != EOF && isdigit(peek()))
+         {
+            magnitude = magnitude * 10 + (get() - '0');
+            if (magnitude > 1LL + INT_MAX)   // out of range already
+               magnitude = 2LL + INT_MAX;
+            ++digits;
+         }
+         bool ok = digits > 0 && (peek() == EOF || isspace(peek())) &&
+                   magnitude <= (negative ? 1LL + INT_MAX : INT_MAX);
+         while (peek() != EOF && !isspace(peek()))
+            ++pos;
+         value = int(negative ? -magnitude : magnitude);
+         return ok;
+      }
+      // The rest of the line after any blanks and newlines.
+      string line()
+      {
+         skip_blanks();
+         string text;
+         while (peek() != EOF && peek() != '\n')
+            text += char(get());
+         get();
+         if (!text.empty() && text[text.size() - 1] == '\r')
+            text.erase(text.size() - 1);
+         return text;
+      }
+
+   private:
+      FILE*        file;
+      vector<char> buffer;
+      size_t       pos, len;
+   };
+
+   // Output to a FILE*, written a buffer at a time.
+   class FastWriter
+   {
+   public:
+      explicit FastWriter(FILE* f) : file(f) { buffer.reserve(QUIET_BUFFER); }
+      ~FastWriter() { flush(); }
+      void put(char c)
+      {
+         buffer += c;
+         if (buffer.size() >= QUIET_BUFFER)
+            flush();
+      }
+      void put(const string& text)
+      {
+         buffer += text;
+         if (buffer.size() >= QUIET_BUFFER)
+            flush();
+      }
+      void put_int(long long value)
+      {
+         char digits[24];
+         int n = 0;
+         unsigned long long u = value < 0 ? 0ULL - (unsigned long long)value
+                                          : (unsigned long long)value;
+         do
+         {
+            digits[n++] = char('0' + u % 10);
+            u /= 10;
+         }
+         while (u != 0);
+         if (value < 0)
+            buffer += '-';
+         while (n > 0)
+            buffer += digits[--n];
+      }
+      void flush()
+      {
+         fwrite(buffer.data(), 1, buffer.size(), file);
+         buffer.clear();
+      }
+
+   private:
+      FILE*  file;
+      string buffer;
+   };
+
+   // The objects a hybrid # names (1, 12, 123, ...): digits 1-3,
+   // ascending, none twice.
+   bool hybrid_objects(int hybrid, vector<int>& objects)
+   {
+      const int valid[] = { 1, 2, 3, 12, 13, 23, 123 };
+      if (find(valid, valid + 7, hybrid) == valid + 7)
+         return false;
+      for (int rest = hybrid; rest > 0; rest /= 10)
+         objects.insert(objects.begin(), rest % 10);
+      return true;
+   }
+
+   // A failed named-set command's message.
+   void named_error(const string& message, bool compact, ostream& out)
+   {
+      out << (compact ? "error " : "") << message << endl;
+   }
+
+   // Read the ints left in in; false (and a message to out) if any
+   // of what is left isn't one, or if there is none.
+   bool read_values(istringstream& in, vector<int>& values, bool compact,
+                    ostream& out)
+   {
+      int value;
+      while (in >> value)
+         values.push_back(value);
+      if (!in.eof() || values.empty())
+      {
+         named_error("Bad or missing integer value(s)", compact, out);
+         return false;
+      }
+      return true;
+   }
+
+   // The set called name, or NULL (and a message to out).
+   IntSet* find_named(const string& name, bool compact, ostream& out)
+   {
+      IntSet* is = named_sets().find(name);
+      if (is == NULL)
+         named_error((named_sets().exists(name) ? "could not reload "
+                                                : "no set called ") + name,
+                     compact, out);
+      return is;
+   }
+
+   // For sorting runs fastest first.
+   bool faster(const CommandRun& lhs, const CommandRun& rhs)
+   {
+      return lhs.nanoseconds < rhs.nanoseconds;
+   }
+
+   // Latency (us) at fraction q of runs sorted by time.
+   double percentile_us(const vector<CommandRun>& runs, double q)
+   {
+      size_t at = size_t(q * double(runs.size() - 1) + 0.5);
+      return double(runs[at].nanoseconds) / 1e3;
+   }
+}
+
+void run_command(char choice, IntSet& is1, IntSet& is2, IntSet& is3,
+                 int argc)
+{
+   int objectNum,          // number specifying is1, is2 or is3
+       pairedNum,          // number specifying primary and secondary objects
+       hybridNum,          // number specifying which 1, 2 or 3 objects
+       givenValue;         // holder for a user supplied value
+   string expression;      // set expression over is1, is2 and is3
+   IntSetQuery query;      // its optimized plan
+
+   switch (choice)
+   {
+   case 'a': case 'A':
+      objectNum = get_object_num(argc);
+      givenValue = get_integer(argc);
+      switch (objectNum)
+      {
+      case 1:
+         cout << givenValue << (is1.add(givenValue) ? "" : " not") << " added to is1" << endl;
+         break;
+      case 2:
+         cout << givenValue << (is2.add(givenValue) ? "" : " not") << " added to is2" << endl;
+         break;
+      case 3:
+         cout << givenValue << (is3.add(givenValue) ? "" : " not") << " added to is3" << endl;
+      }
+      break;
+   case 'b': case 'B':
+      pairedNum = get_paired_num(argc);
+      switch (pairedNum)
+      {
+      case 11:
+         cout << "is1 is" << (is1.isSubsetOf(is1) ? "" : " not") << " subset of itself" << endl;
+         break;
+      case 12:
+         cout << "is1 is" << (is1.isSubsetOf(is2) ? "" : " not") << " subset of is2" << endl;
+         break;
+      case 13:
+         cout << "is1 is" << (is1.isSubsetOf(is3) ? "" : " not") << " subset of is3" << endl;
+         break;
+      case 21:
+         cout << "is2 is" << (is2.isSubsetOf(is1) ? "" : " not") << " subset of is1" << endl;
+         break;
+      case 22:
+         cout << "is2 is" << (is2.isSubsetOf(is2) ? "" : " not") << " subset of itself" << endl;
+         break;
+      case 23:
+         cout << "is2 is" << (is2.isSubsetOf(is3) ? "" : " not") << " subset of is3" << endl;
+         break;
+      case 31:
+         cout << "is3 is" << (is3.isSubsetOf(is1) ? "" : " not") << " subset of is1" << endl;
+         break;
+      case 32:
+         cout << "is3 is" << (is3.isSubsetOf(is2) ? "" : " not") << " subset of is2" << endl;
+         break;
+      case 33:
+         cout << "is3 is" << (is3.isSubsetOf(is3) ? "" : " not") << " subset of itself" << endl;
+      }
+      break;
+   case 'c': case 'C':
+      objectNum = get_object_num(argc);
+      givenValue = get_integer(argc);
+      switch (objectNum)
+      {
+      case 1:
+         cout << givenValue << " is" << (is1.contains(givenValue) ? "" : " not") << " in is1" << endl;
+         break;
+      case 2:
+         cout << givenValue << " is" << (is2.contains(givenValue) ? "" : " not") << " in is2" << endl;
+         break;
+      case 3:
+         cout << givenValue << " is" << (is3.contains(givenValue) ? "" : " not") << " in is3" << endl;
+      }
+      break;
+   case 'd': case 'D':
+      hybridNum = get_hybrid_num(argc);
+      /* Quiz: Why is the following block written in such
+               a weird-looking fashion? */
+      {
+         {
+            IntSet tccSet1 = is1;
+            IntSet tccSet2 = is2;
+            IntSet tccSet3 = is3;
+            tccSet1.reset();
+            tccSet2.reset();
+            tccSet3.reset();
+         }
+         {
+            IntSet taoSet1;
+            IntSet taoSet2;
+            IntSet taoSet3;
+            taoSet1 = is1;
+            taoSet2 = is2;
+            taoSet3 = is3;
+         }
+         switch (hybridNum)
+         {
+         case 1:
+            DumpDataAux(is1, 1, cout);
+            break;
+         case 2:
+            DumpDataAux(is2, 2, cout);
+            break;
+         case 3:
+            DumpDataAux(is3, 3, cout);
+            break;
+         case 12:
+            DumpDataAux(is1, 1, cout);
+            DumpDataAux(is2, 2, cout);
+            break;
+         case 13:
+            DumpDataAux(is1, 1, cout);
+            DumpDataAux(is3, 3, cout);
+            break;
+         case 23:
+            DumpDataAux(is2, 2, cout);
+            DumpDataAux(is3, 3, cout);
+            break;
+         case 123:
+            DumpDataAux(is1, 1, cout);
+            DumpDataAux(is2, 2, cout);
+            DumpDataAux(is3, 3, cout);
+         }
+      }
+      break;
+   case 'e': case 'E':
+      pairedNum = get_paired_num(argc);
+      switch (pairedNum)
+      {
+      case 11:
+         cout << ( (is1 == is1) ? "is1 is equal to itself"
+                                : "is1 is not equal to itself" ) << endl;
+         break;
+      case 12:
+         cout << ( (is1 == is2) ? "is1 is equal to is2"
+                                : "is1 is not equal to is2" ) << endl;
+         break;
+      case 13:
+         cout << ( (is1 == is3) ? "is1 is equal to is3"
+                                : "is1 is not equal to is3" ) << endl;
+         break;
+      case 21:
+         cout << ( (is2 == is1) ? "is2 is equal to is1"
+                                : "is2 is not equal to is1" ) << endl;
+         break;
+      case 22:
+         cout << ( (is2 == is2) ? "is2 is equal to itself"
+                                : "is2 is not equal to itself" ) << endl;
+         break;
+      case 23:
+         cout << ( (is2 == is3) ? "is2 is equal to is3"
+                                : "is2 is not equal to is3" ) << endl;
+         break;
+      case 31:
+         cout << ( (is3 == is1) ? "is3 is equal to is1"
+                                : "is3 is not equal to is1" ) << endl;
+         break;
+      case 32:
+         cout << ( (is3 == is2) ? "is3 is equal to is2"
+                                : "is3 is not equal to is2" ) << endl;
+         break;
+      case 33:
+         cout << ( (is3 == is3) ? "is3 is equal to itself"
+                                : "is3 is not equal to itself" ) << endl;
+      }
+      break;
+   case 'i': case 'I':
+      pairedNum = get_paired_num(argc);
+      switch (pairedNum)
+      {
+      case 11:
+         is1 = is1.intersect(is1);
+         cout << "is1 has been intersected with itself" << endl;
+         break;
+      case 12:
+         is1 = is1.intersect(is2);
+         cout << "is1 has been intersected with is2" << endl;
+         break;
+      case 13:
+         is1 = is1.intersect(is3);
+         cout << "is1 has been intersected with is3" << endl;
+         break;
+      case 21:
+         is2 = is2.intersect(is1);
+         cout << "is2 has been intersected with is1" << endl;
+         break;
+      case 22:
+         is2 = is2.intersect(is2);
+         cout << "is2 has been intersected with itself" << endl;
+         break;
+      case 23:
+         is2 = is2.intersect(is3);
+         cout << "is2 has been intersected with is3" << endl;
+         break;
+      case 31:
+         is3 = is3.intersect(is1);
+         cout << "is3 has been intersected with is1" << endl;
+         break;
+      case 32:
+         is3 = is3.intersect(is2);
+         cout << "is3 has been intersected with is2" << endl;
+         break;
+      case 33:
+         is3 = is3.intersect(is3);
+         cout << "is3 has been intersected with itself" << endl;
+      }
+      break;
+   case 'k': case 'K':
+      objectNum = get_object_num(argc);
+      givenValue = get_integer(argc);
+      switch (objectNum)
+      {
+      case 1:
+         cout << givenValue << (is1.remove(givenValue) ? " removed from" : " not found in") << " is1" << endl;
+         break;
+      case 2:
+         cout << givenValue << (is2.remove(givenValue) ? " removed from" : " not found in") << " is2" << endl;
+         break;
+      case 3:
+         cout << givenValue << (is3.remove(givenValue) ? " removed from" : " not found in") << " is3" << endl;
+      }
+      break;
+   case 'n': case 'N':
+      run_named_command(get_named_command(), cout);
+      break;
+   case 'm': case 'M':
+      hybridNum = get_hybrid_num(argc);
+      switch (hybridNum)
+      {
+      case 1:
+         cout << "   is1 is" << (is1.isEmpty() ? "" : " not") << " empty" << endl;
+         break;
+      case 2:
+         cout << "   is2 is" << (is2.isEmpty() ? "" : " not") << " empty" << endl;
+         break;
+      case 3:
+         cout << "   is3 is" << (is3.isEmpty() ? "" : " not") << " empty" << endl;
+         break;
+      case 12:
+         cout << "   is1 is" << (is1.isEmpty() ? "" : " not") << " empty" << endl;
+         cout << "   is2 is" << (is2.isEmpty() ? "" : " not") << " empty" << endl;
+         break;
+      case 13:
+         cout << "   is1 is" << (is1.isEmpty() ? "" : " not") << " empty" << endl;
+         cout << "   is3 is" << (is3.isEmpty() ? "" : " not") << " empty" << endl;
+         break;
+      case 23:
+         cout << "   is2 is" << (is2.isEmpty() ? "" : " not") << " empty" << endl;
+         cout << "   is3 is" << (is3.isEmpty() ? "" : " not") << " empty" << endl;
+         break;
+      case 123:
+         cout << "   is1 is" << (is1.isEmpty() ? "" : " not") << " empty" << endl;
+         cout << "   is2 is" << (is2.isEmpty() ? "" : " not") << " empty" << endl;
+         cout << "   is3 is" << (is3.isEmpty() ? "" : " not") << " empty" << endl;
+      }
+      break;
+   case 'r': case 'R':
+      hybridNum = get_hybrid_num(argc);
+      switch (hybridNum)
+      {
+      case 1:
+         ResetAux(is1, 1, cout);
+         break;
+      case 2:
+         ResetAux(is2, 2, cout);
+         break;
+      case 3:
+         ResetAux(is3, 3, cout);
+         break;
+      case 12:
+         ResetAux(is1, 1, cout);
+         ResetAux(is2, 2, cout);
+         break;
+      case 13:
+         ResetAux(is1, 1, cout);
+         ResetAux(is3, 3, cout);
+         break;
+      case 23:
+         ResetAux(is2, 2, cout);
+         ResetAux(is3, 3, cout);
+         break;
+      case 123:
+         ResetAux(is1, 1, cout);
+         ResetAux(is2, 2, cout);
+         ResetAux(is3, 3, cout);
+      }
+      break;
+   case 's': case 'S':
+      pairedNum = get_paired_num(argc);
+      switch (pairedNum)
+      {
+      case 11:
+         is1 = is1.subtract(is1);
+         cout << "is1 has been subtracted from itself" << endl;
+         break;
+      case 12:
+         is1 = is1.subtract(is2);
+         cout << "is2 has been subtracted from is1" << endl;
+         break;
+      case 13:
+         is1 = is1.subtract(is3);
+         cout << "is3 has been subtracted from is1" << endl;
+         break;
+      case 21:
+         is2 = is2.subtract(is1);
+         cout << "is1 has been subtracted from is2" << endl;
+         break;
+      case 22:
+         is2 = is2.subtract(is2);
+         cout << "is2 has been subtracted from itself" << endl;
+         break;
+      case 23:
+         is2 = is2.subtract(is3);
+         cout << "is3 has been subtracted from is2" << endl;
+         break;
+      case 31:
+         is3 = is3.subtract(is1);
+         cout << "is1 has been subtracted from is3" << endl;
+         break;
+      case 32:
+         is3 = is3.subtract(is2);
+         cout << "is2 has been subtracted from is3" << endl;
+         break;
+      case 33:
+         is3 = is3.subtract(is3);
+         cout << "is3 has been subtracted from itself" << endl;
+      }
+      break;
+   case 'u': case 'U':
+      pairedNum = get_paired_num(argc);
+      switch (pairedNum)
+      {
+      case 11:
+         is1 = is1.unionWith(is1);
+         cout << "is1 has been unioned with itself" << endl;
+         break;
+      case 12:
+         is1 = is1.unionWith(is2);
+         cout << "is1 has been unioned with is2" << endl;
+         break;
+      case 13:
+         is1 = is1.unionWith(is3);
+         cout << "is1 has been unioned with is3" << endl;
+         break;
+      case 21:
+         is2 = is2.unionWith(is1);
+         cout << "is2 has been unioned with is1" << endl;
+         break;
+      case 22:
+         is2 = is2.unionWith(is2);
+         cout << "is2 has been unioned with itself" << endl;
+         break;
+      case 23:
+         is2 = is2.unionWith(is3);
+         cout << "is2 has been unioned with is3" << endl;
+         break;
+      case 31:
+         is3 = is3.unionWith(is1);
+         cout << "is3 has been unioned with is1" << endl;
+         break;
+      case 32:
+         is3 = is3.unionWith(is2);
+         cout << "is3 has been unioned with is2" << endl;
+         break;
+      case 33:
+         is3 = is3.unionWith(is3);
+         cout << "is3 has been unioned with itself" << endl;
+      }
+      break;
+   case 'x': case 'X':
+      objectNum = get_object_num(argc);
+      expression = get_expression();
+      query.define("is1", is1);
+      query.define("is2", is2);
+      query.define("is3", is3);
+      if ( ! query.compile(expression) )
+      {
+         cout << "is" << objectNum << " unchanged: " << query.error() << endl;
+         break;
+      }
+      cout << "   plan: " << query.plan() << endl;
+      switch (objectNum)
+      {
+      case 1:
+         is1 = query.run();
+         break;
+      case 2:
+         is2 = query.run();
+         break;
+      case 3:
+         is3 = query.run();
+      }
+      cout << "is" << objectNum << " has been set to " << expression << endl;
+      break;
+   case 'z': case 'Z':
+      hybridNum = get_hybrid_num(argc);
+      switch (hybridNum)
+      {
+      case 1:
+         cout << "   is1 has " << is1.size() << " items" << endl;
+         break;
+      case 2:
+         cout << "   is2 has " << is2.size() << " items" << endl;
+         break;
+      case 3:
+         cout << "   is3 has " << is3.size() << " items" << endl;
+         break;
+      case 12:
+         cout << "   is1 has " << is1.size() << " items" << endl;
+         cout << "   is2 has " << is2.size() << " items" << endl;
+         break;
+      case 13:
+         cout << "   is1 has " << is1.size() << " items" << endl;
+         cout << "   is3 has " << is3.size() << " items" << endl;
+         break;
+      case 23:
+         cout << "   is2 has " << is2.size() << " items" << endl;
+         cout << "   is3 has " << is3.size() << " items" << endl;
+         break;
+      case 123:
+         cout << "   is1 has " << is1.size() << " items" << endl;
+         cout << "   is2 has " << is2.size() << " items" << endl;
+         cout << "   is3 has " << is3.size() << " items" << endl;
+      }
+      break;
+   case 'q': case 'Q':
+      cout << "Quit option selected...bye" << endl;
+      break;
+   default:
+      cout << choice << " is not a valid option...try again"
+           << endl;
+   }
+}
+
+void print_menu()
+{
+   cout << endl;
+   cout << "The following choices are available: " << endl;
+   cout << "  a  Add an item to is1, is2 or is3" << endl;
+   cout << "  b  Query if 1 of is1, is2 or is3 is subset of is1, is2 or is3" << endl;
+   cout << "  c  Query if an item is in is1, is2 or is3" << endl;
+   cout << "  d  Display 1 or more of is1, is2 and is3 (to stdout)" << endl;
+   cout << "  e  Query if 1 of is1, is2 or is3 is equal to is1, is2 or is3" << endl;
+   cout << "  i  Intersect 1 of is1, is2 or is3 with is1, is2 or is3" << endl;
+   cout << "  k  Remove an item from is1, is2 or is3" << endl;
+   cout << "  m  Query if 1 or more of is1, is2 and is3 is/are empty" << endl;
+   cout << "  n  Named-set command (create, drop, list, add, remove, contains," << endl;
+   cout << "     size, show, set NAME = EXPR, limit)" << endl;
+   cout << "  r  Reset (make empty) 1 or more of is1, is2 and is3" << endl;
+   cout << "  s  Subtract 1 of is1, is2 or is3 from is1, is2 or is3" << endl;
+   cout << "  u  Union 1 of is1, is2 or is3 with is1, is2 or is3" << endl;
+   cout << "  x  Set is1, is2 or is3 to an expression over is1, is2 and is3" << endl;
+   cout << "  z  Query # of items in 1 or more of is1, is2 and is3" << endl;
+   cout << "  q  Quit this test program" << endl;
+}
+
+char get_user_command()
+{
+   char command;
+
+   cout << "Enter choice: ";
+   cin >> command;
+
+   cout << command << " read." << endl;
+   return command;
+}
+
+int get_object_num(int argc)
+{
+   int result;
+
+   cout << "Enter object # (1 = is1, 2 = is2, 3 = is3) ";
+   cin  >> result;
+   while ( ! cin.good() )
+   {
+      cerr << "Bad integer input..." << endl;
+      cin.clear();
+      cin.ignore(999, '\n');
+      cout << "Re-enter object # (1 = is1, 2 = is2, 3 = is3) ";
+      cin  >> result;
+   }
+   if (argc < 2)
+      cin.ignore(999, '\n');
+
+   while (result != 1 && result != 2 && result != 3)
+   {
+      cerr << "Bad object # (must be 1, 2 or 3)..." << endl;
+      cout << "Re-enter object # (1 = is1, 2 = is2, 3 = is3) ";
+      cin  >> result;
+      while ( ! cin.good() )
+      {
+         cerr << "Bad integer input..." << endl;
+         cin.clear();
+         cin.ignore(999, '\n');
+         cout << "Re-enter object # (1 = is1, 2 = is2, 3 = is3) ";
+         cin  >> result;
+      }
+      cin.ignore(999, '\n');
+   }
+
+   cout << result << " read." << endl;
+   return result;
+}
+
+int get_paired_num(int argc)
+{
+   int result;
+
+   cout << "Enter object_pair # (12 for is1.OP(is2), 32 for is3.OP(is2),...) ";
+   cin  >> result;
+   while ( ! cin.good() )
+   {
+      cerr << "Bad integer input..." << endl;
+      cin.clear();
+      cin.ignore(999, '\n');
+      cout << "Re-enter object_pair # (12 for is1.OP(is2), 32 for is3.OP(is2),...) ";
+      cin  >> result;
+   }
+   if (argc < 2)
+      cin.ignore(999, '\n');
+
+   while (result != 11 && result != 12 && result != 13 &&
+          result != 21 && result != 22 && result != 23 &&
+          result != 31 && result != 32 && result != 33)
+   {
+      cerr << "Bad object_pair # (must be 11, 12, 13, 21, 22, 23, 31, 32 or 33)..." << endl;
+      cout << "Re-enter object_pair # (12 for is1.OP(is2), 32 for is3.OP(is2),...) ";
+      cin  >> result;
+      while ( ! cin.good() )
+      {
+         cerr << "Bad integer input..." << endl;
+         cin.clear();
+         cin.ignore(999, '\n');
+         cout << "Re-enter object_pair # (12 for is1.OP(is2), 32 for is3.OP(is2),...) ";
+         cin  >> result;
+      }
+      cin.ignore(999, '\n');
+   }
+
+   cout << result << " read." << endl;
+   return result;
+}
+
+int get_hybrid_num(int argc)
+{
+   int result;
+
+   cout << "Enter hybrid # (1 for is1, 23 for is2 and is3, 123 for is1, is2 and is3,...) ";
+   cin  >> result;
+   while ( ! cin.good() )
+   {
+      cerr << "Bad integer input..." << endl;
+      cin.clear();
+      cin.ignore(999, '\n');
+      cout << "Re-enter hybrid # (1 for is1, 23 for is2 and is3, 123 for is1, is2 and is3,...) ";
+      cin  >> result;
+   }
+   if (argc < 2)
+      cin.ignore(999, '\n');
+
+   while (result != 1 && result != 2 && result != 3 &&
+          result != 12 && result != 13 && result != 23 &&
+          result != 123)
+   {
+      cerr << "Bad object_pair # (must be 1, 2, 3, 12, 13, 23 or 123)..." << endl;
+      cout << "Re-enter hybrid # (1 for is1, 23 for is2 and is3, 123 for is1, is2 and is3,...) ";
+      cin  >> result;
+      while ( ! cin.good() )
+      {
+         cerr << "Bad integer input..." << endl;
+         cin.clear();
+         cin.ignore(999, '\n');
+         cout << "Re-enter hybrid # (1 for is1, 23 for is2 and is3, 123 for is1, is2 and is3,...) ";
+         cin  >> result;
+      }
+      cin.ignore(999, '\n');
+   }
+
+   cout << result << " read." << endl;
+   return result;
+}
+
+int get_integer(int argc)
+{
+   int result;
+
+   cout << "Enter integer value ";
+   cin  >> result;
+   while ( ! cin.good() )
+   {
+      cerr << "Bad integer input..." << endl;
+      cin.clear();
+      cin.ignore(999, '\n');
+      cout << "Re-enter integer value ";
+      cin  >> result;
+   }
+   if (argc < 2)
+      cin.ignore(999, '\n');
+
+   cout << result << " read." << endl;
+   return result;
+}
+
+string get_expression()
+{
+   string result;
+
+   cout << "Enter set expression (e.g. (is1 | is2) & ~is3) ";
+   cin >> ws;
+   getline(cin, result);
+
+   cout << result << " read." << endl;
+   return result;
+}
+
+string get_named_command()
+{
+   string result;
+
+   cout << "Enter named-set command ";
+   cin >> ws;
+   getline(cin, result);
+
+   cout << result << " read." << endl;
+   return result;
+}
+
+void DumpDataAux(IntSet is, int objNum, ostream& out)
+{
+   if ( is.isEmpty() )
+      out << "   is" << objNum << ": (empty)" << endl;
+   else
+   {
+      out << "   is" << objNum << ": ";
+      is.DumpData(out);
+      out << endl;
+   }
+}
+
+void ResetAux(IntSet& is, int objNum, ostream& out)
+{
+   is.reset();
+   out << "   is" << objNum << " has been reset and is now empty" << endl;
+}
+
+void run_quiet_batch(IntSet& is1, IntSet& is2, IntSet& is3,
+                     FILE* in, FILE* out)
+{
+   IntSet* const sets[4] = { NULL, &is1, &is2, &is3 };
+   FastReader reader(in);
+   FastWriter writer(out);
+
+   for (;;)
+   {
+      // One character, as with cin >> choice.
+      reader.skip_blanks();
+      int letter = reader.get();
+      if (letter == EOF)
+         break;
+      char choice = char(tolower(letter));
+      if (choice == 'q')
+         break;
+      // Read all the arguments before checking any, so a bad one
+      // doesn't leave the rest to be taken for commands.
+      int first = 0, second = 0;
+      vector<int> objects;
+      bool ok = true;
+      if (strchr("abcdeikmrsuxz", choice) != NULL)
+         ok = reader.integer(first);
+      if (strchr("ack", choice) != NULL)
+         ok = reader.integer(second) && ok;
+      switch (choice)
+      {
+      case 'a': case 'c': case 'k': case 'x':
+         ok = ok && first >= 1 && first <= 3;
+         break;
+      case 'b': case 'e': case 'i': case 's': case 'u':
+         ok = ok && first / 10 >= 1 && first / 10 <= 3 &&
+              first % 10 >= 1 && first % 10 <= 3;
+         break;
+      case 'd': case 'm': case 'r': case 'z':
+         ok = ok && hybrid_objects(first, objects);
+         break;
+      }
+      if (!ok && choice == 'x')
+         reader.line();
+      if (!ok)
+      {
+         writer.put("error bad argument\n");
+         continue;
+      }
+
+      switch (choice)
+      {
+      case 'a':
+         writer.put(sets[first]->add(second) ? '1' : '0');
+         break;
+      case 'c':
+         writer.put(sets[first]->contains(second) ? '1' : '0');
+         break;
+      case 'k':
+         writer.put(sets[first]->remove(second) ? '1' : '0');
+         break;
+      case 'b':
+         writer.put(sets[first / 10]->isSubsetOf(*sets[first % 10]) ? '1' : '0');
+         break;
+      case 'e':
+         writer.put(*sets[first / 10] == *sets[first % 10] ? '1' : '0');
+         break;
+      case 'i': case 's': case 'u':
+         {
+            IntSet& target = *sets[first / 10];
+            const IntSet& other = *sets[first % 10];
+            target = choice == 'i' ? target.intersect(other)
+                   : choice == 's' ? target.subtract(other)
+                                   : target.unionWith(other);
+            writer.put_int(target.size());
+         }
+         break;
+      case 'd':
+         for (size_t o = 0; o < objects.size(); ++o)
+         {
+            const IntSet& is = *sets[objects[o]];
+            const int* members = IntSetExprAccess::members(is);
+            if (o > 0)
+               writer.put(';');
+            for (size_t k = 0; k < is.size(); ++k)
+            {
+               if (k > 0)
+                  writer.put(' ');
+               writer.put_int(members[k]);
+            }
+         }
+         break;
+      case 'm': case 'z':
+         for (size_t o = 0; o < objects.size(); ++o)
+         {
+            if (o > 0)
+               writer.put(' ');
+            if (choice == 'm')
+               writer.put(sets[objects[o]]->isEmpty() ? '1' : '0');
+            else
+               writer.put_int(sets[objects[o]]->size());
+         }
+         break;
+      case 'r':
+         for (size_t o = 0; o < objects.size(); ++o)
+            sets[objects[o]]->reset();
+         writer.put("ok");
+         break;
+      case 'x':
+         {
+            string expression = reader.line();
+            IntSetQuery query;
+            query.define("is1", is1);
+            query.define("is2", is2);
+            query.define("is3", is3);
+            if (query.compile(expression))
+            {
+               *sets[first] = query.run();
+               writer.put_int(sets[first]->size());
+            }
+            else
+               writer.put("error " + query.error());
+         }
+         break;
+      case 'n':
+         {
+            ostringstream response;
+            run_named_command(reader.line(), response, true);
+            string text = response.str();
+            writer.put(text.substr(0, text.size() - 1));
+         }
+         break;
+      default:
+         writer.put("error unknown command ");
+         writer.put(char(letter));
+      }
+      writer.put('\n');
+   }
+}
+
+void configure_named_sets(size_t memory_limit, const string& spill_dir)
+{
+   registry.reset(new IntSetRegistry(memory_limit, spill_dir));
+}
+
+IntSetRegistry& named_sets()
+{
+   if (!registry)
+      registry.reset(new IntSetRegistry);
+   return *registry;
+}
+
+void run_named_command(const string& line, ostream& out, bool compact)
+{
+   istringstream in(line);
+   string verb, name;
+   in >> verb;
+   IntSetRegistry& sets = named_sets();
+   const char* separator = "";   // between compact results
+
+   if (verb == "create" || verb == "drop")
+   {
+      bool any = false;
+      while (in >> name)
+      {
+         any = true;
+         bool done = verb == "create" ? sets.create(name) : sets.drop(name);
+         if (compact)
+            out << separator << (done ? '1' : '0');
+         else if (verb == "create")
+            out << name << (done ? " created"
+                            : IntSetRegistry::validName(name)
+                              ? " already exists" : " is not a valid name")
+                << endl;
+         else
+            out << name << (done ? " dropped" : " not found") << endl;
+         separator = " ";
+      }
+      if (!any)
+         named_error("Missing set name", compact, out);
+      else if (compact)
+         out << endl;
+   }
+   else if (verb == "list")
+   {
+      vector<string> names = sets.names();
+      for (size_t i = 0; i < names.size(); ++i)
+      {
+         bool resident = sets.isResident(names[i]);
+         if (compact)
+            out << (i > 0 ? " " : "") << names[i] << ':'
+                << sets.sizeOf(names[i]) << (resident ? "" : "*");
+         else
+            out << "   " << names[i] << ": " << sets.sizeOf(names[i])
+                << " items" << (resident ? "" : " (on disk)") << endl;
+      }
+      if (compact)
+         out << endl;
+      else
+         out << names.size() << " sets, " << sets.residentBytes()
+             << " bytes in memory" << endl;
+   }
+   else if (verb == "add" || verb == "remove" || verb == "contains")
+   {
+      vector<int> values;
+      IntSet* is = NULL;
+      if (!(in >> name))
+         named_error("Missing set name", compact, out);
+      else if (read_values(in, values, compact, out))
+         is = find_named(name, compact, out);
+      for (size_t i = 0; is != NULL && i < values.size(); ++i)
+      {
+         bool done = verb == "add" ? is->add(values[i])
+                   : verb == "remove" ? is->remove(values[i])
+                                      : is->contains(values[i]);
+         if (compact)
+            out << (i > 0 ? " " : "") << (done ? '1' : '0');
+         else if (verb == "add")
+            out << values[i] << (done ? "" : " not") << " added to "
+                << name << endl;
+         else if (verb == "remove")
+            out << values[i] << (done ? " removed from" : " not found in")
+                << " " << name << endl;
+         else
+            out << values[i] << " is" << (done ? "" : " not") << " in "
+                << name << endl;
+      }
+      if (is != NULL && compact)
+         out << endl;
+   }
+   else if (verb == "size" || verb == "show")
+   {
+      IntSet* is;
+      if (!(in >> name))
+         named_error("Missing set name", compact, out);
+      else if (verb == "size")
+      {
+         ptrdiff_t size = sets.sizeOf(name);
+         if (size < 0)
+            named_error("no set called " + name, compact, out);
+         else if (compact)
+            out << size << endl;
+         else
+            out << "   " << name << " has " << size << " items" << endl;
+      }
+      else if ((is = find_named(name, compact, out)) != NULL)
+      {
+         if (!compact)
+            out << "   " << name << ": " << (is->isEmpty() ? "(empty)" : "");
+         const int* members = IntSetExprAccess::members(*is);
+         for (size_t k = 0; k < is->size(); ++k)
+            out << (k == 0 ? "" : compact ? " " : "  ") << members[k];
+         out << endl;
+      }
+   }
+   else if (verb == "set")
+   {
+      string equals, expression;
+      in >> name >> equals >> ws;
+      getline(in, expression);
+      IntSetQuery query;
+      // Reload every set the expression names before compiling it,
+      // so the plan's size estimates are current.
+      bool found = IntSetRegistry::validName(name) && equals == "=";
+      if (!found)
+         named_error("Usage: set NAME = EXPR", compact, out);
+      for (size_t i = 0; found && i < expression.size(); )
+      {
+         size_t end = i;
+         while (end < expression.size() &&
+                (isalnum(static_cast<unsigned char>(expression[end])) ||
+                 expression[end] == '_'))
+            ++end;
+         if (end == i)
+         {
+            ++i;
+            continue;
+         }
+         string operand = expression.substr(i, end - i);
+         if (IntSetRegistry::validName(operand))
+         {
+            IntSet* is = find_named(operand, compact, out);
+            if (is == NULL)
+               found = false;
+            else
+               query.define(operand, *is);
+         }
+         i = end;
+      }
+      if (found && !query.compile(expression))
+         named_error(name + " unchanged: " + query.error(), compact, out);
+      else if (found)
+      {
+         // A spilled target that can't be reloaded is reported, and
+         // the query isn't run.
+         sets.create(name);
+         IntSet* target = find_named(name, compact, out);
+         if (target != NULL)
+         {
+            if (!compact)
+               out << "   plan: " << query.plan() << endl;
+            *target = query.run();
+            if (compact)
+               out << target->size() << endl;
+            else
+               out << name << " has been set to " << expression << endl;
+         }
+      }
+   }
+   else if (verb == "limit")
+   {
+      unsigned long long bytes;
+      bool bad = false;
+      if (in >> bytes)
+         sets.setMemoryLimit(size_t(bytes));
+      else
+         bad = !in.eof();
+      if (bad)
+         named_error("Bad byte count (limit unchanged)", compact, out);
+      else if (compact)
+         out << sets.memoryLimit() << ' ' << sets.evictions() << ' '
+             << sets.reloads() << endl;
+      if (!compact)
+      {
+         out << "memory limit: ";
+         if (sets.memoryLimit() == 0)
+            out << "none";
+         else
+            out << sets.memoryLimit() << " bytes";
+         out << " (" << sets.evictions() << " spilled, " << sets.reloads()
+             << " reloaded so far)" << endl;
+      }
+   }
+   else
+      named_error((verb.empty() ? "(nothing)" : verb) +
+                  " is not a valid named-set command", compact, out);
+
+   sets.trim();
+}
+
+bool serve_named_sets(const string& path, int num_workers)
+{
+   IntSetServer service([](const string& line) -> string
+                        {
+                           ostringstream out;
+                           {
+                              lock_guard<mutex> guard(registry_lock);
+                              run_named_command(line, out, true);
+                           }
+                           string response = out.str();
+                           response.erase(response.size() - 1);
+                           return response;
+                        }, num_workers);
+   if (!service.listen(path))
+   {
+      cerr << "Cannot serve: " << service.error() << endl;
+      return false;
+   }
+   cerr << "Serving named sets on " << path << " (" << max(num_workers, 0)
+        << " workers); SIGINT or SIGTERM stops." << endl;
+
+   server = &service;
+   signal(SIGINT, stop_serving);
+   signal(SIGTERM, stop_serving);
+   bool ok = service.run();
+   signal(SIGINT, SIG_DFL);
+   signal(SIGTERM, SIG_DFL);
+   server = NULL;
+
+   if (!ok)
+      cerr << "Stopped serving: " << service.error() << endl;
+   else
+      cerr << "Stopped serving after " << service.requestsServed()
+           << " requests." << endl;
+   return ok;
+}
+
+
+void record_command(char choice, long long nanoseconds,
+                    size_t size1, size_t size2, size_t size3)
+{
+   CommandRun run = { nanoseconds, { size1, size2, size3 } };
+   profile[choice].push_back(run);
+}
+
+void print_command_profile(ostream& out)
+{
+   // Order the commands by the time they took altogether.
+   vector< pair<long long, char> > order;
+   for (map<char, vector<CommandRun> >::iterator it = profile.begin();
+        it != profile.end(); ++it)
+   {
+      long long total = 0;
+      for (size_t i = 0; i < it->second.size(); ++i)
+         total += it->second[i].nanoseconds;
+      order.push_back(make_pair(-total, it->first));
+   }
+   sort(order.begin(), order.end());
+
+   out << "cmd" << right << setw(9) << "count" << setw(12) << "total_ms"
+       << setw(11) << "p50_us" << setw(11) << "p99_us" << setw(11)
+       << "p999_us" << setw(11) << "max_us" << setw(9) << "is1"
+       << setw(9) << "is2" << setw(9) << "is3" << endl;
+   for (size_t k = 0; k < order.size(); ++k)
+   {
+      vector<CommandRun>& runs = profile[order[k].second];
+      sort(runs.begin(), runs.end(), faster);
+      double sizes[3] = { 0, 0, 0 };
+      for (size_t i = 0; i < runs.size(); ++i)
+         for (int s = 0; s < 3; ++s)
+            sizes[s] += runs[i].sizes[s];
+
+      out << left << setw(3) << order[k].second << right
+          << setw(9) << runs.size() << fixed
+          << setprecision(3) << setw(12) << double(-order[k].first) / 1e6
+          << setprecision(2)
+          << setw(11) << percentile_us(runs, 0.50)
+          << setw(11) << percentile_us(runs, 0.99)
+          << setw(11) << percentile_us(runs, 0.999)
+          << setw(11) << double(runs.back().nanoseconds) / 1e3
+          << setprecision(1);
+      for (int s = 0; s < 3; ++s)
+         out << setw(9) << sizes[s] / double(runs.size());
+      out << endl;
+   }
+}
+
@@ -0,0 +1,163 @@
+// FILE: Driver.h
+//       Command dispatch and input helpers for the interactive IntSet
+//       test program (Assign02.cpp); kept apart from main so that
+//       other programs (e.g. the replay benchmark) can drive the very
+//       same commands.
+//       Everything reads from cin and writes to cout/cerr.
+
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include "IntSet.h"
+#include "IntSetRegistry.h"
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+void print_menu();
+// Pre:  (none)
+// Post: A menu of choices for this program is written to cout.
+
+char get_user_command();
+// Pre:  (none)
+// Post: The user is prompted to enter a one character command.
+//       The next character is read (skipping blanks and newline
+//       characters), and this character is returned.
+
+int get_object_num(int argc);
+int get_paired_num(int argc);
+int get_hybrid_num(int argc);
+int get_integer(int argc);
+// Pre:  (none)
+// Post: The user is prompted to enter an integer. The prompt
+//       is repeated until a valid integer can be read. The
+//       valid integer read is returned. The input buffer is
+//       cleared of any extra input until and including the
+//       first newline character.
+
+std::string get_expression();
+// Pre:  (none)
+// Post: The user is prompted to enter a set expression (see
+//       IntSetQuery.h). The rest of the line (after any leading
+//       blanks and newlines) is read and returned, and the input
+//       buffer is cleared of it and of its newline character.
+
+std::string get_named_command();
+// Pre:  (none)
+// Post: The user is prompted to enter a named-set command (see
+//       run_named_command), which is read and returned the way
+//       get_expression reads an expression.
+
+void DumpDataAux(IntSet is, int objNum, std::ostream& out);
+// Pre:  (none)
+// Post: Contents of is has been inserted into out following
+//       some custom format.
+/* Quiz: Why is is not passed by const reference? */
+
+void ResetAux(IntSet& is, int objNum, std::ostream& out);
+// Pre:  (none)
+// Post: is has called reset() and a message inserted into out.
+
+void run_command(char choice, IntSet& is1, IntSet& is2, IntSet& is3,
+                 int argc);
+// Pre:  argc is main's argc (>= 2 means "batch mode": commands come
+//       from redirected input and are not followed by newlines to
+//       skip).
+// Post: The command choice (as entered at the "Enter choice: "
+//       prompt) has read its arguments, been carried out on is1, is2
+//       and is3, and had its outcome written to cout. An unknown
+//       choice is reported as such; 'q'/'Q' only prints the goodbye.
+
+void run_quiet_batch(IntSet& is1, IntSet& is2, IntSet& is3,
+                     std::FILE* in, std::FILE* out);
+// Pre:  (none)
+// Post: Commands in the batch-mode input format (a command letter,
+//       then its arguments, separated by blanks or newlines; the
+//       expression of x and the command of n take the rest of their
+//       line) have been read from in until q or the end of input and
+//       carried out on is1, is2 and is3, with no prompts or echoes.
+//       Each command has written exactly one response line to out:
+//         a, b, c, e, k   1 or 0 (added, subset, contains, equal,
+//                         removed)
+//         i, s, u, x      the new size of the set changed
+//         m, z            per object named: 1/0 (empty), or its size,
+//                         separated by blanks
+//         d               per object named: its members separated by
+//                         blanks; objects separated by ';'
+//         r               ok
+//         n               run_named_command's compact response
+//       A command whose arguments are bad, or an unknown command,
+//       gets "error" and a reason instead (the offending token is
+//       skipped). q writes nothing.
+//       Input is read and output written through large buffers (out is
+//       only flushed at the end), so throughput is bound by the
+//       IntSet operations rather than by stream I/O.
+
+void configure_named_sets(size_t memory_limit, const std::string& spill_dir);
+// Pre:  spill_dir exists and is writable.
+// Post: The named sets (see run_named_command) are kept in a new,
+//       empty IntSetRegistry with the given memory limit (0 = none)
+//       and spill directory; any previous named sets are gone.
+//       Until this is called, named sets have no memory limit.
+
+IntSetRegistry& named_sets();
+// Pre:  (none)
+// Post: The registry holding the named sets is returned.
+
+void run_named_command(const std::string& line, std::ostream& out,
+                       bool compact = false);
+// Pre:  (none)
+// Post: line, a command on the named sets, has been carried out and
+//       its outcome written to out; then the registry has been
+//       trimmed to its memory limit. Commands (NAME is a set name, V
+//       an int, EXPR an IntSetQuery expression over set names), with
+//       their compact responses:
+//         create NAME...      make empty sets         1/0 per name
+//         drop NAME...        delete sets             1/0 per name
+//         list                every set with its      NAME:SIZE per set,
+//                             size and whether it is  * marking those
+//                             in memory or on disk    on disk
+//         add NAME V...       add values to a set     1/0 per value
+//         remove NAME V...    remove values           1/0 per value
+//         contains NAME V...  query values            1/0 per value
+//         size NAME           # of items in a set     the size
+//         show NAME           display a set           the members
+//         set NAME = EXPR     set a set (created if   its new size
+//                             need be) to EXPR
+//         limit [BYTES]       show or change the      limit, # spilled,
+//                             memory limit            # reloaded
+//       Normally the outcome is written as sentences, one line per
+//       result. If compact, it is written as exactly one line, the
+//       compact response with items separated by blanks. An unknown
+//       command or a missing/bad argument is reported as such
+//       (compact: a line starting with "error "), and nothing is
+//       changed.
+
+bool serve_named_sets(const std::string& path, int num_workers);
+// Pre:  (none)
+// Post: The named sets have been served on the Unix domain socket
+//       path (see IntSetServer.h) until SIGINT or SIGTERM: each
+//       request line is a run_named_command command, and its response
+//       line the command's compact response. Requests from any number
+//       of clients run on num_workers worker threads (on the calling
+//       thread if num_workers <= 0), one command at a time on the
+//       registry. True is returned once serving stopped on a signal;
+//       false (after a message to cerr) if it could not start or
+//       failed.
+
+void record_command(char choice, long long nanoseconds,
+                    size_t size1, size_t size2, size_t size3);
+// Pre:  size1, size2 and size3 are the sizes is1, is2 and is3 had
+//       when choice was dispatched.
+// Post: One run of choice that took nanoseconds has been added to the
+//       command profile (kept for the life of the program).
+
+void print_command_profile(std::ostream& out);
+// Pre:  (none)
+// Post: For every command in the profile, its count, total time,
+//       p50/p99/p999 and maximum latency, and the average sizes of
+//       is1, is2 and is3 when it was dispatched have been written to
+//       out, busiest command (by total time) first.
+
+#endif
@@ -0,0 +1,209 @@
+// FILE: HugeSetCheck.cpp
+//       Check that IntSet works past 2^31 members: builds a dense set
+//       of N consecutive ints (N = 2^31 + 1 by default, which no
+//       int-sized count or capacity can hold) and checks size,
+//       lookups, remove, DumpData and the set algebra on it against
+//       what they must give. CTest runs it when the build is
+//       configured with -DINTSET_HUGE_TESTS=ON.
+//
+// USAGE: intset_huge_check [--size=N]
+//   --size:  # of members of the huge set (default 2^31 + 1; at most
+//            2^32 - 2). Smaller sizes check the same things quickly.
+//
+// MEMORY: a presized set of N members takes 4N bytes of members plus
+// an index of 2N ints rounded up to a power of 2: about 40 GB at the
+// default size. The union check holds two such sets at once, so the
+// default run needs about 80 GB (and some minutes).
+//
+// Exit status is 0 if every check passed, otherwise 1.
+
+#include "IntSet.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+using namespace std;
+
+namespace
+{
+    // Member i of the huge set: i as a 32-bit pattern, so past 2^31
+    // the members carry on from INT_MIN upwards.
+    int member(uint64_t i)
+    {
+        return int(int32_t(uint32_t(i)));
+    }
+
+    // Counts what DumpData writes instead of keeping it: the bytes, and
+    // the items (DumpData separates them with 2 spaces, and no member
+    // has a space in it).
+    class CountingBuf : public streambuf
+    {
+    public:
+        CountingBuf() : bytes(0), spaces(0) {}
+        uint64_t items() const { return bytes == 0 ? 0 : spaces / 2 + 1; }
+        uint64_t bytes;
+        uint64_t spaces;
+
+    protected:
+        int overflow(int c)
+        {
+            if (c != EOF) {
+                ++bytes;
+                spaces += c == ' ';
+            }
+            return c;
+        }
+        streamsize xsputn(const char* s, streamsize n)
+        {
+            for (streamsize k = 0; k < n; ++k)
+                spaces += s[k] == ' ';
+            bytes += uint64_t(n);
+            return n;
+        }
+    };
+
+    // Bytes DumpData writes for members 0 through n - 1.
+    uint64_t dumpBytes(uint64_t n)
+    {
+        uint64_t bytes = n == 0 ? 0 : 2 * (n - 1);
+        for (uint64_t i = 0; i < n; ++i) {
+            long long value = member(i);
+            bytes += value < 0;
+            for (unsigned long long u = value < 0 ? -value : value;
+                 ; u /= 10) {
+                ++bytes;
+                if (u < 10)
+                    break;
+            }
+        }
+        return bytes;
+    }
+
+    bool failed = false;
+
+    void check(bool ok, const string& what)
+    {
+        cout << (ok ? "  ok    " : "  FAIL  ") << what << endl;
+        failed |= !ok;
+    }
+
+    double secondsSince(chrono::steady_clock::time_point start)
+    {
+        return chrono::duration<double>(
+            chrono::steady_clock::now() - start).count();
+    }
+
+    bool parseOption(const char* arg, const char* flag, string& value)
+    {
+        size_t len = strlen(flag);
+        if (strncmp(arg, flag, len) != 0 || arg[len] != '=')
+            return false;
+        value = arg + len + 1;
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    uint64_t n = (uint64_t(1) << 31) + 1;
+    for (int a = 1; a < argc; ++a) {
+        string value;
+        if (parseOption(argv[a], "--size", value)) {
+            n = strtoull(value.c_str(), NULL, 10);
+        } else {
+            cerr << "Unknown option " << argv[a] << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    // Leave two ints that aren't members, for the algebra checks.
+    if (n < 4 || n > (uint64_t(1) << 32) - 2 || n > IntSet::MAX_CAPACITY) {
+        cerr << "--size must be from 4 to "
+             << ((uint64_t(1) << 32) - 2 < IntSet::MAX_CAPACITY
+                 ? (uint64_t(1) << 32) - 2 : uint64_t(IntSet::MAX_CAPACITY))
+             << endl;
+        return EXIT_FAILURE;
+    }
+    size_t size = size_t(n);
+
+    try {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        IntSet huge(size);
+        for (size_t i = 0; i < size; ++i)
+            huge.add(member(i));
+        cout << "built " << size << " members in " << secondsSince(start)
+             << " s (" << huge.memoryUsage() / (1 << 20) << " MB)" << endl;
+
+        check(huge.size() == size, "size");
+        check(huge.capacity() == size, "capacity (presized)");
+        check(huge.contains(member(0)) && huge.contains(member(size / 2)) &&
+              huge.contains(member(size - 1)), "contains members");
+        check(!huge.contains(member(size)) &&
+              !huge.contains(member(size + 1)), "contains non-members");
+        check(!huge.add(member(size - 1)), "add of a member");
+
+        // Removing the first member shifts all the others down.
+        start = chrono::steady_clock::now();
+        check(huge.remove(member(0)) && huge.size() == size - 1 &&
+              !huge.contains(member(0)) && huge.contains(member(size - 1)),
+              "remove");
+        check(!huge.remove(member(0)), "remove of a non-member");
+        check(huge.add(member(0)) && huge.size() == size &&
+              huge.contains(member(0)), "add back");
+        cout << "remove and add back took " << secondsSince(start) << " s"
+             << endl;
+
+        start = chrono::steady_clock::now();
+        CountingBuf counter;
+        ostream dump(&counter);
+        huge.DumpData(dump);
+        check(counter.items() == size && counter.bytes == dumpBytes(size),
+              "DumpData");
+        cout << "DumpData took " << secondsSince(start) << " s" << endl;
+
+        // Algebra with a small set that straddles the end of the huge
+        // one: 3 members in common, 2 not.
+        IntSet small;
+        small.add(member(size));
+        small.add(member(0));
+        small.add(member(size - 1));
+        small.add(member(size + 1));
+        small.add(member(size / 2));
+        check(small.intersect(huge).size() == 3 &&
+              huge.intersect(small).size() == 3, "intersect");
+        IntSet outside = small.subtract(huge);
+        check(outside.size() == 2 && outside.contains(member(size)) &&
+              outside.contains(member(size + 1)), "subtract (small - huge)");
+        check(!small.isSubsetOf(huge) && !huge.isSubsetOf(small),
+              "isSubsetOf");
+        check(outside.subtract(huge) == outside, "operator==");
+
+        start = chrono::steady_clock::now();
+        {
+            IntSet grown = huge.unionWith(small);
+            check(grown.size() == size + 2 && grown.contains(member(size)) &&
+                  grown.contains(member(size + 1)) &&
+                  grown.contains(member(size / 3)), "unionWith");
+            check(huge.isSubsetOf(grown), "isSubsetOf (huge of union)");
+        }
+        {
+            IntSet trimmed = huge.subtract(small);
+            check(trimmed.size() == size - 3 && !trimmed.contains(member(0)) &&
+                  trimmed.contains(member(1)), "subtract (huge - small)");
+        }
+        cout << "union and difference took " << secondsSince(start) << " s"
+             << endl;
+    } catch (const bad_alloc&) {
+        cout << "  FAIL  out of memory" << endl;
+        return EXIT_FAILURE;
+    } catch (const exception& e) {
+        cout << "  FAIL  " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -3,8 +3,8 @@
 //       (See IntSet.h for documentation.)
 // INVARIANT for the IntSet class:
 // (1) Distinct int values of the IntSet are stored in a 1-D,
-//     dynamic array whose size is stored in member variable
-//     capacity; the member variable data references the array.
+//     dynamic array whose size (the capacity) is stored in member
+//     variable cap; the member variable data references the array.
 // (2) The distinct int value with earliest membership is stored
 //     in data[0], the distinct int value with the 2nd-earliest
 //     membership is stored in data[1], and so on.
@@ -26,7 +26,7 @@
 //     appear together (no "holes" among them) starting from the
 //     beginning of the data array.
 // (6) We DON'T care what is stored in any of the array elements
-//     from data[used] through data[capacity - 1].
+//     from data[used] through data[cap - 1].
 //     Note: This applies also when the IntSet is empry (used == 0)
 //           in which case we DON'T care what is stored in any of
 //           the data array elements.
@@ -40,9 +40,34 @@
 //           the data array and used (if properly initialized and
 //           maintained) should tell which elements of the data
 //           array are actually relevant.
+// (7) To keep lookups from having to scan data, every member is also
+//     recorded in a hash index: a 1-D, dynamic array referenced by
+//     the member variable slots, whose size is stored in the member
+//     variable num_slots. num_slots is a power of 2 that is at
+//     least 2 * cap (so the index is never more than half full)
+//     and collisions are resolved by linear probing.
+// (8) An index slot that holds INDEX_MARKER (the most negative int)
+//     is unused; every member other than INDEX_MARKER occupies
+//     exactly one slot. Since INDEX_MARKER can't mark itself, whether
+//     it is a member is stored in the member variable has_marker.
+//     Note: The index says nothing about membership timing; that is
+//           still given by the order of data alone.
+// (9) Both dynamic arrays are obtained from IntSetStorage::allocate
+//     and given back through IntSetStorage::release with the same
+//     size (cap for data, num_slots for slots).
+// (10) A copy (copy constructor or assignment) shares its source's
+//     two arrays instead of copying them. Every IntSet whose arrays
+//     are shared points (member variable share) at one Share for the
+//     arrays, whose owners counts the IntSets using them; share is
+//     NULL for an IntSet whose arrays are its own. Shared arrays are
+//     never written: every mutator calls own() before its first
+//     write, and the last owner to let go of them releases them.
+//     Note: Only the arrays are shared. cap, used, num_slots and
+//           has_marker are copied, and they describe the arrays the
+//           same way for all owners until one of them calls own().
 //
-// DOCUMENTATION for private member (helper) function:
-//   void resize(int new_capacity)
+// DOCUMENTATION for private member (helper) functions:
+//   void resize(size_t new_capacity)
 //     Pre:  (none)
 //           Note: Recall that one of the things a constructor
 //                 has to do is to make sure that the object
@@ -51,6 +76,7 @@
 //                 be used within constructors unless it is at
 //                 a point where the class invariant has already
 //                 been made to hold true.
+//           The arrays are the invoking IntSet's own (see own()).
 //     Post: The capacity (size of the dynamic array) of the
 //           invoking IntSet is changed to new_capacity...
 //           ...EXCEPT when new_capacity would not allow the
@@ -67,64 +93,333 @@
 //           don't want to request dynamic arrays of size 0).
 //           The collection represented by the invoking IntSet
 //           remains unchanged.
-//           If reallocation of dynamic array is unsuccessful, an
-//           error message to the effect is displayed and the
-//           program unconditionally terminated.
+//           A new_capacity beyond MAX_CAPACITY is taken as
+//           MAX_CAPACITY.
+//           If reallocation of dynamic array is unsuccessful,
+//           std::bad_alloc is thrown and the IntSet is unchanged.
+//           The hash index is rebuilt to suit the new capacity.
+//   size_t findSlot(int anInt) const
+//     Pre:  anInt != INDEX_MARKER
+//     Post: The index slot holding anInt is returned if anInt is a
+//           member, otherwise the (unused) slot where it would go.
+//   void append(int anInt)
+//     Pre:  contains(anInt) is false and used < capacity(), and the
+//           arrays are the invoking IntSet's own (as they are for a
+//           set constructed to be appended to; see own()).
+//     Post: anInt has been added as the newest member (no lookup, no
+//           resize); the set algebra builds its results with this.
+//   void indexInsert(int anInt)
+//     Pre:  anInt is not yet recorded in the index, and the index
+//           is less than half full.
+//     Post: anInt is recorded in the index.
+//   void indexErase(int anInt)
+//     Pre:  anInt is recorded in the index.
+//     Post: anInt is no longer recorded in the index; entries after
+//           it in the same probe run have been shifted back so no
+//           lookup will stop short of them.
+//   void rebuildIndex()
+//     Pre:  data[0] through data[used - 1] hold the members.
+//     Post: A new index sized for the current capacity and holding
+//           exactly those members has replaced the old one.
+//   Share* joinShare() const
+//     Post: The invoking IntSet's arrays are shared (its share has
+//           been created if it was NULL), one more owner has been
+//           counted for them, and their Share is returned.
+//   void own(bool keep_members = true, size_t new_capacity = 0)
+//     Pre:  new_capacity is 0 or from used through MAX_CAPACITY.
+//     Post: The invoking IntSet's arrays are its own (share is NULL).
+//           If they were shared with other IntSets, new arrays have
+//           been made holding the same members and index (or, if
+//           keep_members is false, anything: the caller is about to
+//           overwrite them, and the copying is saved), with capacity
+//           new_capacity if it isn't 0 and the index sized to suit;
+//           std::bad_alloc is thrown, leaving the IntSet unchanged,
+//           if they couldn't be. Arrays that weren't shared keep
+//           their capacity (resize changes it).
+//   void releaseArrays()
+//     Post: The invoking IntSet no longer owns its arrays (they have
+//           been given back unless other owners are left); data,
+//           slots and share are dangling.
 
 #include "IntSet.h"
+#include "IntSetIndex.h"
+#include "IntSetStats.h"
+#include "IntSetStorage.h"
+#include "IntSetTrace.h"
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <cassert>
+#include <climits>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 using namespace std;
 
-void IntSet::resize(int new_capacity)
+namespace
 {
+    // The index and algebra kernels (see IntSetIndex.h).
+    typedef IntSetIndex<int> Index;
+
+    const int INDEX_MARKER = INT_MIN;  // marks an unused index slot
+    static_assert(INDEX_MARKER == std::numeric_limits<int>::min(),
+                  "IntSet's marker is IntSetIndex's");
+    static_assert(IntSet::MAX_CAPACITY <= Index::MAX_CAPACITY,
+                  "an IntSet's index size can't overflow");
+
+    // cap grown by half again (plus 1), but to no more than
+    // MAX_CAPACITY. MAX_CAPACITY leaves room for the index (2 * cap
+    // ints, rounded up to a power of 2) in a size_t, so no size
+    // computed from a capacity can overflow.
+    inline size_t grownCapacity(size_t cap)
+    {
+        size_t growth = cap / 2 + 1;
+        return growth < IntSet::MAX_CAPACITY - cap ? cap + growth
+                                                   : IntSet::MAX_CAPACITY;
+    }
+
+#ifdef INTSET_STATS
+    // Records the length of each containsMany probe.
+    struct ProbeRecorder
+    {
+        void operator()(size_t length) const
+        {
+            IntSetStats::recordLookup(length);
+        }
+    };
+#else
+    typedef IntSetNoProbe ProbeRecorder;
+#endif
+}
+
+// Arrays shared by copies (see invariant (10)).
+struct IntSet::Share
+{
+    std::atomic<size_t> owners;
+};
+
+IntSet::Share* IntSet::joinShare() const
+{
+    // Copies are made from const IntSets, possibly on several threads
+    // at once; the first to find the arrays unshared installs their
+    // Share, and any other thread racing it uses that one instead.
+    Share* current = share.load(memory_order_acquire);
+    if (current == NULL) {
+        Share* created = new Share;
+        created->owners.store(1, memory_order_relaxed);
+        if (share.compare_exchange_strong(current, created,
+                                          memory_order_acq_rel,
+                                          memory_order_acquire))
+            current = created;
+        else
+            delete created;
+    }
+    current->owners.fetch_add(1, memory_order_relaxed);
+    return current;
+}
+
+void IntSet::own(bool keep_members, size_t new_capacity)
+{
+    Share* current = share.load(memory_order_acquire);
+    if (current == NULL)
+        return;
+
+    // The other owners may all be gone, leaving the arrays to us.
+    if (current->owners.load(memory_order_acquire) == 1) {
+        delete current;
+        share.store(NULL, memory_order_relaxed);
+        return;
+    }
+
+    // A new capacity is applied in the same copy, so growing a
+    // shared set copies its members once.
+    size_t new_cap = new_capacity == 0 ? cap : new_capacity;
+    size_t new_num_slots =
+        new_cap == cap ? num_slots : Index::sizeFor(new_cap);
+    int* new_data = IntSetStorage::allocate(new_cap);
+    int* new_slots;
+    try {
+        new_slots = IntSetStorage::allocate(new_num_slots);
+    } catch (...) {
+        IntSetStorage::release(new_data, new_cap);
+        throw;
+    }
+
+    bool same_index = new_num_slots == num_slots;
+    if (keep_members) {
+        INTSET_STATS_RECORD(recordCopy(
+            (used + (same_index ? num_slots : 0)) * sizeof(int)));
+        copy(data, data + used, new_data);
+        if (same_index)
+            copy(slots, slots + num_slots, new_slots);
+    }
+
+    // Let go of the shared arrays (the others may have let go of them
+    // meanwhile, leaving it to us to release them).
+    releaseArrays();
+    data = new_data;
+    cap = new_cap;
+    slots = new_slots;
+    num_slots = new_num_slots;
+    share.store(NULL, memory_order_relaxed);
+
+    // An index of a new size is filled from the members (rebuildIndex
+    // allocates nothing when the size is right).
+    if (keep_members && !same_index)
+        rebuildIndex();
+}
+
+void IntSet::releaseArrays()
+{
+    Share* current = share.load(memory_order_relaxed);
+    if (current != NULL) {
+        if (current->owners.fetch_sub(1, memory_order_acq_rel) != 1)
+            return;
+        delete current;
+    }
+    IntSetStorage::release(data, cap);
+    IntSetStorage::release(slots, num_slots);
+}
+
+void IntSet::resize(size_t new_capacity)
+{
+    INTSET_TRACE_SCOPE("resize", new_capacity);
+
+    // Remember the old size; the storage needs it back on release.
+    size_t old_capacity = cap;
+
     // Confirm new capacity is valid. If it is then proceed to change
     // capacity to user specified value.
-    if(new_capacity <=0){capacity = DEFAULT_CAPACITY;}
-    else if(new_capacity < used ){capacity = used;}
-    else{capacity = new_capacity;}
+    if(new_capacity == 0){cap = DEFAULT_CAPACITY;}
+    else if(new_capacity > MAX_CAPACITY){cap = MAX_CAPACITY;}
+    else if(new_capacity < used ){cap = used;}
+    else{cap = new_capacity;}
 
     // Create new dynamic array with specified capacity
-    int* new_data = new int[capacity];
+    int* new_data;
+    try {
+        new_data = IntSetStorage::allocate(cap);
+    } catch (...) {
+        cap = old_capacity;
+        throw;
+    }
 
     // Copy current data to new dynamic array.
-    for(int index = 0; index < used; ++index){
+    for(size_t index = 0; index < used; ++index){
         new_data[index] = data[index];
     }
 
-    // Deallocate the space used by previous data array.
-    delete [] data;
+    INTSET_STATS_RECORD(recordResize(used * sizeof(int)));
 
-    // Move new dynamic array back to private member data.
+    // Size the index for the new capacity; if there's no memory for
+    // it, go back to the old array (and index, which is untouched).
+    int* old_data = data;
     data = new_data;
+    try {
+        rebuildIndex();
+    } catch (...) {
+        IntSetStorage::release(new_data, cap);
+        data = old_data;
+        cap = old_capacity;
+        throw;
+    }
+
+    // Deallocate the space used by previous data array.
+    IntSetStorage::release(old_data, old_capacity);
+}
+
+size_t IntSet::findSlot(int anInt) const
+{
+    size_t mask = num_slots - 1;
+    size_t slot = Index::find(slots, mask, anInt);
+    INTSET_STATS_RECORD(recordLookup(
+        ((slot - (Index::hash(anInt) & mask)) & mask) + 1));
+    return slot;
+}
+
+void IntSet::append(int anInt)
+{
+    data[used] = anInt;
+    ++used;
+    indexInsert(anInt);
+}
+
+void IntSet::indexInsert(int anInt)
+{
+    if (anInt == INDEX_MARKER) { has_marker = true; }
+    else { slots[findSlot(anInt)] = anInt; }
+}
+
+void IntSet::indexErase(int anInt)
+{
+    if (anInt == INDEX_MARKER) {
+        has_marker = false;
+        return;
+    }
+
+    // Open a hole where anInt was and close it up again.
+    Index::eraseAt(slots, num_slots - 1, findSlot(anInt));
 }
 
-IntSet::IntSet(int initial_capacity) : capacity(initial_capacity), used(0)
+void IntSet::rebuildIndex()
+{
+    size_t new_size = Index::sizeFor(cap);
+
+    if (new_size != num_slots) {
+        int* new_slots = IntSetStorage::allocate(new_size);
+        IntSetStorage::release(slots, num_slots);
+        slots = new_slots;
+        num_slots = new_size;
+    }
+
+    has_marker = Index::build(data, used, slots, num_slots);
+}
+
+const size_t IntSet::DEFAULT_CAPACITY;
+const size_t IntSet::MAX_CAPACITY;
+
+IntSet::IntSet(ptrdiff_t initial_capacity)
+    : cap(size_t(initial_capacity)), used(0),
+      slots(NULL), num_slots(0), has_marker(false), share(NULL)
 {
     // Initialize capacity to user specified capacity, and test it
     // for validity. If it's invalid then set it to DEFAULT_CAPACITY
-    // otherwise leave it as is.
-    if(initial_capacity <= 0){capacity = DEFAULT_CAPACITY;}
+    // otherwise leave it as is (but no more than MAX_CAPACITY).
+    if(initial_capacity <= 0){cap = DEFAULT_CAPACITY;}
+    else if(cap > MAX_CAPACITY){cap = MAX_CAPACITY;}
 
     // Instantiate a new dynamic array of size capacity.
-    data = new int[capacity];
+    data = IntSetStorage::allocate(cap);
+
+    // Instantiate an empty index to go with it.
+    try {
+        rebuildIndex();
+    } catch (...) {
+        IntSetStorage::release(data, cap);
+        throw;
+    }
 }
 
-IntSet::IntSet(const IntSet& src) : capacity(src.capacity), used(src.used)
+IntSet::IntSet(const IntSet& src)
+    : data(src.data), cap(src.cap), used(src.used),
+      slots(src.slots), num_slots(src.num_slots),
+      has_marker(src.has_marker), share(NULL)
 {
-    // Create a new dynamic array.
-    data = new int[capacity];
+    INTSET_STATS_TIME(OP_COPY);
 
-    // Copy each item of the dynamic array.
-    for(int index = 0; index < capacity; ++index)
-        data[index] = src.data[index];
+    // Share src's arrays; they are copied when either set changes.
+    share.store(src.joinShare(), memory_order_relaxed);
 }
 
 IntSet::~IntSet()
 {
-    // Deallocate any dynamically created variables.
-    delete [] data;
+    // Deallocate any dynamically created variables (that no copy
+    // still shares).
+    releaseArrays();
     data = NULL;
+    slots = NULL;
 }
 
 IntSet& IntSet::operator=(const IntSet& rhs)
@@ -135,33 +430,43 @@ IntSet& IntSet::operator=(const IntSet& rhs)
     if (this == &rhs)
         return *this;
 
-    // Create temporary dynamic array to safely assign contents
-    // of array.
-    int* temp_data = new int[rhs.capacity];
-
-    // Moved contents of rhs array to temp
-    for (int index = 0; index < rhs.used; ++index) {
-        temp_data[index] = rhs.data[index];
-    }
+    INTSET_STATS_TIME(OP_ASSIGN);
 
-    // Deallocate old dynamic array.
-    delete [] data;
+    // Join rhs's arrays first (the only step that can fail), then
+    // let go of the old ones.
+    Share* rhs_share = rhs.joinShare();
+    releaseArrays();
 
     // Start assigning member variables from rhs.
-    data = temp_data;
-    capacity = rhs.capacity;
+    data = rhs.data;
+    cap = rhs.cap;
     used = rhs.used;
+    slots = rhs.slots;
+    num_slots = rhs.num_slots;
+    has_marker = rhs.has_marker;
+    share.store(rhs_share, memory_order_relaxed);
 
     return *this;
 }
 
-int IntSet::size() const
+size_t IntSet::size() const
 {
     // Return the value of used which is
     // the number of elements in the array.
     return used;
 }
 
+size_t IntSet::capacity() const
+{
+    return cap;
+}
+
+size_t IntSet::memoryUsage() const
+{
+    return sizeof(IntSet) + IntSetStorage::blockBytes(cap) +
+           IntSetStorage::blockBytes(num_slots);
+}
+
 bool IntSet::isEmpty() const
 {
     // Empty if size() == 0, has unique int otherwise.
@@ -170,17 +475,44 @@ bool IntSet::isEmpty() const
 
 bool IntSet::contains(int anInt) const
 {
-    // Only traverse array if there are int's to check, otherwise
-    // return false because there's no int's to compare with.
-    if (used > 0){
-        for(int index = 0; index < used; ++index)
-            if(data[index] == anInt){ return true; }
+    INTSET_STATS_TIME(OP_CONTAINS);
+
+    // The marker value can't be looked up in the index, so its
+    // membership is tracked separately.
+    if (anInt == INDEX_MARKER)
+        return has_marker;
+    return slots[findSlot(anInt)] == anInt;
+}
+
+void IntSet::containsMany(const int* keys, size_t n, uint8_t* out) const
+{
+    // Small sets are scanned, larger ones looked up in the index.
+    if (used <= Index::SCAN_LIMIT)
+        Index::scanMany(data, used, keys, n, out);
+    else
+        Index::probeMany(slots, num_slots, has_marker, keys, n, out,
+                         ProbeRecorder());
+}
+
+void IntSet::containsManyMask(const int* keys, size_t n, uint64_t* mask) const
+{
+    // Answer 64 keys at a time into a byte buffer, then pack it.
+    uint8_t hits[64];
+    for (size_t base = 0; base < n; base += 64) {
+        size_t count = n - base < 64 ? n - base : 64;
+        containsMany(keys + base, count, hits);
+
+        uint64_t word = 0;
+        for (size_t bit = 0; bit < count; ++bit)
+            word |= uint64_t(hits[bit]) << bit;
+        mask[base / 64] = word;
     }
-    return false;
 }
 
 bool IntSet::isSubsetOf(const IntSet& otherIntSet) const
 {
+    INTSET_STATS_TIME(OP_SUBSET);
+
     if(isEmpty()) {
 
         // Check to see if the invoking IntSet
@@ -192,7 +524,7 @@ bool IntSet::isSubsetOf(const IntSet& otherIntSet) const
         // Check otherIntSet against invoking intSet to
         // determine if it's a subset of otherIntSet. If
         // there's a mismatch abort and return false.
-        for(int index = 0; index < used; index++){
+        for(size_t index = 0; index < used; index++){
             if(!otherIntSet.contains(data[index]))
                 return false;
         }
@@ -205,78 +537,100 @@ void IntSet::DumpData(ostream& out) const
    if (used > 0)
    {
       out << data[0];
-      for (int i = 1; i < used; ++i)
+      for (size_t i = 1; i < used; ++i)
          out << "  " << data[i];
    }
 }
 
 IntSet IntSet::unionWith(const IntSet& otherIntSet) const
 {
-    IntSet unionIntSet = (*this); //Copy of invoking IntSet.
-
-    int sizeOtherInt = otherIntSet.size(); // Keep size safe.
-
-    // Loop through IntSet to be added to invoking set. If duplicate
-    // elements found don't union, otherwise union unique elements.
-
-    for (int index = 0; index < sizeOtherInt; ++index) {
-        if(!unionIntSet.contains(otherIntSet.data[index]))
-            unionIntSet.add(otherIntSet.data[index]);
-    }
+    INTSET_STATS_TIME(OP_UNION);
+    INTSET_TRACE_SCOPE("unionWith", used + otherIntSet.used);
+
+    // Note which elements of otherIntSet are new (looked up in
+    // batches), so the union can be allocated at exactly its final
+    // size: no resizes and no slack.
+    vector<uint8_t> known(otherIntSet.used);
+    size_t extra = otherIntSet.used -
+                   Index::lookupAll(otherIntSet.data, otherIntSet.used,
+                                    *this, known.data());
+
+    // Invoking IntSet's members first, then otherIntSet's new ones.
+    IntSet unionIntSet(used + extra);
+    for (size_t index = 0; index < used; ++index)
+        unionIntSet.append(data[index]);
+    for (size_t index = 0; index < otherIntSet.used; ++index)
+        if (!known[index])
+            unionIntSet.append(otherIntSet.data[index]);
     return unionIntSet;
 }
 
 IntSet IntSet::intersect(const IntSet& otherIntSet) const
 {
-    IntSet interSet = (*this); // Create copy of invoking IntSet
-
-    int sizeOtherInt = otherIntSet.size(); // Keep size safe.
-
-    // Compare every item of invoking IntSet to otherIntSet
-    // if no match is found then remove it from interSet.
-    for (int index = 0; index < sizeOtherInt; index++) {
-        if(!otherIntSet.contains(data[index])){
-            interSet.remove(data[index]);
-        }
-    }
+    INTSET_STATS_TIME(OP_INTERSECT);
+    INTSET_TRACE_SCOPE("intersect", used + otherIntSet.used);
+
+    // Keep every item of the invoking IntSet that otherIntSet also
+    // has, in the invoking IntSet's order.
+    IntSet interSet(used);
+    Index::select(data, used, otherIntSet, true,
+                  [&interSet](int anInt) { interSet.append(anInt); });
     return interSet;
 }
 
 IntSet IntSet::subtract(const IntSet& otherIntSet) const
 {
-    IntSet subSet = (*this); // Create copy of invoking IntSet.
-
-    int sizeOtherInt = otherIntSet.size(); // Keep size safe.
-
-    // If an element in intSet is also in otherSet then remove
-    // it, otherwise keep elements in their respective sets.
-    for(int index = 0; index < sizeOtherInt; ++index){
-        if(subSet.contains(otherIntSet.data[index]))
-            subSet.remove(otherIntSet.data[index]);
-    }
+    INTSET_STATS_TIME(OP_SUBTRACT);
+    INTSET_TRACE_SCOPE("subtract", used + otherIntSet.used);
+
+    // Keep every item of the invoking IntSet that otherIntSet
+    // doesn't have, in the invoking IntSet's order.
+    IntSet subSet(used);
+    Index::select(data, used, otherIntSet, false,
+                  [&subSet](int anInt) { subSet.append(anInt); });
     return subSet; // Return subtracted IntSet.
 }
 
 void IntSet::reset()
 {
-    // Reset intSet by reinitializing used to "0".
+    // Shared arrays are replaced rather than copied.
+    own(false);
+
+    // Reset intSet by reinitializing used to "0" and clearing
+    // every index slot.
     used = 0;
+    for (size_t slot = 0; slot < num_slots; ++slot)
+        slots[slot] = INDEX_MARKER;
+    has_marker = false;
 }
 
 bool IntSet::add(int anInt)
 {
+    INTSET_STATS_TIME(OP_ADD);
 
     // If anInt is unique then add it as the last element in the
     // data array and return true.
     if(!contains(anInt)){
 
         // If used == capacity or is above then we can't
-        // add another item without resizing first.
-        if(used >= capacity) {resize(int(capacity * 1.5) + 1);}
+        // add another item without resizing first (and can't
+        // resize at all if the capacity is already the maximum).
+        // Members a copy shares are copied first, straight into
+        // the grown arrays if it needs them.
+        if(used >= cap) {
+            if(cap == MAX_CAPACITY)
+                throw length_error("IntSet::add: capacity limit reached");
+            size_t grown = grownCapacity(cap);
+            own(true, grown);
+            if(cap < grown) { resize(grown); }
+        } else {
+            own();
+        }
 
         // Regardless of resize add new item to dynamic
         data[used] = anInt;
         ++used;
+        indexInsert(anInt);
         return true;
     }
 
@@ -286,15 +640,19 @@ bool IntSet::add(int anInt)
 
 bool IntSet::remove(int anInt)
 {
+    INTSET_STATS_TIME(OP_REMOVE);
+
     // If the intSet has the requested element in the set then
     // remove it, and shift all elements to the left by one.
     if(contains(anInt)){
-        for(int index = 0; index < used; ++index){
+        own();
+        for(size_t index = 0; index < used; ++index){
             if(data[index] == anInt) {
-                for(int index2 = index; index2 < used - 1; ++index2) {
+                for(size_t index2 = index; index2 < used - 1; ++index2) {
                     data[index2] = data[index2 + 1];
                 }
                 --used;
+                indexErase(anInt);
                 return true; // Int removed successfully.
             }
         }
@@ -302,15 +660,26 @@ bool IntSet::remove(int anInt)
     return false; // No int removed.
 }
 
+void IntSet::swap(IntSet& otherIntSet)
+{
+    // Trade dynamic arrays and bookkeeping; nothing is copied.
+    std::swap(data, otherIntSet.data);
+    std::swap(cap, otherIntSet.cap);
+    std::swap(used, otherIntSet.used);
+    std::swap(slots, otherIntSet.slots);
+    std::swap(num_slots, otherIntSet.num_slots);
+    std::swap(has_marker, otherIntSet.has_marker);
+    Share* temp_share = share.load(memory_order_relaxed);
+    share.store(otherIntSet.share.load(memory_order_relaxed),
+                memory_order_relaxed);
+    otherIntSet.share.store(temp_share, memory_order_relaxed);
+}
+
 bool operator==(const IntSet& is1, const IntSet& is2) {
+    INTSET_STATS_TIME(OP_EQUAL);
 
-    // First check to see if both IntSet objects are empty,
-    // if they are then is1 is a subset of is2. Otherwise
-    // compare every element.
-    if (is1.IntSet::isEmpty() && is2.IntSet::isEmpty()){
-        return true;
-    } else if(is1.IntSet::isSubsetOf(is2) && is2.IntSet::isSubsetOf(is1)){
-        return true;
-    }
-    return false;
+    // Two sets of the same size are equal exactly when one is a
+    // subset of the other (neither has duplicates), so a single
+    // pass suffices; two empty sets are equal by definition.
+    return is1.size() == is2.size() && is1.isSubsetOf(is2);
 }
@@ -3,27 +3,51 @@
 //                 int values)
 //
 // CONSTANT
-//   static const int DEFAULT_CAPACITY = ____
+//   static const size_t DEFAULT_CAPACITY = ____
 //     IntSet::DEFAULT_CAPACITY is the initial capacity of an
 //     IntSet that is created by the default constructor (i.e.,
 //     IntSet::DEFAULT_CAPACITY is the highest # of distinct
 //     values "an IntSet created by the default constructor"
 //     can accommodate).
+//   static const size_t MAX_CAPACITY = ____
+//     IntSet::MAX_CAPACITY is the largest capacity an IntSet ever
+//     has: room for every one of the 2^32 ints (no IntSet can need
+//     more), or less where a size_t couldn't express the memory for
+//     that. Requests for more capacity are taken as MAX_CAPACITY.
 //
 // CONSTRUCTOR
-//   IntSet(int initial_capacity = DEFAULT_CAPACITY)
+//   IntSet(std::ptrdiff_t initial_capacity = DEFAULT_CAPACITY)
 //     Post: The invoking IntSet is initialized to an empty
 //           IntSet (i.e., one containing no relevant elements);
 //           the initial capacity is given by initial_capacity if
 //           initial_capacity is >= 1, otherwise it is given by
 //           IntSet:DEFAULT_CAPACITY.
+//     Note: Capacities (and sizes) are size_t's: an IntSet may hold
+//           every one of the 2^32 ints, given the memory (about
+//           12 bytes a member at capacity: 4 for the member and at
+//           least 8 of index).
 //     Note: When the IntSet is put to use after construction,
 //           its capacity will be resized as necessary.
 //
 // CONSTANT MEMBER FUNCTIONS (ACCESSORS)
-//   int size() const
+//   size_t size() const
 //     Pre:  (none)
 //     Post: Number of elements in the invoking IntSet is returned.
+//   size_t capacity() const
+//     Pre:  (none)
+//     Post: # of elements the invoking IntSet can hold before it has
+//           to grow is returned.
+//     Note: Capacity never shrinks on its own: neither reset nor
+//           remove gives memory back, and copies (copy constructor
+//           and assignment) get the capacity of their source.
+//   size_t memoryUsage() const
+//     Pre:  (none)
+//     Post: # of bytes the invoking IntSet occupies is returned: the
+//           object itself plus the storage actually reserved for its
+//           member array and hash index (see
+//           IntSetStorage::blockBytes).
+//     Note: Storage shared with copies (see VALUE SEMANTICS) is
+//           counted in full by each of them.
 //   bool isEmpty() const
 //     Pre:  (none)
 //     Post: True is returned if the invoking IntSet has no relevant
@@ -32,6 +56,22 @@
 //     Pre:  (none)
 //     Post: true is returned if the invoking IntSet has anInt as an
 //           element, otherwise false is returned.
+//   void containsMany(const int* keys, size_t n, uint8_t* out) const
+//     Pre:  keys points to n ints; out points to room for n bytes.
+//     Post: out[i] is 1 if the invoking IntSet has keys[i] as an
+//           element, otherwise 0 (for every i from 0 to n - 1).
+//     Note: Same answers as calling contains on each key, but the
+//           probes are pipelined (the index slots for keys a few
+//           positions ahead are prefetched while the current key is
+//           being looked up), so large batches run at memory speed
+//           rather than at one cache miss per key.
+//   void containsManyMask(const int* keys, size_t n,
+//                         uint64_t* mask) const
+//     Pre:  keys points to n ints; mask points to room for
+//           (n + 63) / 64 words.
+//     Post: Bit (i % 64) of mask[i / 64] is set if the invoking IntSet
+//           has keys[i] as an element, otherwise it is clear; unused
+//           high bits of the last word are clear.
 //   bool isSubsetOf(const IntSet& otherIntSet) const
 //     Pre:  (none)
 //     Post: True is returned if all elements of the invoking IntSet
@@ -81,12 +121,20 @@
 //           added to the invoking IntSet as a new element and
 //           true is returned, otherwise the invoking IntSet is
 //           unchanged and false is returned.
+//     Note: Growth is by half the capacity each time, checked for
+//           overflow. If memory runs out, std::bad_alloc is thrown
+//           (std::length_error if the capacity can't grow within a
+//           size_t at all) and the invoking IntSet is unchanged.
 //   bool remove(int anInt)
 //     Pre:  (none)
 //     Post: If contains(anInt) returns true, anInt has been
 //           removed from the invoking IntSet and true is
 //           returned, otherwise the invoking IntSet is unchanged
 //           and false is returned.
+//   void swap(IntSet& otherIntSet)
+//     Pre:  (none)
+//     Post: The invoking IntSet and otherIntSet have exchanged
+//           contents (no elements are copied).
 //
 // NON-MEMBER FUNCTIONS
 //   bool equal(const IntSet& is1, const IntSet& is2)
@@ -99,23 +147,42 @@
 // VALUE SEMANTICS
 //   Assignment and the copy constructor may be used with IntSet
 //   objects.
+//   Copying is O(1): a copy shares its source's storage (copy-on-
+//   write) until either of them is changed, and the change copies
+//   the members first (so remove and reset, too, may then throw
+//   std::bad_alloc, leaving the IntSet unchanged). A change that
+//   turns out not to change anything (adding a member, removing a
+//   non-member) copies nothing. The sharing can't be observed,
+//   except through its cost: IntSets that share storage may be used
+//   (and copied, and destroyed) on different threads at once, with
+//   the same rules as unshared ones.
 
 #ifndef INT_SET_H
 #define INT_SET_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 
 class IntSet
 {
 public:
-   static const int DEFAULT_CAPACITY = 1;
-   IntSet(int initial_capacity = DEFAULT_CAPACITY);
+   static const size_t DEFAULT_CAPACITY = 1;
+   static const size_t MAX_CAPACITY =
+      size_t((1ULL << 32) < SIZE_MAX / (4 * sizeof(int))
+             ? (1ULL << 32) : SIZE_MAX / (4 * sizeof(int)));
+   IntSet(std::ptrdiff_t initial_capacity = DEFAULT_CAPACITY);
    IntSet(const IntSet& src);
    ~IntSet();
    IntSet& operator=(const IntSet& rhs);
-   int size() const;
+   size_t size() const;
+   size_t capacity() const;
+   size_t memoryUsage() const;
    bool isEmpty() const;
    bool contains(int anInt) const;
+   void containsMany(const int* keys, size_t n, uint8_t* out) const;
+   void containsManyMask(const int* keys, size_t n, uint64_t* mask) const;
    bool isSubsetOf(const IntSet& otherIntSet) const;
    void DumpData(std::ostream& out) const;
    IntSet unionWith(const IntSet& otherIntSet) const;
@@ -124,12 +191,33 @@ public:
    void reset();
    bool add(int anInt);
    bool remove(int anInt);
+   void swap(IntSet& otherIntSet);
 
 private:
-   int* data;
-   int  capacity;
-   int  used;
-   void resize(int new_capacity);
+   friend class IntSetBuilder;
+   friend class IntSetExprAccess;
+   friend class IntSetFile;
+   friend class IntSetJob;
+   friend class IntSetParallel;
+   friend class IntSetShared;
+   struct Share;
+
+   int*   data;
+   size_t cap;
+   size_t used;
+   int*   slots;
+   size_t num_slots;
+   bool   has_marker;
+   mutable std::atomic<Share*> share;   // NULL if not shared
+   Share* joinShare() const;
+   void   own(bool keep_members = true, size_t new_capacity = 0);
+   void   releaseArrays();
+   void   resize(size_t new_capacity);
+   size_t findSlot(int anInt) const;
+   void   append(int anInt);
+   void   indexInsert(int anInt);
+   void   indexErase(int anInt);
+   void   rebuildIndex();
 };
 
 bool operator==(const IntSet& is1, const IntSet& is2);
@@ -0,0 +1,356 @@
+// FILE: IntSetBasic.cpp
+//       Implementation file for the BasicIntSet template
+//       (See IntSetBasic.h for documentation.)
+// INVARIANT for the BasicIntSet class (as for IntSet, with T's):
+// (1) The members are data[0] through data[used - 1], earliest
+//     membership first; data has room for cap T's (cap >= 1).
+// (2) Every member other than MARKER (the lowest T) occupies exactly
+//     one slot of the hash index slots, num_slots of them: a power of
+//     2 that is at least 2 * cap, so the index is never more than
+//     half full; collisions are resolved by linear probing. Unused
+//     slots hold MARKER; whether MARKER is a member is has_marker.
+// (3) Both arrays come from allocate and go back through release with
+//     the same count (cap for data, num_slots for slots).
+// NOTES on the implementation:
+// (1) The arrays come from IntSetStorage, like IntSet's, so large
+//     ones get the same NUMA placement and huge pages; a block of
+//     count T's is requested as enough ints to hold them (IntSetStorage
+//     blocks are aligned for any scalar type).
+// (2) Capacity grows by half again (plus 1), as IntSet's does, to no
+//     more than MAX_CAPACITY; capacities asked for beyond it are
+//     clamped to it, so no index size computed here can overflow.
+// (3) The index, probing and algebra code is IntSetIndex<T>'s, the
+//     same kernels IntSet uses for ints; what is left here is the
+//     management of the arrays. Copies are deep (IntSet's share their
+//     arrays until one changes), and there are no statistics.
+// (4) As in IntSet, the arrays a change needs are allocated before
+//     anything is changed, so a failed allocation leaves the set as
+//     it was.
+
+#include "IntSetBasic.h"
+#include "IntSetStorage.h"
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <vector>
+using namespace std;
+
+namespace
+{
+    // # of ints IntSetStorage is asked for to hold count T's.
+    template <class T>
+    inline size_t intsFor(size_t count)
+    {
+        return (count * sizeof(T) + sizeof(int) - 1) / sizeof(int);
+    }
+}
+
+template <class T>
+const size_t BasicIntSet<T>::DEFAULT_CAPACITY;
+
+template <class T>
+const size_t BasicIntSet<T>::MAX_CAPACITY;
+
+template <class T>
+T* BasicIntSet<T>::allocate(size_t count)
+{
+    if (count > (numeric_limits<size_t>::max() - sizeof(int)) / sizeof(T))
+        throw bad_alloc();
+    return reinterpret_cast<T*>(IntSetStorage::allocate(intsFor<T>(count)));
+}
+
+template <class T>
+void BasicIntSet<T>::release(T* block, size_t count)
+{
+    IntSetStorage::release(reinterpret_cast<int*>(block), intsFor<T>(count));
+}
+
+template <class T>
+size_t BasicIntSet<T>::clampedCapacity(size_t capacity)
+{
+    if (capacity == 0)
+        return DEFAULT_CAPACITY;
+    return min(capacity, size_t(MAX_CAPACITY));
+}
+
+template <class T>
+void BasicIntSet<T>::resize(size_t new_capacity)
+{
+    size_t new_cap = clampedCapacity(max(new_capacity, used));
+    size_t new_num_slots = Index::sizeFor(new_cap);
+    T* new_data = allocate(new_cap);
+    T* new_slots = slots;
+    if (new_num_slots != num_slots) {
+        try {
+            new_slots = allocate(new_num_slots);
+        } catch (...) {
+            release(new_data, new_cap);
+            throw;
+        }
+    }
+
+    copy(data, data + used, new_data);
+    release(data, cap);
+    if (new_slots != slots)
+        release(slots, num_slots);
+    data = new_data;
+    cap = new_cap;
+    slots = new_slots;
+    num_slots = new_num_slots;
+    rebuildIndex();
+}
+
+template <class T>
+size_t BasicIntSet<T>::findSlot(T value) const
+{
+    return Index::find(slots, num_slots - 1, value);
+}
+
+template <class T>
+void BasicIntSet<T>::append(T value)
+{
+    data[used] = value;
+    ++used;
+    indexInsert(value);
+}
+
+template <class T>
+void BasicIntSet<T>::indexInsert(T value)
+{
+    if (value == Index::marker())
+        has_marker = true;
+    else
+        slots[findSlot(value)] = value;
+}
+
+template <class T>
+void BasicIntSet<T>::indexErase(T value)
+{
+    if (value == Index::marker())
+        has_marker = false;
+    else
+        Index::eraseAt(slots, num_slots - 1, findSlot(value));
+}
+
+template <class T>
+void BasicIntSet<T>::rebuildIndex()
+{
+    has_marker = Index::build(data, used, slots, num_slots);
+}
+
+template <class T>
+BasicIntSet<T>::BasicIntSet(size_t initial_capacity)
+    : data(NULL), cap(clampedCapacity(initial_capacity)), used(0),
+      slots(NULL), num_slots(Index::sizeFor(cap)), has_marker(false)
+{
+    data = allocate(cap);
+    try {
+        slots = allocate(num_slots);
+    } catch (...) {
+        release(data, cap);
+        throw;
+    }
+    rebuildIndex();
+}
+
+template <class T>
+BasicIntSet<T>::BasicIntSet(const BasicIntSet& src)
+    : data(NULL), cap(src.cap), used(src.used), slots(NULL),
+      num_slots(src.num_slots), has_marker(src.has_marker)
+{
+    data = allocate(cap);
+    try {
+        slots = allocate(num_slots);
+    } catch (...) {
+        release(data, cap);
+        throw;
+    }
+    copy(src.data, src.data + used, data);
+    copy(src.slots, src.slots + num_slots, slots);
+}
+
+template <class T>
+BasicIntSet<T>::~BasicIntSet()
+{
+    release(data, cap);
+    release(slots, num_slots);
+}
+
+template <class T>
+BasicIntSet<T>& BasicIntSet<T>::operator=(const BasicIntSet& rhs)
+{
+    if (this != &rhs) {
+        BasicIntSet copy(rhs);
+        swap(copy);
+    }
+    return *this;
+}
+
+template <class T>
+size_t BasicIntSet<T>::size() const
+{
+    return used;
+}
+
+template <class T>
+size_t BasicIntSet<T>::capacity() const
+{
+    return cap;
+}
+
+template <class T>
+size_t BasicIntSet<T>::memoryUsage() const
+{
+    return sizeof(*this) + IntSetStorage::blockBytes(intsFor<T>(cap)) +
+           IntSetStorage::blockBytes(intsFor<T>(num_slots));
+}
+
+template <class T>
+bool BasicIntSet<T>::isEmpty() const
+{
+    return used == 0;
+}
+
+template <class T>
+bool BasicIntSet<T>::contains(T value) const
+{
+    if (value == Index::marker())
+        return has_marker;
+    return slots[findSlot(value)] == value;
+}
+
+template <class T>
+void BasicIntSet<T>::containsMany(const T* keys, size_t n, uint8_t* out) const
+{
+    // Sets that fit in a cache line are scanned, larger ones looked up
+    // in the index.
+    if (used <= Index::SCAN_LIMIT)
+        Index::scanMany(data, used, keys, n, out);
+    else
+        Index::probeMany(slots, num_slots, has_marker, keys, n, out,
+                         IntSetNoProbe());
+}
+
+template <class T>
+bool BasicIntSet<T>::isSubsetOf(const BasicIntSet& other) const
+{
+    return Index::allIn(data, used, other);
+}
+
+template <class T>
+void BasicIntSet<T>::DumpData(ostream& out) const
+{
+    for (size_t i = 0; i < used; ++i) {
+        if (i > 0)
+            out << "  ";
+        out << +data[i];
+    }
+}
+
+template <class T>
+BasicIntSet<T> BasicIntSet<T>::unionWith(const BasicIntSet& other) const
+{
+    // Find other's new members first so the result is allocated at
+    // exactly its final size.
+    vector<uint8_t> known(other.used);
+    size_t extra =
+        other.used - Index::lookupAll(other.data, other.used, *this,
+                                      known.data());
+
+    BasicIntSet result(used + extra);
+    for (size_t i = 0; i < used; ++i)
+        result.append(data[i]);
+    for (size_t i = 0; i < other.used; ++i)
+        if (!known[i])
+            result.append(other.data[i]);
+    return result;
+}
+
+template <class T>
+BasicIntSet<T> BasicIntSet<T>::intersect(const BasicIntSet& other) const
+{
+    BasicIntSet result(used);
+    Index::select(data, used, other, true,
+                  [&result](T value) { result.append(value); });
+    return result;
+}
+
+template <class T>
+BasicIntSet<T> BasicIntSet<T>::subtract(const BasicIntSet& other) const
+{
+    BasicIntSet result(used);
+    Index::select(data, used, other, false,
+                  [&result](T value) { result.append(value); });
+    return result;
+}
+
+template <class T>
+const T* BasicIntSet<T>::members() const
+{
+    return data;
+}
+
+template <class T>
+void BasicIntSet<T>::reset()
+{
+    used = 0;
+    has_marker = Index::build(data, used, slots, num_slots);
+}
+
+template <class T>
+bool BasicIntSet<T>::add(T value)
+{
+    if (contains(value))
+        return false;
+    if (used == cap) {
+        if (cap == MAX_CAPACITY)
+            throw length_error("BasicIntSet::add: capacity limit reached");
+        size_t growth = cap / 2 + 1;
+        resize(growth < MAX_CAPACITY - cap ? cap + growth : MAX_CAPACITY);
+    }
+    append(value);
+    return true;
+}
+
+template <class T>
+bool BasicIntSet<T>::remove(T value)
+{
+    if (!contains(value))
+        return false;
+    T* at = find(data, data + used, value);
+    copy(at + 1, data + used, at);
+    --used;
+    indexErase(value);
+    return true;
+}
+
+template <class T>
+void BasicIntSet<T>::swap(BasicIntSet& other)
+{
+    std::swap(data, other.data);
+    std::swap(cap, other.cap);
+    std::swap(used, other.used);
+    std::swap(slots, other.slots);
+    std::swap(num_slots, other.num_slots);
+    std::swap(has_marker, other.has_marker);
+}
+
+template <class T>
+bool operator==(const BasicIntSet<T>& s1, const BasicIntSet<T>& s2)
+{
+    return s1.size() == s2.size() && s1.isSubsetOf(s2);
+}
+
+#define INT_SET_BASIC_INSTANTIATE(T) \
+    template class BasicIntSet<T>; \
+    template bool operator==(const BasicIntSet<T>&, const BasicIntSet<T>&);
+
+INT_SET_BASIC_INSTANTIATE(int8_t)
+INT_SET_BASIC_INSTANTIATE(uint8_t)
+INT_SET_BASIC_INSTANTIATE(int16_t)
+INT_SET_BASIC_INSTANTIATE(uint16_t)
+INT_SET_BASIC_INSTANTIATE(int32_t)
+INT_SET_BASIC_INSTANTIATE(uint32_t)
+INT_SET_BASIC_INSTANTIATE(int64_t)
+INT_SET_BASIC_INSTANTIATE(uint64_t)
@@ -0,0 +1,159 @@
+// FILE: IntSetBasic.h - header file for the BasicIntSet template
+// TEMPLATE PROVIDED: BasicIntSet<T> (IntSet's container and algorithms
+//                    for any integral element type T from int8_t
+//                    through uint64_t), and IntSetOf<T> (the set type
+//                    to use for elements of type T)
+//
+// BasicIntSet<T> works like IntSet (same operations, same membership
+// order, same insertion-ordered array plus linear-probing hash index,
+// arrays from IntSetStorage) but stores T's, so a set of uint16_t's
+// takes half the memory of the same set of ints, and sets of 64-bit
+// ids need no narrowing. Sizes and capacities are size_t, so a set is
+// limited by memory rather than by 2^31 members.
+//
+// T must be one of int8_t, uint8_t, int16_t, uint16_t, int32_t,
+// uint32_t, int64_t and uint64_t (the template is compiled for those
+// only, in IntSetBasic.cpp). Each is a separate instantiation, so the
+// small-set scan is an SSE2 kernel for its width and the index probes
+// are compiled for it; the hash is 32-bit for types up to 32 bits
+// wide and 64-bit for the others.
+//
+// The index, lookup and set algebra kernels are IntSetIndex<T>'s (see
+// IntSetIndex.h), the same ones IntSet runs for ints; BasicIntSet
+// manages its arrays itself. Where it knowingly differs from IntSet:
+// copies of a BasicIntSet are deep (IntSet's share their arrays until
+// one changes), and it keeps no statistics.
+//
+// TYPEDEF
+//   template <class T> using IntSetOf = ...
+//     IntSetOf<T> is BasicIntSet<T>, except that IntSetOf<int> is
+//     IntSet itself (which additionally has IntSet's statistics,
+//     tracing, set expressions, file format and parallel algorithms).
+//     Code generic over the element type should use IntSetOf.
+//
+// CONSTANTS
+//   static const size_t DEFAULT_CAPACITY = 1
+//   static const size_t MAX_CAPACITY = IntSetIndex<T>::MAX_CAPACITY
+//     The most members a BasicIntSet<T> can hold.
+//
+// CONSTRUCTOR
+//   BasicIntSet(size_t initial_capacity = DEFAULT_CAPACITY)
+//     Post: The invoking set is empty, with capacity initial_capacity
+//           (DEFAULT_CAPACITY if initial_capacity is 0, MAX_CAPACITY
+//           if it is more than that).
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   size_t size() const
+//   size_t capacity() const
+//   size_t memoryUsage() const
+//   bool isEmpty() const
+//   bool contains(T value) const
+//   void containsMany(const T* keys, size_t n, uint8_t* out) const
+//   bool isSubsetOf(const BasicIntSet& other) const
+//   void DumpData(std::ostream& out) const
+//   BasicIntSet unionWith(const BasicIntSet& other) const
+//   BasicIntSet intersect(const BasicIntSet& other) const
+//   BasicIntSet subtract(const BasicIntSet& other) const
+//     Post: As for IntSet (8-bit members are dumped as numbers, not
+//           characters).
+//   const T* members() const
+//     Post: The members, in membership order, are returned (size() of
+//           them); the array stays valid until the set is changed.
+//
+// MODIFICATION MEMBER FUNCTIONS (MUTATORS)
+//   void reset()
+//   bool add(T value)
+//   bool remove(T value)
+//   void swap(BasicIntSet& other)
+//     Post: As for IntSet (add throws std::length_error if value is
+//           new and the set already holds MAX_CAPACITY members).
+//
+// NON-MEMBER FUNCTIONS
+//   template <class T>
+//   bool operator==(const BasicIntSet<T>& s1, const BasicIntSet<T>& s2)
+//     Post: As for IntSet.
+//
+// VALUE SEMANTICS
+//   Assignment and the copy constructor may be used with BasicIntSet
+//   objects.
+
+#ifndef INT_SET_BASIC_H
+#define INT_SET_BASIC_H
+
+#include "IntSet.h"
+#include "IntSetIndex.h"
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+
+template <class T>
+class BasicIntSet
+{
+public:
+   static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                 "BasicIntSet holds integers");
+
+   static const size_t DEFAULT_CAPACITY = 1;
+   static const size_t MAX_CAPACITY = IntSetIndex<T>::MAX_CAPACITY;
+   BasicIntSet(size_t initial_capacity = DEFAULT_CAPACITY);
+   BasicIntSet(const BasicIntSet& src);
+   ~BasicIntSet();
+   BasicIntSet& operator=(const BasicIntSet& rhs);
+   size_t size() const;
+   size_t capacity() const;
+   size_t memoryUsage() const;
+   bool isEmpty() const;
+   bool contains(T value) const;
+   void containsMany(const T* keys, size_t n, uint8_t* out) const;
+   bool isSubsetOf(const BasicIntSet& other) const;
+   void DumpData(std::ostream& out) const;
+   BasicIntSet unionWith(const BasicIntSet& other) const;
+   BasicIntSet intersect(const BasicIntSet& other) const;
+   BasicIntSet subtract(const BasicIntSet& other) const;
+   const T* members() const;
+   void reset();
+   bool add(T value);
+   bool remove(T value);
+   void swap(BasicIntSet& other);
+
+private:
+   typedef IntSetIndex<T> Index;
+
+   static T* allocate(size_t count);
+   static void release(T* block, size_t count);
+   static size_t clampedCapacity(size_t capacity);
+   void resize(size_t new_capacity);
+   size_t findSlot(T value) const;
+   void append(T value);
+   void indexInsert(T value);
+   void indexErase(T value);
+   void rebuildIndex();
+
+   T*     data;
+   size_t cap;
+   size_t used;
+   T*     slots;
+   size_t num_slots;
+   bool   has_marker;
+};
+
+template <class T>
+bool operator==(const BasicIntSet<T>& s1, const BasicIntSet<T>& s2);
+
+template <class T>
+struct IntSetType
+{
+   typedef BasicIntSet<T> type;
+};
+
+template <>
+struct IntSetType<int>
+{
+   typedef IntSet type;
+};
+
+template <class T>
+using IntSetOf = typename IntSetType<T>::type;
+
+#endif
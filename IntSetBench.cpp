@@ -0,0 +1,526 @@
+// FILE: IntSetBench.cpp
+//       Microbenchmarks for every IntSet operation, swept over set
+//       sizes, value distributions and (for operations on two sets)
+//       how much the two sets overlap.
+//
+// USAGE: intset_bench [--filter=TEXT] [--max-size=N] [--min-time=SECS]
+//                     [--max-time=SECS] [--pages=default|thp|hugetlb]
+//                     [--counters] [--sets=LHS,RHS]
+//   --filter:   only run cases whose name contains TEXT (a name looks
+//               like "intersect/clustered/n=1000/overlap=50%")
+//   --max-size: largest set size to try (default 10000000)
+//   --min-time: keep repeating a case until at least this much time
+//               has been measured (default 0.2)
+//   --max-time: once one iteration of an operation takes longer than
+//               this on some distribution, larger sizes of that
+//               operation/distribution are skipped (default 2.0)
+//   --pages:    IntSetStorage page mode for large arrays
+//   --counters: also count hardware events (see IntSetCounters.h)
+//               over the measured regions; events the machine won't
+//               count are shown as n/a
+//   --sets:     instead of the generated distributions, run every
+//               operation on two sets saved by intset_workload (in the
+//               IntSetFile format); their cases are named like
+//               "intersect/loaded/n=100000", n being the size of LHS
+//
+// OUTPUT: one line per case with
+//   iters:     # of times the case was repeated
+//   ns/op:     nanoseconds per operation; for add, contains and remove
+//              an operation is one call, for everything else it is one
+//              whole set operation (one copy, one unionWith, ...)
+//   allocs/op: IntSetStorage arrays allocated per operation
+//   bytes/op:  IntSetStorage bytes allocated per operation; an IntSet
+//              writes every byte of its index and of the data it keeps
+//              when it allocates, so this is also a floor on the bytes
+//              the operation touches
+//   and, with --counters, cycles, instructions, L1d-misses,
+//   LLC-misses and br-misses per operation
+
+#include "IntSet.h"
+#include "IntSetCounters.h"
+#include "IntSetExpr.h"
+#include "IntSetFile.h"
+#include "IntSetStorage.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace
+{
+    enum Distribution { DENSE, SPARSE, CLUSTERED, ADVERSARIAL };
+    const char* const DISTRIBUTION_NAMES[] =
+        { "dense", "sparse", "clustered", "adversarial" };
+    const int NUM_DISTRIBUTIONS = 4;
+
+    struct Options
+    {
+        string filter;
+        int    max_size;
+        double min_time;
+        double max_time;
+        bool   counters;
+    };
+
+    // Keeps results alive so the compiler can't drop the work.
+    volatile long sink;
+
+    // Times one region per iteration and snapshots the allocation
+    // counters around it; with hardware counters, they run over the
+    // same regions.
+    class Stopwatch
+    {
+    public:
+        explicit Stopwatch(bool with_counters)
+            : seconds(0), allocs(0), bytes(0),
+              counters(with_counters ? new IntSetCounters : NULL) {}
+        void start()
+        {
+            allocs0 = IntSetStorage::allocationCount();
+            bytes0 = IntSetStorage::allocatedBytes();
+            if (counters)
+                counters->start();
+            t0 = chrono::steady_clock::now();
+        }
+        void stop()
+        {
+            chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+            if (counters)
+                counters->stop();
+            seconds += chrono::duration<double>(t1 - t0).count();
+            allocs += IntSetStorage::allocationCount() - allocs0;
+            bytes += IntSetStorage::allocatedBytes() - bytes0;
+        }
+        double                         seconds;
+        unsigned long                  allocs;
+        unsigned long long             bytes;
+        unique_ptr<IntSetCounters>     counters;
+
+    private:
+        chrono::steady_clock::time_point t0;
+        unsigned long                    allocs0;
+        unsigned long long               bytes0;
+    };
+
+    // count distinct values of the given distribution, in random order.
+    vector<int> makeValues(Distribution dist, int count, mt19937& rng)
+    {
+        vector<int> values;
+        values.reserve(count);
+        switch (dist)
+        {
+        case DENSE:
+            // 0 .. count - 1
+            for (int i = 0; i < count; ++i)
+                values.push_back(i);
+            break;
+        case SPARSE:
+            // Spread over the whole int range.
+            {
+                IntSet seen(count);
+                uniform_int_distribution<int> any(INT_MIN, INT_MAX);
+                while (int(values.size()) < count) {
+                    int v = any(rng);
+                    if (seen.add(v))
+                        values.push_back(v);
+                }
+            }
+            break;
+        case CLUSTERED:
+            // Runs of 64 consecutive values, runs 4096 apart.
+            for (int i = 0; i < count; ++i)
+                values.push_back((i / 64) * 4096 + i % 64);
+            break;
+        case ADVERSARIAL:
+            // i with its halves swapped: multiples of 2^16 (which weak
+            // hashes pile into the same few slots) of both signs, plus
+            // the most negative int, which IntSet treats specially
+            // (it takes the place of 0).
+            for (int i = 0; i < count; ++i) {
+                unsigned u = unsigned(i);
+                int v = int((u << 16) | (u >> 16));
+                values.push_back(i == 0 ? INT_MIN : v == INT_MIN ? 0 : v);
+            }
+            break;
+        }
+        shuffle(values.begin(), values.end(), rng);
+        return values;
+    }
+
+    IntSet makeSet(const vector<int>& values, int begin, int end)
+    {
+        IntSet result;
+        for (int i = begin; i < end; ++i)
+            result.add(values[i]);
+        return result;
+    }
+
+    string caseName(const string& op, Distribution dist, int size, int overlap)
+    {
+        stringstream name;
+        name << op << "/" << DISTRIBUTION_NAMES[dist] << "/n=" << size;
+        if (overlap >= 0)
+            name << "/overlap=" << overlap << "%";
+        return name.str();
+    }
+
+    void report(const string& name, long iters, double opsPerIter,
+                const Stopwatch& watch)
+    {
+        double ops = iters * opsPerIter;
+        cout << left << setw(48) << name << right
+             << setw(10) << iters
+             << setw(14) << fixed << setprecision(1)
+             << watch.seconds * 1e9 / ops
+             << setw(12) << setprecision(2) << watch.allocs / ops
+             << setw(14) << setprecision(0) << watch.bytes / ops;
+        if (watch.counters) {
+            for (int e = 0; e < IntSetCounters::NUM_EVENTS; ++e) {
+                IntSetCounters::Event event = IntSetCounters::Event(e);
+                if (watch.counters->available(event))
+                    cout << setw(14) << setprecision(2)
+                         << watch.counters->count(event) / ops;
+                else
+                    cout << setw(14) << "n/a";
+            }
+        }
+        cout << endl;
+    }
+
+    // Run body(watch) until min_time has been measured; returns the
+    // seconds taken by one iteration on average.
+    template <class Body>
+    double runCase(const Options& opt, const string& name, double opsPerIter,
+                   Body body)
+    {
+        Stopwatch watch(opt.counters);
+        long iters = 0;
+        do {
+            body(watch);
+            ++iters;
+        } while (watch.seconds < opt.min_time);
+        report(name, iters, opsPerIter, watch);
+        return watch.seconds / iters;
+    }
+
+    bool wanted(const Options& opt, const string& name)
+    {
+        return opt.filter.empty() || name.find(opt.filter) != string::npos;
+    }
+
+    // The operations on two IntSet's under test; the symmetric
+    // difference is computed both through temporaries and as one
+    // fused expression (see IntSetExpr.h).
+    enum Binary { UNION, INTERSECT, SUBTRACT, SUBSET, EQUAL,
+                  SYMDIFF_CHAINED, SYMDIFF_FUSED };
+    const char* const BINARY_NAMES[] =
+        { "unionWith", "intersect", "subtract", "isSubsetOf", "operator==",
+          "symdiff-chained", "symdiff-fused" };
+    const int NUM_BINARY = 7;
+
+    long runBinary(Binary op, const IntSet& lhs, const IntSet& rhs)
+    {
+        switch (op)
+        {
+        case UNION:
+            return lhs.unionWith(rhs).size();
+        case INTERSECT:
+            return lhs.intersect(rhs).size();
+        case SUBTRACT:
+            return lhs.subtract(rhs).size();
+        case SUBSET:
+            return lhs.isSubsetOf(rhs);
+        case SYMDIFF_CHAINED:
+            return lhs.unionWith(rhs).subtract(lhs.intersect(rhs)).size();
+        case SYMDIFF_FUSED:
+            return IntSet((lhs | rhs) - (lhs & rhs)).size();
+        default:
+            return lhs == rhs;
+        }
+    }
+
+    void benchDistribution(const Options& opt, Distribution dist,
+                           const vector<int>& sizes)
+    {
+        const int overlaps[] = { 0, 50, 100 };
+        // Per-operation "too slow, stop growing" flags: add, remove,
+        // copy, assignment and contains first, then each operation on
+        // two IntSet's once per overlap.
+        vector<bool> tooSlow(5 + NUM_BINARY * 3, false);
+
+        for (size_t s = 0; s < sizes.size(); ++s) {
+            int n = sizes[s];
+            mt19937 rng(12345u + unsigned(n) * 7u + unsigned(dist));
+
+            // 2n distinct values: the first n make lhs; rhs takes the
+            // last overlap% of lhs plus fresh values.
+            vector<int> values = makeValues(dist, 2 * n, rng);
+            IntSet lhs = makeSet(values, 0, n);
+
+            string name = caseName("add", dist, n, -1);
+            if (!tooSlow[0] && wanted(opt, name)) {
+                tooSlow[0] = runCase(opt, name, n, [&](Stopwatch& watch) {
+                    IntSet is;
+                    watch.start();
+                    for (int i = 0; i < n; ++i)
+                        is.add(values[i]);
+                    watch.stop();
+                    sink += is.size();
+                }) > opt.max_time;
+            }
+
+            name = caseName("remove", dist, n, -1);
+            if (!tooSlow[1] && wanted(opt, name)) {
+                vector<int> order(values.begin(), values.begin() + n);
+                shuffle(order.begin(), order.end(), rng);
+                tooSlow[1] = runCase(opt, name, n, [&](Stopwatch& watch) {
+                    // A copy shares lhs's storage until it changes; a
+                    // remove and add back make it copy now, so only the
+                    // removals are timed.
+                    IntSet is = lhs;
+                    is.remove(order[0]);
+                    is.add(order[0]);
+                    watch.start();
+                    for (int i = 0; i < n; ++i)
+                        is.remove(order[i]);
+                    watch.stop();
+                    sink += is.size();
+                }) > opt.max_time;
+            }
+
+            name = caseName("copy", dist, n, -1);
+            if (!tooSlow[2] && wanted(opt, name)) {
+                tooSlow[2] = runCase(opt, name, 1, [&](Stopwatch& watch) {
+                    watch.start();
+                    IntSet is(lhs);
+                    watch.stop();
+                    sink += is.size();
+                }) > opt.max_time;
+            }
+
+            name = caseName("assignment", dist, n, -1);
+            if (!tooSlow[3] && wanted(opt, name)) {
+                tooSlow[3] = runCase(opt, name, 1, [&](Stopwatch& watch) {
+                    IntSet is;
+                    watch.start();
+                    is = lhs;
+                    watch.stop();
+                    sink += is.size();
+                }) > opt.max_time;
+            }
+
+            for (int o = 0; o < 3; ++o) {
+                int shared = int((long long)n * overlaps[o] / 100);
+                IntSet rhs = makeSet(values, n - shared, 2 * n - shared);
+                vector<int> keys(values.begin() + n - shared,
+                                 values.begin() + 2 * n - shared);
+
+                name = caseName("contains", dist, n, overlaps[o]);
+                if (!tooSlow[4] && wanted(opt, name)) {
+                    tooSlow[4] = runCase(opt, name, n, [&](Stopwatch& watch) {
+                        long hits = 0;
+                        watch.start();
+                        for (int i = 0; i < n; ++i)
+                            hits += lhs.contains(keys[i]);
+                        watch.stop();
+                        sink += hits;
+                    }) > opt.max_time;
+                }
+
+                for (int b = 0; b < NUM_BINARY; ++b) {
+                    size_t flag = 5 + size_t(b) * 3 + size_t(o);
+                    name = caseName(BINARY_NAMES[b], dist, n, overlaps[o]);
+                    if (tooSlow[flag] || !wanted(opt, name))
+                        continue;
+                    tooSlow[flag] = runCase(opt, name, 1, [&](Stopwatch& watch) {
+                        watch.start();
+                        sink += runBinary(Binary(b), lhs, rhs);
+                        watch.stop();
+                    }) > opt.max_time;
+                }
+            }
+        }
+    }
+
+    // Every operation once, on the sets in lhsPath and rhsPath; add
+    // and remove replay lhs's members, contains looks up rhs's in lhs.
+    bool benchLoaded(const Options& opt, const string& lhsPath,
+                     const string& rhsPath)
+    {
+        vector<int> values, keys;
+        ifstream lhsIn(lhsPath.c_str(), ios::binary);
+        ifstream rhsIn(rhsPath.c_str(), ios::binary);
+        IntSet lhs, rhs;
+        if (!IntSetFile::loadMembers(lhsIn, values) ||
+            !IntSetFile::loadMembers(rhsIn, keys) ||
+            !IntSetFile::loadFile(lhsPath, lhs) ||
+            !IntSetFile::loadFile(rhsPath, rhs))
+            return false;
+        int n = int(lhs.size());
+        mt19937 rng(12345u);
+        stringstream suffix;
+        suffix << "/loaded/n=" << n;
+
+        string name = "add" + suffix.str();
+        if (wanted(opt, name)) {
+            runCase(opt, name, n, [&](Stopwatch& watch) {
+                IntSet is;
+                watch.start();
+                for (int i = 0; i < n; ++i)
+                    is.add(values[i]);
+                watch.stop();
+                sink += is.size();
+            });
+        }
+
+        name = "remove" + suffix.str();
+        if (wanted(opt, name)) {
+            vector<int> order(values);
+            shuffle(order.begin(), order.end(), rng);
+            runCase(opt, name, n, [&](Stopwatch& watch) {
+                IntSet is = lhs;
+                watch.start();
+                for (int i = 0; i < n; ++i)
+                    is.remove(order[i]);
+                watch.stop();
+                sink += is.size();
+            });
+        }
+
+        name = "copy" + suffix.str();
+        if (wanted(opt, name)) {
+            runCase(opt, name, 1, [&](Stopwatch& watch) {
+                watch.start();
+                IntSet is(lhs);
+                watch.stop();
+                sink += is.size();
+            });
+        }
+
+        name = "assignment" + suffix.str();
+        if (wanted(opt, name)) {
+            runCase(opt, name, 1, [&](Stopwatch& watch) {
+                IntSet is;
+                watch.start();
+                is = lhs;
+                watch.stop();
+                sink += is.size();
+            });
+        }
+
+        name = "contains" + suffix.str();
+        if (wanted(opt, name) && !keys.empty()) {
+            runCase(opt, name, double(keys.size()), [&](Stopwatch& watch) {
+                long hits = 0;
+                watch.start();
+                for (size_t i = 0; i < keys.size(); ++i)
+                    hits += lhs.contains(keys[i]);
+                watch.stop();
+                sink += hits;
+            });
+        }
+
+        for (int b = 0; b < NUM_BINARY; ++b) {
+            name = BINARY_NAMES[b] + suffix.str();
+            if (!wanted(opt, name))
+                continue;
+            runCase(opt, name, 1, [&](Stopwatch& watch) {
+                watch.start();
+                sink += runBinary(Binary(b), lhs, rhs);
+                watch.stop();
+            });
+        }
+        return true;
+    }
+
+    bool parseOption(const char* arg, const char* flag, string& value)
+    {
+        size_t len = strlen(flag);
+        if (strncmp(arg, flag, len) != 0 || arg[len] != '=')
+            return false;
+        value = arg + len + 1;
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    opt.max_size = 10000000;
+    opt.min_time = 0.2;
+    opt.max_time = 2.0;
+    opt.counters = false;
+    string setPaths;
+
+    for (int a = 1; a < argc; ++a) {
+        string value;
+        if (parseOption(argv[a], "--filter", value)) {
+            opt.filter = value;
+        } else if (parseOption(argv[a], "--max-size", value)) {
+            opt.max_size = atoi(value.c_str());
+        } else if (parseOption(argv[a], "--min-time", value)) {
+            opt.min_time = atof(value.c_str());
+        } else if (parseOption(argv[a], "--max-time", value)) {
+            opt.max_time = atof(value.c_str());
+        } else if (strcmp(argv[a], "--counters") == 0) {
+            opt.counters = true;
+        } else if (parseOption(argv[a], "--sets", value) &&
+                   value.find(',') != string::npos) {
+            setPaths = value;
+        } else if (parseOption(argv[a], "--pages", value)) {
+            if (value == "thp")
+                IntSetStorage::setPageMode(IntSetStorage::PAGES_TRANSPARENT);
+            else if (value == "hugetlb")
+                IntSetStorage::setPageMode(IntSetStorage::PAGES_HUGETLB);
+        } else {
+            cerr << "Unknown option " << argv[a] << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    vector<int> sizes;
+    for (int n = 1; n <= opt.max_size && n > 0; n *= 10)
+        sizes.push_back(n);
+
+    if (opt.counters && !IntSetCounters().anyAvailable())
+        cerr << "Hardware counters unavailable (no PMU, or "
+             << "perf_event_paranoid/seccomp forbids perf_event_open);"
+             << " wall-clock only" << endl;
+
+    cout << left << setw(48) << "case" << right << setw(10) << "iters"
+         << setw(14) << "ns/op" << setw(12) << "allocs/op"
+         << setw(14) << "bytes/op";
+    if (opt.counters) {
+        for (int e = 0; e < IntSetCounters::NUM_EVENTS; ++e)
+            cout << setw(14) << IntSetCounters::name(IntSetCounters::Event(e));
+    }
+    cout << endl;
+    if (!setPaths.empty()) {
+        size_t comma = setPaths.find(',');
+        if (!benchLoaded(opt, setPaths.substr(0, comma),
+                         setPaths.substr(comma + 1))) {
+            cerr << "Could not load " << setPaths << endl;
+            return EXIT_FAILURE;
+        }
+    } else {
+        for (int d = 0; d < NUM_DISTRIBUTIONS; ++d)
+            benchDistribution(opt, Distribution(d), sizes);
+    }
+
+    IntSetStorage::PageStats pages = IntSetStorage::pageStats();
+    if (pages.hugetlb_blocks + pages.advised_blocks + pages.fallback_blocks > 0)
+        cout << "huge pages: " << pages.hugetlb_blocks << " hugetlb, "
+             << pages.advised_blocks << " advised, "
+             << pages.fallback_blocks << " fallback blocks" << endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,267 @@
+// FILE: IntSetBuilder.cpp
+//       Implementation file for the IntSetBuilder class
+//       (See IntSetBuilder.h for documentation.)
+// INVARIANT for the IntSetBuilder class:
+// (1) buffers has one Buffer per producer (at least 1); the values
+//     pushed by producer p since the last build()/reset() are stored
+//     in buffers[p].values in push order (duplicates included).
+// (2) workers is the # of threads build() may use (at least 1).
+//
+// HOW build() WORKS:
+//   Every producer buffer is sorted and deduplicated on its own
+//   worker thread. The resulting sorted runs are then merged pairwise
+//   (run 0 with run 1, run 2 with run 3, ...), each pair on its own
+//   worker thread, until a single sorted duplicate-free run is left;
+//   this takes about log2(producers) rounds. For PRODUCER_ORDER every
+//   value carries its (producer, position) sequence # through the
+//   merges (the smallest one wins when duplicates meet), and the final
+//   run is re-sorted by sequence # with the same chunk-sort/pair-merge
+//   scheme. The final run is copied straight into the IntSet's data
+//   array (and its index rebuilt) since it is already known to be
+//   duplicate-free.
+
+#include "IntSetBuilder.h"
+#include "IntSetTrace.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+using namespace std;
+
+namespace
+{
+    // A pushed value tagged with where it was first pushed: its
+    // sequence # is the pair (producer, position in that producer's
+    // buffer), and a smaller one means earlier membership in
+    // PRODUCER_ORDER. (The pair is compared as a pair; a buffer may
+    // hold more than 2^32 values, so packing it into one 64-bit #
+    // could let positions spill into the producer.)
+    struct Entry
+    {
+        int value;
+        int producer;
+        size_t position;
+    };
+
+    bool bySeq(const Entry& lhs, const Entry& rhs)
+    {
+        return lhs.producer < rhs.producer ||
+               (lhs.producer == rhs.producer && lhs.position < rhs.position);
+    }
+
+    bool byValueThenSeq(const Entry& lhs, const Entry& rhs)
+    {
+        return lhs.value < rhs.value ||
+               (lhs.value == rhs.value && bySeq(lhs, rhs));
+    }
+
+    // Run task(0) .. task(tasks - 1) on up to workers threads (the
+    // calling thread is one of them).
+    template <class Task>
+    void runParallel(int tasks, int workers, Task task)
+    {
+        int nThreads = min(tasks, workers);
+        if (nThreads <= 1) {
+            for (int t = 0; t < tasks; ++t)
+                task(t);
+            return;
+        }
+
+        atomic<int> next(0);
+        auto worker = [&]() {
+            for (int t = next++; t < tasks; t = next++)
+                task(t);
+        };
+
+        vector<thread> pool;
+        for (int i = 1; i < nThreads; ++i)
+            pool.push_back(thread(worker));
+        worker();
+        for (size_t i = 0; i < pool.size(); ++i)
+            pool[i].join();
+    }
+
+    // Merge two sorted duplicate-free int runs into one.
+    void mergeRuns(const vector<int>& lhs, const vector<int>& rhs,
+                   vector<int>& out)
+    {
+        out.resize(lhs.size() + rhs.size());
+        out.erase(set_union(lhs.begin(), lhs.end(),
+                            rhs.begin(), rhs.end(), out.begin()),
+                  out.end());
+    }
+
+    // Merge two runs sorted by value (duplicate-free within each run)
+    // into one; when both runs hold a value, the earlier sequence # is kept.
+    void mergeRuns(const vector<Entry>& lhs, const vector<Entry>& rhs,
+                   vector<Entry>& out)
+    {
+        out.clear();
+        out.reserve(lhs.size() + rhs.size());
+        size_t i = 0, j = 0;
+        while (i < lhs.size() && j < rhs.size()) {
+            if (lhs[i].value < rhs[j].value) {
+                out.push_back(lhs[i++]);
+            } else if (rhs[j].value < lhs[i].value) {
+                out.push_back(rhs[j++]);
+            } else {
+                out.push_back(bySeq(lhs[i], rhs[j]) ? lhs[i] : rhs[j]);
+                ++i;
+                ++j;
+            }
+        }
+        out.insert(out.end(), lhs.begin() + i, lhs.end());
+        out.insert(out.end(), rhs.begin() + j, rhs.end());
+    }
+
+    // Merge a list of runs pairwise, in parallel, until one is left.
+    template <class T>
+    void mergeAll(vector< vector<T> >& runs, int workers)
+    {
+        while (runs.size() > 1) {
+            vector< vector<T> > merged((runs.size() + 1) / 2);
+            runParallel(int(merged.size()), workers, [&](int t) {
+                size_t lhs = 2 * size_t(t);
+                if (lhs + 1 < runs.size()) {
+                    mergeRuns(runs[lhs], runs[lhs + 1], merged[t]);
+                    vector<T>().swap(runs[lhs]);
+                    vector<T>().swap(runs[lhs + 1]);
+                } else {
+                    merged[t].swap(runs[lhs]);
+                }
+            });
+            runs.swap(merged);
+        }
+    }
+
+    // Sort entries by sequence #: sort one chunk per worker, then merge the
+    // chunks pairwise in parallel.
+    void sortBySeq(vector<Entry>& entries, int workers)
+    {
+        size_t nChunks = min(size_t(workers), entries.size());
+        if (nChunks <= 1) {
+            sort(entries.begin(), entries.end(), bySeq);
+            return;
+        }
+
+        vector<size_t> bounds(nChunks + 1);
+        for (size_t c = 0; c <= nChunks; ++c)
+            bounds[c] = entries.size() * c / nChunks;
+
+        runParallel(int(nChunks), workers, [&](int c) {
+            sort(entries.begin() + bounds[c], entries.begin() + bounds[c + 1],
+                 bySeq);
+        });
+
+        for (size_t width = 1; width < nChunks; width *= 2) {
+            size_t nPairs = (nChunks + 2 * width - 1) / (2 * width);
+            runParallel(int(nPairs), workers, [&](int p) {
+                size_t lo = 2 * width * size_t(p);
+                size_t mid = min(lo + width, nChunks);
+                size_t hi = min(lo + 2 * width, nChunks);
+                if (mid < hi)
+                    inplace_merge(entries.begin() + bounds[lo],
+                                  entries.begin() + bounds[mid],
+                                  entries.begin() + bounds[hi], bySeq);
+            });
+        }
+    }
+}
+
+IntSetBuilder::IntSetBuilder(int num_producers, int num_workers)
+    : buffers(num_producers >= 1 ? num_producers : 1), workers(num_workers)
+{
+    // Use every hardware thread unless told otherwise; the standard
+    // allows hardware_concurrency() to report 0 when it can't tell.
+    if (workers <= 0) { workers = int(thread::hardware_concurrency()); }
+    if (workers <= 0) { workers = 1; }
+}
+
+int IntSetBuilder::producers() const
+{
+    return int(buffers.size());
+}
+
+size_t IntSetBuilder::pending() const
+{
+    size_t total = 0;
+    for (size_t p = 0; p < buffers.size(); ++p)
+        total += buffers[p].values.size();
+    return total;
+}
+
+void IntSetBuilder::push(int producer, int anInt)
+{
+    buffers[producer].values.push_back(anInt);
+}
+
+void IntSetBuilder::push(int producer, const int* values, size_t n)
+{
+    buffers[producer].values.insert(buffers[producer].values.end(),
+                                    values, values + n);
+}
+
+IntSet IntSetBuilder::build(MemberOrder order)
+{
+    INTSET_TRACE_SCOPE("build", pending());
+
+    int nProducers = producers();
+    vector<int> members;
+
+    if (order == SORTED_ORDER) {
+
+        // Sort and deduplicate each buffer in place, then merge.
+        vector< vector<int> > runs(nProducers);
+        runParallel(nProducers, workers, [&](int p) {
+            vector<int>& run = runs[p];
+            run.swap(buffers[p].values);
+            sort(run.begin(), run.end());
+            run.erase(unique(run.begin(), run.end()), run.end());
+        });
+        mergeAll(runs, workers);
+        members.swap(runs[0]);
+
+    } else {
+
+        // Tag each value with its (producer, position) sequence #,
+        // keep the earliest copy of each value, merge, then put the
+        // survivors back into sequence order.
+        vector< vector<Entry> > runs(nProducers);
+        runParallel(nProducers, workers, [&](int p) {
+            vector<int>& values = buffers[p].values;
+            vector<Entry>& run = runs[p];
+            run.resize(values.size());
+            for (size_t i = 0; i < values.size(); ++i) {
+                run[i].value = values[i];
+                run[i].producer = p;
+                run[i].position = i;
+            }
+            vector<int>().swap(values);
+            sort(run.begin(), run.end(), byValueThenSeq);
+            size_t kept = 0;
+            for (size_t i = 0; i < run.size(); ++i)
+                if (kept == 0 || run[kept - 1].value != run[i].value)
+                    run[kept++] = run[i];
+            run.resize(kept);
+        });
+        mergeAll(runs, workers);
+        sortBySeq(runs[0], workers);
+
+        members.resize(runs[0].size());
+        for (size_t i = 0; i < members.size(); ++i)
+            members[i] = runs[0][i].value;
+    }
+
+    // Every member is already distinct, so skip add()'s lookups and
+    // copy the run straight into the new IntSet's data array.
+    IntSet result(members.size());
+    copy(members.begin(), members.end(), result.data);
+    result.used = members.size();
+    result.rebuildIndex();
+    return result;
+}
+
+void IntSetBuilder::reset()
+{
+    for (size_t p = 0; p < buffers.size(); ++p)
+        vector<int>().swap(buffers[p].values);
+}
@@ -0,0 +1,111 @@
+// FILE: IntSetBuilder.h - header file for IntSetBuilder class
+// CLASS PROVIDED: IntSetBuilder (a bulk loader that gathers int
+//                 values from many producer threads and builds
+//                 one IntSet from them)
+//
+// ENUMERATION
+//   enum MemberOrder { SORTED_ORDER, PRODUCER_ORDER }
+//     SORTED_ORDER:   members of the built IntSet have ascending
+//                     membership timing (data[0] is the smallest).
+//     PRODUCER_ORDER: members have the membership timing they would
+//                     have had if producer 0's values had been added
+//                     (in push order) first, then producer 1's, and
+//                     so on; i.e., the same IntSet a single thread
+//                     calling add would have built.
+//     Either order is deterministic: it depends only on what was
+//     pushed, never on thread scheduling.
+//
+// CONSTRUCTOR
+//   IntSetBuilder(int num_producers = 1, int num_workers = 0)
+//     Post: The invoking IntSetBuilder has num_producers empty
+//           producer buffers (at least 1) and uses num_workers
+//           threads in build(); if num_workers is <= 0, the number
+//           of hardware threads is used.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   int producers() const
+//     Post: Number of producer buffers is returned.
+//   size_t pending() const
+//     Pre:  No producer is pushing concurrently.
+//     Post: Total # of values pushed (duplicates included) since
+//           construction or the last reset()/build() is returned.
+//
+// MODIFICATION MEMBER FUNCTIONS (MUTATORS)
+//   void push(int producer, int anInt)
+//   void push(int producer, const int* values, size_t n)
+//     Pre:  0 <= producer < producers(); each producer # is used by
+//           at most one thread at a time (give every loader thread
+//           its own producer #, e.g. one per input file).
+//     Post: The value(s) have been appended to that producer's
+//           buffer. Duplicates are allowed and are removed by build().
+//   IntSet build(MemberOrder order = SORTED_ORDER)
+//     Pre:  No producer is pushing concurrently.
+//     Post: An IntSet holding every distinct value pushed is returned,
+//           with member order given by order. Buffers are sorted and
+//           deduplicated in parallel, then merged pairwise in parallel.
+//           All producer buffers are left empty.
+//   void reset()
+//     Pre:  No producer is pushing concurrently.
+//     Post: All producer buffers are emptied.
+//
+// VALUE SEMANTICS
+//   Assignment and the copy constructor may be used with
+//   IntSetBuilder objects.
+
+#ifndef INT_SET_BUILDER_H
+#define INT_SET_BUILDER_H
+
+#include "IntSet.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+class IntSetBuilder
+{
+public:
+   enum MemberOrder { SORTED_ORDER, PRODUCER_ORDER };
+   IntSetBuilder(int num_producers = 1, int num_workers = 0);
+   int producers() const;
+   size_t pending() const;
+   void push(int producer, int anInt);
+   void push(int producer, const int* values, size_t n);
+   IntSet build(MemberOrder order = SORTED_ORDER);
+   void reset();
+
+private:
+   // Each buffer has a cache line of its own so producers pushing to
+   // neighbouring buffers don't keep invalidating each other's vector
+   // headers.
+   struct alignas(64) Buffer
+   {
+      std::vector<int> values;
+   };
+
+   // Allocates on cache line boundaries (std::allocator only
+   // guarantees alignas(64) from C++17 on).
+   template <class T>
+   struct LineAllocator
+   {
+      typedef T value_type;
+      LineAllocator() {}
+      template <class U> LineAllocator(const LineAllocator<U>&) {}
+      T* allocate(std::size_t n)
+      {
+         void* block;
+         if (posix_memalign(&block, 64, n * sizeof(T)) != 0)
+            throw std::bad_alloc();
+         return static_cast<T*>(block);
+      }
+      void deallocate(T* block, std::size_t) { free(block); }
+      template <class U>
+      bool operator==(const LineAllocator<U>&) const { return true; }
+      template <class U>
+      bool operator!=(const LineAllocator<U>&) const { return false; }
+   };
+
+   std::vector<Buffer, LineAllocator<Buffer> > buffers;
+   int workers;
+};
+
+#endif
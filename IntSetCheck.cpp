@@ -0,0 +1,810 @@
+// FILE: IntSetCheck.cpp
+//       Correctness checks for IntSet and the classes built on it:
+//       each case drives the code under test and a plain reference
+//       model (for a set, a vector in membership order) through the
+//       same operations and fails on the first disagreement. CTest
+//       runs one case per test.
+//
+// USAGE: intset_check [case ...]
+//   case:  cases to run (default: all of them)
+//     marker:        INT_MIN (the index's unused-slot marker) as a
+//                    member, alone and among others
+//     erase:         random adds and removes, checking that removal
+//                    (backward-shift erase) never hides a member
+//     containsMany:  containsMany and containsManyMask against
+//                    contains, for small (scanned) and hashed sets
+//     file:          save and load through IntSetFile
+//     copy:          copies (which share storage until one changes)
+//                    staying as they were when the other changes
+//     builder:       IntSetBuilder in both member orders, with
+//                    duplicates within and across producers, pushed
+//                    from several threads and merged by several workers
+//     scheduler:     IntSetJob run in small steps, and IntSetScheduler's
+//                    sliced and offloaded jobs (with and without worker
+//                    threads), including a callback that throws
+//     shared:        IntSetShared: publish, attach, republish, refresh,
+//                    toIntSet and destroy, on a segment named after
+//                    this process (Linux only; elsewhere it passes)
+//     fixed:         FixedIntSet and BoundedIntSet: their bounds, a
+//                    full set, assign, and the expression operators
+//                    (with IntSet operands, and into themselves)
+//     basic:         BasicIntSet<T> for 8-, 16-, 32- and 64-bit T: the
+//                    lowest T (its marker) as a member, random adds
+//                    and removes, growth, containsMany (including keys
+//                    matching a member in one 32-bit half only), the
+//                    set algebra, and a capacity too large to address
+//
+// Exit status is 0 if every case run passed, otherwise 1.
+
+#include "IntSet.h"
+#include "IntSetBasic.h"
+#include "IntSetBuilder.h"
+#include "IntSetExpr.h"
+#include "IntSetFile.h"
+#include "IntSetFixed.h"
+#include "IntSetScheduler.h"
+#include "IntSetShared.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+using namespace std;
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char* const CASES[] = { "marker", "erase", "containsMany", "file",
+                                  "copy", "builder", "scheduler",
+                                  "shared", "fixed", "basic" };
+    const int NUM_CASES = int(sizeof(CASES) / sizeof(CASES[0]));
+
+    int failures = 0;
+
+    void expect(bool ok, const string& what)
+    {
+        if (!ok) {
+            cout << "  FAIL: " << what << endl;
+            ++failures;
+        }
+    }
+
+    string dump(const IntSet& is)
+    {
+        ostringstream out;
+        is.DumpData(out);
+        return out.str();
+    }
+
+    string dump(const vector<int>& members)
+    {
+        ostringstream out;
+        for (size_t i = 0; i < members.size(); ++i)
+            out << (i == 0 ? "" : "  ") << members[i];
+        return out.str();
+    }
+
+    // is has exactly model's members, in model's order.
+    bool matches(const IntSet& is, const vector<int>& model)
+    {
+        if (is.size() != model.size() || dump(is) != dump(model))
+            return false;
+        for (size_t i = 0; i < model.size(); ++i)
+            if (!is.contains(model[i]))
+                return false;
+        return true;
+    }
+
+    void checkMarker()
+    {
+        IntSet is;
+        expect(!is.contains(INT_MIN), "empty set has INT_MIN");
+        expect(is.add(INT_MIN) && !is.add(INT_MIN), "add INT_MIN");
+        expect(is.contains(INT_MIN) && is.size() == 1, "contains INT_MIN");
+        expect(dump(is) == dump(vector<int>(1, INT_MIN)), "dump INT_MIN");
+
+        // Among other members, including 0 and INT_MAX.
+        vector<int> model(1, INT_MIN);
+        for (int v : { 0, INT_MAX, -1, INT_MIN + 1 }) {
+            is.add(v);
+            model.push_back(v);
+        }
+        expect(matches(is, model), "INT_MIN among others");
+
+        IntSet copy(is), other;
+        other.add(INT_MIN);
+        expect(copy == is && other.isSubsetOf(is), "INT_MIN in copy");
+        expect(is.intersect(other).size() == 1 &&
+               is.subtract(other).size() == 4 &&
+               other.unionWith(is).size() == 5, "INT_MIN in set algebra");
+
+        int keys[3] = { INT_MIN, 7, 0 };
+        uint8_t found[3];
+        is.containsMany(keys, 3, found);
+        expect(found[0] == 1 && found[1] == 0 && found[2] == 1,
+               "containsMany with INT_MIN");
+
+        expect(is.remove(INT_MIN) && !is.remove(INT_MIN), "remove INT_MIN");
+        model.erase(model.begin());
+        expect(matches(is, model) && !is.contains(INT_MIN),
+               "after removing INT_MIN");
+
+        is.add(INT_MIN);
+        is.reset();
+        expect(is.isEmpty() && !is.contains(INT_MIN), "reset clears INT_MIN");
+    }
+
+    void checkErase()
+    {
+        // A narrow value range packs the index with long probe runs, so
+        // removals keep shifting entries back across them.
+        mt19937 rng(2024u);
+        for (int range : { 64, 1000, 100000 }) {
+            uniform_int_distribution<int> value(-range / 2, range / 2);
+            IntSet is;
+            vector<int> model;
+            for (int op = 0; op < 20000; ++op) {
+                int v = value(rng);
+                vector<int>::iterator at = find(model.begin(), model.end(), v);
+                bool member = at != model.end();
+                if (rng() % 3 == 0) {
+                    expect(is.remove(v) == member, "remove result");
+                    if (member)
+                        model.erase(at);
+                } else {
+                    expect(is.add(v) == !member, "add result");
+                    if (!member)
+                        model.push_back(v);
+                }
+                if (op % 1000 == 999) {
+                    expect(matches(is, model), "members after removes");
+                    for (int k = -range / 2; k <= range / 2; k += 1 + range / 500)
+                        expect(is.contains(k) ==
+                               (find(model.begin(), model.end(), k) != model.end()),
+                               "contains after removes");
+                }
+            }
+            if (failures > 0)
+                return;
+        }
+    }
+
+    void checkContainsMany()
+    {
+        mt19937 rng(7u);
+        for (int size : { 0, 1, 5, 16, 17, 100, 10000 }) {
+            IntSet is;
+            while (is.size() < size_t(size))
+                is.add(int(rng()));
+            if (size > 0)
+                is.add(INT_MIN);
+
+            // Half members, half (most likely) not; an odd count so
+            // the last mask word is partial.
+            vector<int> keys;
+            for (int k = 0; k < 1001; ++k)
+                keys.push_back(k % 2 == 0 && size > 0
+                               ? IntSetExprAccess::members(is)[rng() % is.size()]
+                               : int(rng()));
+            keys.push_back(INT_MIN);
+
+            vector<uint8_t> found(keys.size());
+            vector<uint64_t> mask((keys.size() + 63) / 64, ~0ULL);
+            is.containsMany(keys.data(), keys.size(), found.data());
+            is.containsManyMask(keys.data(), keys.size(), mask.data());
+            bool same = true;
+            for (size_t k = 0; k < keys.size(); ++k) {
+                bool hit = is.contains(keys[k]);
+                same &= found[k] == uint8_t(hit);
+                same &= ((mask[k / 64] >> (k % 64)) & 1) == uint64_t(hit);
+            }
+            same &= (mask.back() >> (keys.size() % 64)) == 0;
+            expect(same, "containsMany at size " + to_string(size));
+        }
+    }
+
+    void checkFile()
+    {
+        vector<IntSet> sets(3);
+        sets[1].add(INT_MIN);
+        sets[1].add(0);
+        mt19937 rng(99u);
+        while (sets[2].size() < 50000)
+            sets[2].add(int(rng()));
+
+        for (size_t s = 0; s < sets.size(); ++s) {
+            stringstream file;
+            expect(IntSetFile::save(sets[s], file), "save");
+            IntSet loaded;
+            loaded.add(42);
+            expect(IntSetFile::load(file, loaded) &&
+                   dump(loaded) == dump(sets[s]) && loaded == sets[s],
+                   "load gives back the set saved, in order");
+        }
+
+        // A truncated file is rejected and leaves the target alone.
+        stringstream file;
+        IntSetFile::save(sets[2], file);
+        string bytes = file.str();
+        stringstream truncated(bytes.substr(0, bytes.size() - 3));
+        IntSet target;
+        target.add(42);
+        expect(!IntSetFile::load(truncated, target) &&
+               target.size() == 1 && target.contains(42),
+               "truncated file rejected");
+    }
+
+    void checkCopy()
+    {
+        // Sizes on both sides of a resize: 100 members in a capacity
+        // of exactly 100, so the first add to a copy grows it.
+        vector<int> model;
+        IntSet source(100);
+        for (int v = 0; v < 100; ++v) {
+            source.add(v * 7 - 300);
+            model.push_back(v * 7 - 300);
+        }
+        vector<int> grown(model);
+        grown.push_back(INT_MIN);
+
+        // Each change to the source leaves the copy alone.
+        {
+            IntSet copy(source);
+            IntSet changed(source);
+            changed.add(INT_MIN);
+            expect(matches(changed, grown) && matches(copy, model) &&
+                   matches(source, model), "add to a copy");
+            changed.remove(model[0]);
+            expect(matches(copy, model) && matches(source, model),
+                   "remove from a copy");
+            changed.reset();
+            expect(changed.isEmpty() && matches(copy, model),
+                   "reset of a copy");
+        }
+        {
+            IntSet copy = source;
+            source.add(INT_MIN);
+            expect(matches(source, grown) && matches(copy, model),
+                   "add to the source");
+            source.remove(INT_MIN);
+        }
+
+        // Assignment shares too, and a copy of a copy outlives both.
+        IntSet assigned;
+        assigned.add(1);
+        assigned = source;
+        IntSet second(assigned);
+        assigned.remove(model[50]);
+        expect(!assigned.contains(model[50]) && matches(second, model) &&
+               matches(source, model), "remove from an assigned copy");
+        {
+            IntSet third(second);
+            second = IntSet();
+            expect(second.isEmpty() && matches(third, model),
+                   "copy of a copy");
+        }
+        source.reset();
+        expect(source.isEmpty() && assigned.size() == model.size() - 1,
+               "reset of the source");
+
+        // A change that doesn't change anything copies nothing.
+        IntSet a, b;
+        a.add(5);
+        b = a;
+        expect(!b.add(5) && !b.remove(6) && matches(a, vector<int>(1, 5)) &&
+               matches(b, vector<int>(1, 5)), "no-op changes");
+    }
+
+    void checkBuilder()
+    {
+        // Overlapping value ranges, so values repeat within a producer
+        // and across producers.
+        const int PRODUCERS = 5;
+        mt19937 rng(31u);
+        vector< vector<int> > pushed(PRODUCERS);
+        for (int p = 0; p < PRODUCERS; ++p) {
+            uniform_int_distribution<int> value(p * 1000, p * 1000 + 3000);
+            for (int i = 0; i < 4000 + 500 * p; ++i)
+                pushed[p].push_back(value(rng));
+        }
+        pushed[2].push_back(INT_MIN);
+        pushed[4].push_back(INT_MIN);
+
+        // What a single thread adding producer 0's values, then
+        // producer 1's, ... would build, and its members sorted.
+        vector<int> inOrder;
+        IntSet reference;
+        for (int p = 0; p < PRODUCERS; ++p)
+            for (size_t i = 0; i < pushed[p].size(); ++i)
+                if (reference.add(pushed[p][i]))
+                    inOrder.push_back(pushed[p][i]);
+        vector<int> sorted(inOrder);
+        sort(sorted.begin(), sorted.end());
+
+        size_t total = 0;
+        for (int p = 0; p < PRODUCERS; ++p)
+            total += pushed[p].size();
+
+        for (int workers : { 1, 4 }) {
+            IntSetBuilder builder(PRODUCERS, workers);
+            for (int order = 0; order < 2; ++order) {
+                // One thread per producer, half pushing one value at a
+                // time and half in bulk.
+                vector<thread> loaders;
+                for (int p = 0; p < PRODUCERS; ++p)
+                    loaders.push_back(thread([&builder, &pushed, p]() {
+                        if (p % 2 == 0)
+                            builder.push(p, pushed[p].data(),
+                                         pushed[p].size());
+                        else
+                            for (size_t i = 0; i < pushed[p].size(); ++i)
+                                builder.push(p, pushed[p][i]);
+                    }));
+                for (size_t t = 0; t < loaders.size(); ++t)
+                    loaders[t].join();
+                expect(builder.pending() == total, "pending");
+
+                string what = string(order == 0 ? "sorted" : "producer") +
+                              " order with " + to_string(workers) +
+                              " worker(s)";
+                IntSet built = builder.build(
+                    order == 0 ? IntSetBuilder::SORTED_ORDER
+                               : IntSetBuilder::PRODUCER_ORDER);
+                expect(matches(built, order == 0 ? sorted : inOrder), what);
+                expect(builder.pending() == 0, "buffers empty after build");
+            }
+
+            builder.push(0, 1);
+            builder.reset();
+            expect(builder.pending() == 0 && builder.build().isEmpty(),
+                   "reset");
+        }
+    }
+
+    // What the job for op on lhs and rhs must give.
+    IntSet expected(IntSetJob::Operation op, const IntSet& lhs,
+                    const IntSet& rhs)
+    {
+        return op == IntSetJob::UNION ? lhs.unionWith(rhs)
+             : op == IntSetJob::INTERSECT ? lhs.intersect(rhs)
+             : lhs.subtract(rhs);
+    }
+
+    void checkScheduler()
+    {
+        IntSet lhs, rhs;
+        for (int v = 0; v < 20000; ++v) {
+            lhs.add(v * 3);
+            rhs.add(v * 5);
+        }
+        rhs.add(INT_MIN);
+        const IntSetJob::Operation OPS[] = {
+            IntSetJob::UNION, IntSetJob::INTERSECT, IntSetJob::SUBTRACT
+        };
+
+        // Steps of a few elements, crossing from lhs into rhs mid-step.
+        for (IntSetJob::Operation op : OPS) {
+            IntSetJob job(op, lhs, rhs);
+            size_t steps = 0;
+            while (!job.step(7))
+                ++steps;
+            IntSet want = expected(op, lhs, rhs);
+            expect(steps > 1000 && job.result() == want &&
+                   dump(job.result()) == dump(want), "IntSetJob in steps");
+            expect(IntSetJob(op, lhs, rhs).step(SIZE_MAX), "one whole step");
+        }
+
+        for (int workers : { 0, 2 }) {
+            IntSetScheduler scheduler(workers);
+            atomic<int> wakeups(0);
+            scheduler.setWakeup([&wakeups]() { ++wakeups; });
+
+            // Offloaded jobs work on copies, so the operands may change
+            // right away; sliced ones on the operands themselves.
+            vector<IntSet> results(6);
+            IntSet changing(lhs);
+            for (int k = 0; k < 3; ++k) {
+                IntSet& out = results[k];
+                scheduler.offload(OPS[k], changing, rhs,
+                                  [&out](IntSet& r) { out.swap(r); });
+                scheduler.runSliced(OPS[k], lhs, rhs,
+                    [&results, k](IntSet& r) { results[3 + k].swap(r); });
+            }
+            changing.reset();
+            expect(scheduler.pending() == 6, "pending");
+
+            // A callback that throws is passed on; the others still run.
+            scheduler.offload(IntSetJob::UNION, lhs, rhs,
+                              [](IntSet&) { throw runtime_error("boom"); });
+            int thrown = 0;
+            for (int round = 0; round < 100000 && scheduler.pending() > 0;
+                 ++round) {
+                try {
+                    scheduler.poll(200);
+                } catch (const runtime_error&) {
+                    ++thrown;
+                }
+            }
+            expect(scheduler.pending() == 0 && thrown == 1,
+                   "every callback run with " + to_string(workers) +
+                   " worker(s)");
+            expect(workers == 0 || wakeups == 4, "wakeups");
+            for (int k = 0; k < 6; ++k) {
+                IntSet want = expected(OPS[k % 3], lhs, rhs);
+                expect(results[k] == want && dump(results[k]) == dump(want),
+                       "scheduled result");
+            }
+        }
+    }
+
+    void checkShared()
+    {
+#ifdef __linux__
+        string name = "/intset_check." + to_string(long(getpid()));
+        IntSetShared::destroy(name);   // left by an earlier run, if any
+
+        IntSet first, second;
+        for (int v = 0; v < 1000; ++v)
+            first.add(v * 11);
+        first.add(INT_MIN);
+        second.add(7);
+        second.add(-7);
+
+        IntSetShared reader, late;
+        expect(!reader.attach(name) && !reader.isAttached(),
+               "attach before publish");
+        expect(IntSetShared::publish(name, first), "publish");
+        expect(reader.attach(name) && reader.version() == 1 &&
+               !reader.isStale(), "attach");
+        expect(reader.size() == first.size() && reader.contains(INT_MIN) &&
+               reader.contains(990) && !reader.contains(991) &&
+               dump(reader.toIntSet()) == dump(first), "first version");
+
+        // Republishing leaves the reader on its snapshot until it
+        // refreshes.
+        expect(IntSetShared::publish(name, second), "republish");
+        expect(reader.isStale() && reader.version() == 1 &&
+               reader.contains(990), "stale snapshot");
+        expect(reader.refresh() && reader.version() == 2 &&
+               !reader.isStale() && !reader.refresh(), "refresh");
+        IntSet copy = reader.toIntSet();
+        expect(copy == second && dump(copy) == dump(second) &&
+               !reader.contains(990), "second version");
+
+        expect(late.attach(name) && late.version() == 2, "second reader");
+        expect(IntSetShared::destroy(name) && !IntSetShared::destroy(name),
+               "destroy");
+        IntSetShared after;
+        expect(!after.attach(name), "attach after destroy");
+        expect(late.contains(7) && reader.size() == 2,
+               "readers keep their mapping after destroy");
+        late.detach();
+        expect(!late.isAttached() && late.isEmpty(), "detach");
+#endif
+    }
+
+    template <class S>
+    vector<int> membersOf(const S& set)
+    {
+        IntSet is = set.toIntSet();
+        const int* members = IntSetExprAccess::members(is);
+        return vector<int>(members, members + is.size());
+    }
+
+    void checkFixed()
+    {
+        // FixedIntSet: at most N members, in membership order; 0 is a
+        // member only once added (unused slots hold 0).
+        FixedIntSet<4> fixed;
+        expect(fixed.isEmpty() && fixed.capacity() == 4 &&
+               !fixed.contains(0), "empty FixedIntSet");
+        expect(fixed.add(9) && fixed.add(0) && fixed.add(INT_MIN) &&
+               !fixed.add(9) && fixed.add(-3) && !fixed.add(5) &&
+               fixed.size() == 4, "FixedIntSet fills up");
+        expect(fixed.contains(0) && fixed.contains(INT_MIN) &&
+               !fixed.contains(5) && membersOf(fixed) ==
+               vector<int>({ 9, 0, INT_MIN, -3 }), "full FixedIntSet");
+        expect(fixed.remove(0) && !fixed.contains(0) && !fixed.remove(0) &&
+               fixed.add(5) && membersOf(fixed) ==
+               vector<int>({ 9, INT_MIN, -3, 5 }), "FixedIntSet remove");
+
+        IntSet small, big;
+        small.add(1);
+        small.add(2);
+        for (int v = 0; v < 5; ++v)
+            big.add(v);
+        FixedIntSet<4> other;
+        expect(!other.assign(big) && other.isEmpty(), "assign too many");
+        expect(other.assign(small) && membersOf(other) ==
+               vector<int>({ 1, 2 }), "assign an IntSet");
+
+        // Expressions mixing fixed sets and IntSets, evaluated into
+        // an IntSet and into a fixed set (which may be an operand).
+        IntSet mixed = (fixed | small) - big;
+        expect(dump(mixed) == dump(fixed.toIntSet().unionWith(small)
+                                   .subtract(big)), "FixedIntSet operand");
+        expect(other.assign(other | fixed) == false &&
+               membersOf(other) == vector<int>({ 1, 2 }),
+               "expression that doesn't fit");
+        expect(other.assign(fixed & (other | fixed)) &&
+               membersOf(other) == membersOf(fixed),
+               "expression into an operand");
+
+        // BoundedIntSet: Min through Max only, enumerated ascending.
+        BoundedIntSet<-10, 10> bounded;
+        expect(bounded.capacity() == 21 && bounded.add(10) &&
+               bounded.add(-10) && bounded.add(0) && !bounded.add(11) &&
+               !bounded.add(-11) && !bounded.add(0) && bounded.size() == 3,
+               "BoundedIntSet bounds");
+        expect(membersOf(bounded) == vector<int>({ -10, 0, 10 }) &&
+               bounded.remove(0) && !bounded.contains(0), "BoundedIntSet");
+        BoundedIntSet<-10, 10> all;
+        for (int v = -10; v <= 10; ++v)
+            all.add(v);
+        expect(all.size() == all.capacity() && !all.add(3), "full range");
+
+        IntSet outside(small);
+        outside.add(11);
+        expect(!bounded.assign(outside) &&
+               membersOf(bounded) == vector<int>({ -10, 10 }),
+               "assign out of range");
+        expect(bounded.assign(small) && bounded.size() == 2 &&
+               bounded.contains(1), "assign in range");
+        expect(bounded.assign((bounded | fixed) & all) &&
+               membersOf(bounded) == vector<int>({ -3, 1, 2, 5, 9 }),
+               "expression into a BoundedIntSet");
+        expect(!bounded.assign(bounded | big | outside) &&
+               bounded.size() == 5, "expression out of range");
+        IntSet fromBounded = bounded - small;
+        expect(dump(fromBounded) == dump(vector<int>({ -3, 5, 9 })),
+               "BoundedIntSet operand");
+
+        // The widest range, whose assign builds on the heap.
+        typedef BoundedIntSet<0, (1 << 24) - 1> Wide;
+        unique_ptr<Wide> wide(new Wide), also(new Wide);
+        wide->add((1 << 24) - 1);
+        also->assign(small);
+        expect(wide->assign(*wide | *also) && wide->size() == 3 &&
+               wide->contains((1 << 24) - 1) && wide->contains(2),
+               "widest BoundedIntSet");
+    }
+
+    // set has exactly model's members, in model's order.
+    template <class T>
+    bool matchesBasic(const BasicIntSet<T>& set, const vector<T>& model)
+    {
+        if (set.size() != model.size() ||
+            !equal(model.begin(), model.end(), set.members()))
+            return false;
+        for (size_t i = 0; i < model.size(); ++i)
+            if (!set.contains(model[i]))
+                return false;
+        return true;
+    }
+
+    template <class T>
+    bool inModel(const vector<T>& model, T value)
+    {
+        return find(model.begin(), model.end(), value) != model.end();
+    }
+
+    template <class T>
+    void checkBasicOf(const string& type)
+    {
+        typedef BasicIntSet<T> Set;
+        const T MARKER = numeric_limits<T>::min();
+        const size_t BITS = 8 * sizeof(T);
+        mt19937_64 rng(BITS);
+
+        // The marker as a member, alone and among others.
+        Set set;
+        expect(!set.contains(MARKER) && set.add(MARKER) &&
+               !set.add(MARKER) && set.contains(MARKER) &&
+               set.size() == 1, type + ": add the marker");
+        vector<T> model(1, MARKER);
+        for (T v : { T(MARKER + 1), T(MARKER + 2),
+                     numeric_limits<T>::max() }) {
+            set.add(v);
+            model.push_back(v);
+        }
+        expect(matchesBasic(set, model), type + ": marker among others");
+        Set marker;
+        marker.add(MARKER);
+        expect(set.intersect(marker).size() == 1 &&
+               set.subtract(marker).size() == 3 &&
+               marker.unionWith(set) == set && marker.isSubsetOf(set),
+               type + ": marker in set algebra");
+        expect(set.remove(MARKER) && !set.remove(MARKER) &&
+               !set.contains(MARKER), type + ": remove the marker");
+        model.erase(model.begin());
+        expect(matchesBasic(set, model), type + ": after removing it");
+        set.add(MARKER);
+        set.reset();
+        expect(set.isEmpty() && !set.contains(MARKER), type + ": reset");
+
+        // Random adds and removes over narrow ranges (starting at the
+        // marker), checking removal never hides a member; the widest
+        // range grows the set from its default capacity.
+        for (uint64_t range : { 64, 1000, 100000 }) {
+            const uint64_t HIGHEST =
+                numeric_limits<typename make_unsigned<T>::type>::max();
+            if (range - 1 > HIGHEST)
+                range = HIGHEST + 1;
+            Set grown;
+            model.clear();
+            size_t capacity = grown.capacity();
+            bool growing = true;
+            for (int op = 0; op < 20000; ++op) {
+                T v = T(uint64_t(MARKER) + rng() % range);
+                typename vector<T>::iterator at =
+                    find(model.begin(), model.end(), v);
+                bool member = at != model.end();
+                if (rng() % 3 == 0) {
+                    expect(grown.remove(v) == member, type + ": remove");
+                    if (member)
+                        model.erase(at);
+                } else {
+                    expect(grown.add(v) == !member, type + ": add");
+                    if (!member)
+                        model.push_back(v);
+                }
+                growing &= grown.capacity() >= capacity &&
+                           grown.capacity() >= grown.size();
+                capacity = grown.capacity();
+                if (op % 1000 == 999) {
+                    expect(matchesBasic(grown, model),
+                           type + ": members after removes");
+                    for (int k = 0; k < 200; ++k) {
+                        T probe = T(uint64_t(MARKER) + rng() % range);
+                        expect(grown.contains(probe) == inModel(model, probe),
+                               type + ": contains after removes");
+                    }
+                }
+            }
+            expect(growing && (range < 1000 || capacity > 100),
+                   type + ": growth");
+            Set copy(grown);
+            copy.add(T(uint64_t(MARKER) + range));
+            expect(matchesBasic(grown, model), type + ": copies are deep");
+            if (failures > 0)
+                return;
+        }
+
+        // containsMany against contains, scanned and hashed; the keys
+        // include members with a bit flipped in either half, which only
+        // a 64-bit comparison of both halves tells apart.
+        const size_t SCAN_LIMIT = 64 / sizeof(T);
+        for (size_t size : { size_t(0), size_t(1), SCAN_LIMIT - 1, SCAN_LIMIT,
+                             SCAN_LIMIT + 1, size_t(200) }) {
+            Set many;
+            while (many.size() < size)
+                many.add(T(rng()));
+            vector<T> keys(1, MARKER);
+            for (int k = 0; k < 301; ++k) {
+                T member = size > 0 ? many.members()[rng() % size] : T(0);
+                switch (k % 4) {
+                case 0:  keys.push_back(member); break;
+                case 1:  keys.push_back(T(member ^ (T(1) << (BITS - 1))));
+                         break;
+                case 2:  keys.push_back(T(member ^ T(1))); break;
+                default: keys.push_back(T(rng())); break;
+                }
+            }
+            vector<uint8_t> found(keys.size());
+            many.containsMany(keys.data(), keys.size(), found.data());
+            bool same = true;
+            for (size_t k = 0; k < keys.size(); ++k)
+                same &= found[k] == uint8_t(many.contains(keys[k]));
+            expect(same, type + ": containsMany at size " + to_string(size));
+        }
+
+        // The set algebra against the model, on overlapping ranges.
+        Set lhs, rhs;
+        vector<T> left, right;
+        for (int k = 0; k < 300; ++k) {
+            T a = T(uint64_t(MARKER) + rng() % 200);
+            T b = T(uint64_t(MARKER) + 100 + rng() % 150);
+            if (lhs.add(a))
+                left.push_back(a);
+            if (rhs.add(b))
+                right.push_back(b);
+        }
+        vector<T> both, only, all(left);
+        for (size_t i = 0; i < left.size(); ++i)
+            (inModel(right, left[i]) ? both : only).push_back(left[i]);
+        for (size_t i = 0; i < right.size(); ++i)
+            if (!inModel(left, right[i]))
+                all.push_back(right[i]);
+        expect(matchesBasic(lhs.unionWith(rhs), all), type + ": unionWith");
+        expect(matchesBasic(lhs.intersect(rhs), both), type + ": intersect");
+        expect(matchesBasic(lhs.subtract(rhs), only), type + ": subtract");
+        expect(lhs.intersect(rhs).isSubsetOf(rhs) && !lhs.isSubsetOf(rhs) &&
+               lhs.unionWith(rhs) == rhs.unionWith(lhs) &&
+               !(lhs == rhs), type + ": isSubsetOf and ==");
+        Set assigned;
+        assigned = lhs;
+        lhs.reset();
+        expect(matchesBasic(assigned, left) && lhs.isEmpty(),
+               type + ": assignment");
+
+        // A capacity beyond MAX_CAPACITY is clamped to it (and then,
+        // being far more than memory, fails to allocate).
+        try {
+            Set huge((size_t(1) << 62) + 1);
+            expect(huge.capacity() == Set::MAX_CAPACITY,
+                   type + ": huge capacity clamped");
+        } catch (const bad_alloc&) {
+        }
+    }
+
+    void checkBasic()
+    {
+        checkBasicOf<int8_t>("int8_t");
+        checkBasicOf<uint8_t>("uint8_t");
+        checkBasicOf<uint16_t>("uint16_t");
+        checkBasicOf<int32_t>("int32_t");
+        checkBasicOf<uint64_t>("uint64_t");
+    }
+
+    void runCase(const string& name)
+    {
+        if (name == "marker")
+            checkMarker();
+        else if (name == "erase")
+            checkErase();
+        else if (name == "containsMany")
+            checkContainsMany();
+        else if (name == "file")
+            checkFile();
+        else if (name == "copy")
+            checkCopy();
+        else if (name == "builder")
+            checkBuilder();
+        else if (name == "scheduler")
+            checkScheduler();
+        else if (name == "shared")
+            checkShared();
+        else if (name == "fixed")
+            checkFixed();
+        else if (name == "basic")
+            checkBasic();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    vector<string> chosen;
+    for (int a = 1; a < argc; ++a) {
+        int c = 0;
+        while (c < NUM_CASES && strcmp(argv[a], CASES[c]) != 0)
+            ++c;
+        if (c == NUM_CASES) {
+            cerr << "Unknown case " << argv[a] << endl;
+            return EXIT_FAILURE;
+        }
+        chosen.push_back(argv[a]);
+    }
+    if (chosen.empty())
+        chosen.assign(CASES, CASES + NUM_CASES);
+
+    for (size_t c = 0; c < chosen.size(); ++c) {
+        int before = failures;
+        runCase(chosen[c]);
+        cout << chosen[c] << (failures == before ? ": ok" : ": FAILED") << endl;
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
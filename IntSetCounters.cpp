@@ -0,0 +1,140 @@
+// FILE: IntSetCounters.cpp
+//       Implementation file for the IntSetCounters class
+//       (See IntSetCounters.h for documentation.)
+// NOTES on the implementation:
+// (1) Each event gets a descriptor of its own rather than one event
+//     group, so that a PMU which can't count one of them (LLC misses
+//     are often missing in VMs) doesn't take the others down with it.
+//     The price is that the events aren't guaranteed to be on the PMU
+//     over exactly the same intervals; count() scales each one by
+//     time enabled / time running to make up for that.
+// (2) The counters are never reset, only enabled and disabled, so
+//     count() is the total over every start()/stop() pair.
+
+#include "IntSetCounters.h"
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char* const EVENT_NAMES[IntSetCounters::NUM_EVENTS] = {
+        "cycles", "instructions", "L1d-misses", "LLC-misses", "br-misses"
+    };
+
+#ifdef __linux__
+    int openEvent(IntSetCounters::Event event)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        switch (event)
+        {
+        case IntSetCounters::CYCLES:
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case IntSetCounters::INSTRUCTIONS:
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case IntSetCounters::L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case IntSetCounters::LLC_MISSES:
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        default:
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        }
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // This thread, any CPU, no group.
+        long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        return fd < 0 ? -1 : int(fd);
+    }
+#endif
+}
+
+IntSetCounters::IntSetCounters()
+{
+    for (int e = 0; e < NUM_EVENTS; ++e) {
+#ifdef __linux__
+        fds[e] = openEvent(Event(e));
+#else
+        fds[e] = -1;
+#endif
+    }
+}
+
+IntSetCounters::~IntSetCounters()
+{
+#ifdef __linux__
+    for (int e = 0; e < NUM_EVENTS; ++e)
+        if (fds[e] >= 0)
+            close(fds[e]);
+#endif
+}
+
+bool IntSetCounters::available(Event event) const
+{
+    return fds[event] >= 0;
+}
+
+bool IntSetCounters::anyAvailable() const
+{
+    for (int e = 0; e < NUM_EVENTS; ++e)
+        if (fds[e] >= 0)
+            return true;
+    return false;
+}
+
+double IntSetCounters::count(Event event) const
+{
+#ifdef __linux__
+    // value, time enabled, time running (see read_format).
+    unsigned long long values[3];
+    if (fds[event] < 0 ||
+        read(fds[event], values, sizeof(values)) != ssize_t(sizeof(values)) ||
+        values[2] == 0)
+        return 0;
+    return double(values[0]) * double(values[1]) / double(values[2]);
+#else
+    (void)event;
+    return 0;
+#endif
+}
+
+void IntSetCounters::start()
+{
+#ifdef __linux__
+    for (int e = 0; e < NUM_EVENTS; ++e)
+        if (fds[e] >= 0)
+            ioctl(fds[e], PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+void IntSetCounters::stop()
+{
+#ifdef __linux__
+    for (int e = 0; e < NUM_EVENTS; ++e)
+        if (fds[e] >= 0)
+            ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+#endif
+}
+
+const char* IntSetCounters::name(Event event)
+{
+    return EVENT_NAMES[event];
+}
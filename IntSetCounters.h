@@ -0,0 +1,81 @@
+// FILE: IntSetCounters.h - header file for IntSetCounters class
+// CLASS PROVIDED: IntSetCounters (hardware performance counters for
+//                 the calling thread, read through Linux
+//                 perf_event_open, to tell whether a stretch of IntSet
+//                 work is bound by branch misses, cache misses or
+//                 neither)
+//
+// ENUMERATION
+//   enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES,
+//                BRANCH_MISSES, NUM_EVENTS }
+//     CYCLES:        CPU cycles.
+//     INSTRUCTIONS:  instructions retired.
+//     L1D_MISSES:    L1 data cache read misses.
+//     LLC_MISSES:    last-level cache misses.
+//     BRANCH_MISSES: mispredicted branches.
+//     Only user-space work of the calling thread is counted.
+//
+// CONSTRUCTOR
+//   IntSetCounters()
+//     Post: Every event the OS lets this process count has been set
+//           up (stopped, at 0). An event that can't be counted (not
+//           Linux, no PMU, e.g. in most containers and VMs, or
+//           perf_event_paranoid too strict) is simply unavailable;
+//           nothing is thrown.
+//
+// DESTRUCTOR
+//   ~IntSetCounters()
+//     Post: The counters have been closed.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   bool available(Event event) const
+//     Post: True is returned if event is being counted, otherwise
+//           false.
+//   bool anyAvailable() const
+//     Post: True is returned if at least one event is being counted.
+//   double count(Event event) const
+//     Post: # of event's occurrences while the counters were started
+//           is returned (summed over every start/stop); 0 if event is
+//           unavailable. If the kernel had to share the PMU with other
+//           counters, the count is scaled up from the time the event
+//           was actually on it.
+//
+// MODIFICATION MEMBER FUNCTIONS (MUTATORS)
+//   void start()
+//     Post: The available events are counted from now on.
+//   void stop()
+//     Post: The available events are no longer counted.
+//
+// STATIC MEMBER FUNCTIONS
+//   const char* name(Event event)
+//     Post: A short name for event (e.g. "cycles") is returned.
+//
+// VALUE SEMANTICS
+//   Assignment and the copy constructor may NOT be used with
+//   IntSetCounters objects.
+
+#ifndef INT_SET_COUNTERS_H
+#define INT_SET_COUNTERS_H
+
+class IntSetCounters
+{
+public:
+   enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES,
+                BRANCH_MISSES, NUM_EVENTS };
+   IntSetCounters();
+   ~IntSetCounters();
+   bool available(Event event) const;
+   bool anyAvailable() const;
+   double count(Event event) const;
+   void start();
+   void stop();
+   static const char* name(Event event);
+
+private:
+   IntSetCounters(const IntSetCounters&);
+   IntSetCounters& operator=(const IntSetCounters&);
+
+   int fds[NUM_EVENTS];   // perf event descriptors; -1 if unavailable
+};
+
+#endif
@@ -0,0 +1,302 @@
+// FILE: IntSetExpr.h - header file for IntSet set expressions
+// TEMPLATES PROVIDED: IntSetExpr<E> and its node types (lazy set
+//                     expressions over IntSet's, built with the
+//                     operators |, & and - and evaluated in one
+//                     fused pass into a single result IntSet)
+//
+// OPERATORS (each operand may be an IntSet or another expression)
+//   a | b    union of a and b         (as in a.unionWith(b))
+//   a & b    intersection of a and b  (as in a.intersect(b))
+//   a - b    difference of a and b    (as in a.subtract(b))
+//     Post: An expression object describing the operation is
+//           returned; nothing has been computed yet.
+//     Note: The usual C++ precedence applies (- binds tighter than
+//           &, which binds tighter than |), so a | b & c - d means
+//           a | (b & (c - d)); compilers warn about leaving that to
+//           precedence, so parenthesize.
+//
+// EVALUATION
+//   IntSet IntSetExpr<E>::eval() const
+//   IntSetExpr<E>::operator IntSet() const
+//     Post: The IntSet the expression describes is returned, with
+//           the same members in the same membership order as the
+//           equivalent chain of unionWith/intersect/subtract calls
+//           would give; e.g.
+//              IntSet r = (a | b) & (c - d);
+//           equals a.unionWith(b).intersect(c.subtract(d)).
+//     Note: The whole expression is evaluated in one pass: the
+//           result is the only IntSet allocated (sized from an upper
+//           bound on its size, so it is never resized), and no
+//           intermediate IntSet is built for a subexpression.
+//           Candidate members are streamed through the tree in
+//           batches, and membership tests against IntSet operands
+//           use containsMany.
+//
+// LIFETIME
+//   An expression refers to its IntSet operands rather than copying
+//   them, so it must be evaluated while they still exist; in
+//   practice, evaluate it in the statement that builds it (don't
+//   keep expressions in auto variables). Expression operands are
+//   held by value, so subexpressions never dangle. Evaluating into
+//   one of the operands (a = a | b) is fine: the result is built
+//   before the assignment.
+//
+// Each node type E provides (for use by the other nodes):
+//   size_t sizeBound() const
+//     Post: An upper bound on the size of the result (at most
+//           IntSet::MAX_CAPACITY) is returned.
+//   void test(const int* keys, int n, uint8_t* out) const
+//     Pre:  n <= IntSetExprAccess::BATCH
+//     Post: out[i] is 1 if keys[i] is a member of the result,
+//           otherwise 0.
+//   template <class Sink> void generate(Sink& sink) const
+//     Post: sink(members, n) has been called with the members of the
+//           result, in membership order, n <= IntSetExprAccess::BATCH
+//           at a time.
+
+#ifndef INT_SET_EXPR_H
+#define INT_SET_EXPR_H
+
+#include "IntSet.h"
+#include "IntSetTrace.h"
+#include <cstdint>
+#include <type_traits>
+
+// The only piece of the expression machinery IntSet befriends.
+class IntSetExprAccess
+{
+public:
+   static const int BATCH = 256;     // members streamed at a time
+   static const int* members(const IntSet& is) { return is.data; }
+   // Only into a set constructed to hold the result (no copy shares
+   // its storage), with room for anInt, which it doesn't have.
+   static void append(IntSet& is, int anInt) { is.append(anInt); }
+
+private:
+   IntSetExprAccess();
+};
+
+template <class E>
+class IntSetExpr
+{
+public:
+   const E& node() const { return static_cast<const E&>(*this); }
+   IntSet eval() const;
+   operator IntSet() const { return eval(); }
+};
+
+// An IntSet operand.
+class IntSetLeafExpr : public IntSetExpr<IntSetLeafExpr>
+{
+public:
+   explicit IntSetLeafExpr(const IntSet& is) : set(&is) {}
+   size_t sizeBound() const { return set->size(); }
+   void test(const int* keys, int n, uint8_t* out) const
+   {
+      set->containsMany(keys, size_t(n), out);
+   }
+   template <class Sink> void generate(Sink& sink) const
+   {
+      const int* members = IntSetExprAccess::members(*set);
+      size_t used = set->size(), batch = IntSetExprAccess::BATCH;
+      for (size_t begin = 0; begin < used; begin += batch) {
+         size_t n = used - begin < batch ? used - begin : batch;
+         sink(members + begin, int(n));
+      }
+   }
+
+private:
+   const IntSet* set;
+};
+
+// Passes on to sink the keys whose membership in filter is KEEP.
+template <class Filter, class Sink, bool KEEP>
+class IntSetFilterSink
+{
+public:
+   IntSetFilterSink(const Filter& f, Sink& s) : filter(f), sink(s) {}
+   void operator()(const int* keys, int n)
+   {
+      uint8_t found[IntSetExprAccess::BATCH];
+      int kept[IntSetExprAccess::BATCH];
+      int m = 0;
+      filter.test(keys, n, found);
+      for (int k = 0; k < n; ++k)
+         if (bool(found[k]) == KEEP)
+            kept[m++] = keys[k];
+      if (m > 0)
+         sink(kept, m);
+   }
+
+private:
+   const Filter& filter;
+   Sink&         sink;
+};
+
+template <class L, class R>
+class IntSetUnionExpr : public IntSetExpr<IntSetUnionExpr<L, R> >
+{
+public:
+   IntSetUnionExpr(const L& l, const R& r) : lhs(l), rhs(r) {}
+   size_t sizeBound() const
+   {
+      // Both bounds are at most MAX_CAPACITY, so this can't overflow.
+      size_t l = lhs.sizeBound(), r = rhs.sizeBound();
+      return r < IntSet::MAX_CAPACITY - l ? l + r : IntSet::MAX_CAPACITY;
+   }
+   void test(const int* keys, int n, uint8_t* out) const
+   {
+      uint8_t other[IntSetExprAccess::BATCH];
+      lhs.test(keys, n, out);
+      rhs.test(keys, n, other);
+      for (int k = 0; k < n; ++k)
+         out[k] |= other[k];
+   }
+   // lhs's members first, then rhs's that lhs doesn't have.
+   template <class Sink> void generate(Sink& sink) const
+   {
+      lhs.generate(sink);
+      IntSetFilterSink<L, Sink, false> fresh(lhs, sink);
+      rhs.generate(fresh);
+   }
+
+private:
+   L lhs;
+   R rhs;
+};
+
+template <class L, class R>
+class IntSetIntersectExpr : public IntSetExpr<IntSetIntersectExpr<L, R> >
+{
+public:
+   IntSetIntersectExpr(const L& l, const R& r) : lhs(l), rhs(r) {}
+   size_t sizeBound() const
+   {
+      size_t l = lhs.sizeBound(), r = rhs.sizeBound();
+      return l < r ? l : r;
+   }
+   void test(const int* keys, int n, uint8_t* out) const
+   {
+      uint8_t other[IntSetExprAccess::BATCH];
+      lhs.test(keys, n, out);
+      rhs.test(keys, n, other);
+      for (int k = 0; k < n; ++k)
+         out[k] &= other[k];
+   }
+   template <class Sink> void generate(Sink& sink) const
+   {
+      IntSetFilterSink<R, Sink, true> shared(rhs, sink);
+      lhs.generate(shared);
+   }
+
+private:
+   L lhs;
+   R rhs;
+};
+
+template <class L, class R>
+class IntSetSubtractExpr : public IntSetExpr<IntSetSubtractExpr<L, R> >
+{
+public:
+   IntSetSubtractExpr(const L& l, const R& r) : lhs(l), rhs(r) {}
+   size_t sizeBound() const { return lhs.sizeBound(); }
+   void test(const int* keys, int n, uint8_t* out) const
+   {
+      uint8_t other[IntSetExprAccess::BATCH];
+      lhs.test(keys, n, out);
+      rhs.test(keys, n, other);
+      for (int k = 0; k < n; ++k)
+         out[k] &= uint8_t(!other[k]);
+   }
+   template <class Sink> void generate(Sink& sink) const
+   {
+      IntSetFilterSink<R, Sink, false> unique(rhs, sink);
+      lhs.generate(unique);
+   }
+
+private:
+   L lhs;
+   R rhs;
+};
+
+// Appends every member generated to the result (which the bound
+// makes big enough, and which the nodes never give a member twice).
+class IntSetAppendSink
+{
+public:
+   explicit IntSetAppendSink(IntSet& r) : result(r) {}
+   void operator()(const int* members, int n)
+   {
+      for (int k = 0; k < n; ++k)
+         IntSetExprAccess::append(result, members[k]);
+   }
+
+private:
+   IntSet& result;
+};
+
+template <class E>
+IntSet IntSetExpr<E>::eval() const
+{
+   size_t bound = node().sizeBound();
+   INTSET_TRACE_SCOPE("expression", bound);
+   IntSet result(bound);
+   IntSetAppendSink sink(result);
+   node().generate(sink);
+   return result;
+}
+
+// What an operand of |, & or - becomes in the tree: an IntSet is
+// wrapped in a leaf, an expression is itself. Other types have no
+// Node, which takes the operators out of overload resolution.
+template <class T, class Enable = void>
+struct IntSetOperand
+{
+};
+
+template <>
+struct IntSetOperand<IntSet>
+{
+   typedef IntSetLeafExpr Node;
+   static Node wrap(const IntSet& is) { return Node(is); }
+};
+
+template <class T>
+struct IntSetOperand<T, typename std::enable_if<
+                           std::is_base_of<IntSetExpr<T>, T>::value>::type>
+{
+   typedef T Node;
+   static const T& wrap(const T& e) { return e; }
+};
+
+template <class L, class R>
+IntSetUnionExpr<typename IntSetOperand<L>::Node,
+                typename IntSetOperand<R>::Node>
+operator|(const L& lhs, const R& rhs)
+{
+   return IntSetUnionExpr<typename IntSetOperand<L>::Node,
+                          typename IntSetOperand<R>::Node>
+      (IntSetOperand<L>::wrap(lhs), IntSetOperand<R>::wrap(rhs));
+}
+
+template <class L, class R>
+IntSetIntersectExpr<typename IntSetOperand<L>::Node,
+                    typename IntSetOperand<R>::Node>
+operator&(const L& lhs, const R& rhs)
+{
+   return IntSetIntersectExpr<typename IntSetOperand<L>::Node,
+                              typename IntSetOperand<R>::Node>
+      (IntSetOperand<L>::wrap(lhs), IntSetOperand<R>::wrap(rhs));
+}
+
+template <class L, class R>
+IntSetSubtractExpr<typename IntSetOperand<L>::Node,
+                   typename IntSetOperand<R>::Node>
+operator-(const L& lhs, const R& rhs)
+{
+   return IntSetSubtractExpr<typename IntSetOperand<L>::Node,
+                             typename IntSetOperand<R>::Node>
+      (IntSetOperand<L>::wrap(lhs), IntSetOperand<R>::wrap(rhs));
+}
+
+#endif
@@ -0,0 +1,139 @@
+// FILE: IntSetFile.cpp
+//       Implementation file for the IntSetFile class
+//       (See IntSetFile.h for documentation.)
+// NOTES on the implementation:
+// (1) Members are converted to and from little-endian a block at a
+//     time through a small buffer, so saving or loading a big set
+//     never needs a second copy of it in memory.
+// (2) load builds the new set in a local IntSet sized from the header
+//     and only swaps it into place once the whole file has checked
+//     out, which is what leaves the caller's set alone on failure.
+//     The header's count is not trusted for the allocation beyond
+//     MAX_RESERVE members; past that the set grows as it is read.
+
+#include "IntSetFile.h"
+#include "IntSetTrace.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+using namespace std;
+
+namespace
+{
+    const char MAGIC[4] = { 'I', 'S', 'E', 'T' };
+    const size_t BLOCK = 4096;          // members per conversion block
+    const size_t MAX_RESERVE = size_t(1) << 24;
+
+    void putLittle(unsigned char* bytes, uint64_t value, int width)
+    {
+        for (int b = 0; b < width; ++b)
+            bytes[b] = static_cast<unsigned char>(value >> (8 * b));
+    }
+
+    uint64_t getLittle(const unsigned char* bytes, int width)
+    {
+        uint64_t value = 0;
+        for (int b = width - 1; b >= 0; --b)
+            value = (value << 8) | bytes[b];
+        return value;
+    }
+
+    // Read and check the header; the member count is returned
+    // through count. No set has more members than IntSet's
+    // MAX_CAPACITY.
+    bool readHeader(istream& in, size_t& count)
+    {
+        unsigned char header[16];
+        if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+            memcmp(header, MAGIC, 4) != 0 ||
+            getLittle(header + 4, 4) != IntSetFile::VERSION)
+            return false;
+        uint64_t n = getLittle(header + 8, 8);
+        if (n > uint64_t(IntSet::MAX_CAPACITY))
+            return false;
+        count = size_t(n);
+        return true;
+    }
+
+    // Read the next n members into out, through block.
+    bool readBlock(istream& in, unsigned char* block, size_t n, int* out)
+    {
+        if (!in.read(reinterpret_cast<char*>(block), streamsize(4 * n)))
+            return false;
+        for (size_t k = 0; k < n; ++k)
+            out[k] = int(int32_t(uint32_t(getLittle(block + 4 * k, 4))));
+        return true;
+    }
+}
+
+bool IntSetFile::save(const IntSet& is, ostream& out)
+{
+    INTSET_TRACE_SCOPE("save", is.used);
+
+    unsigned char header[16];
+    memcpy(header, MAGIC, 4);
+    putLittle(header + 4, VERSION, 4);
+    putLittle(header + 8, uint64_t(is.used), 8);
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    unsigned char block[BLOCK * 4];
+    for (size_t begin = 0; begin < is.used && out; begin += BLOCK) {
+        size_t n = is.used - begin < BLOCK ? is.used - begin : BLOCK;
+        for (size_t k = 0; k < n; ++k)
+            putLittle(block + 4 * k, uint32_t(is.data[begin + k]), 4);
+        out.write(reinterpret_cast<const char*>(block), streamsize(4 * n));
+    }
+    return bool(out);
+}
+
+bool IntSetFile::load(istream& in, IntSet& is)
+{
+    size_t total;
+    if (!readHeader(in, total))
+        return false;
+
+    INTSET_TRACE_SCOPE("load", total);
+    IntSet loaded(total < MAX_RESERVE ? total : MAX_RESERVE);
+    unsigned char block[BLOCK * 4];
+    int members[BLOCK];
+    for (size_t begin = 0; begin < total; begin += BLOCK) {
+        size_t n = total - begin < BLOCK ? total - begin : BLOCK;
+        if (!readBlock(in, block, n, members))
+            return false;
+        for (size_t k = 0; k < n; ++k)
+            if (!loaded.add(members[k]))
+                return false;   // a member twice: not a set
+    }
+    is.swap(loaded);
+    return true;
+}
+
+bool IntSetFile::loadMembers(istream& in, vector<int>& members)
+{
+    size_t total;
+    if (!readHeader(in, total))
+        return false;
+
+    members.reserve(members.size() + (total < MAX_RESERVE ? total : MAX_RESERVE));
+    unsigned char block[BLOCK * 4];
+    int read[BLOCK];
+    for (size_t begin = 0; begin < total; begin += BLOCK) {
+        size_t n = total - begin < BLOCK ? total - begin : BLOCK;
+        if (!readBlock(in, block, n, read))
+            return false;
+        members.insert(members.end(), read, read + n);
+    }
+    return true;
+}
+
+bool IntSetFile::saveFile(const IntSet& is, const string& path)
+{
+    ofstream out(path.c_str(), ios::binary);
+    return out && save(is, out);
+}
+
+bool IntSetFile::loadFile(const string& path, IntSet& is)
+{
+    ifstream in(path.c_str(), ios::binary);
+    return in && load(in, is);
+}
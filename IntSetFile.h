@@ -0,0 +1,58 @@
+// FILE: IntSetFile.h - header file for IntSetFile class
+// CLASS PROVIDED: IntSetFile (reads and writes IntSet's in a compact
+//                 binary format; a non-instantiable collection of
+//                 static functions)
+//
+// FORMAT (all integers little-endian, whatever the host)
+//   bytes 0-3:   magic "ISET"
+//   bytes 4-7:   format version (uint32, currently 1)
+//   bytes 8-15:  # of members n (uint64)
+//   then n int32's: the members, earliest membership first
+//   A file therefore holds exactly one IntSet, and loading it gives
+//   back the same members in the same membership order.
+//
+// STATIC MEMBER FUNCTIONS
+//   bool save(const IntSet& is, std::ostream& out)
+//     Pre:  out was opened in binary mode.
+//     Post: is has been written to out; true is returned if out is
+//           still good afterwards, otherwise false.
+//   bool load(std::istream& in, IntSet& is)
+//     Pre:  in was opened in binary mode.
+//     Post: If in holds a well-formed set (right magic and version,
+//           all n members present, no member twice), is has been
+//           replaced by it and true is returned; otherwise is is
+//           unchanged and false is returned.
+//   bool loadMembers(std::istream& in, std::vector<int>& members)
+//     Pre:  in was opened in binary mode.
+//     Post: Same as load, but the members are appended to members
+//           in membership order instead (e.g. to replay them as
+//           adds); duplicates are not checked for. On failure,
+//           members may have been partly appended to.
+//   bool saveFile(const IntSet& is, const std::string& path)
+//   bool loadFile(const std::string& path, IntSet& is)
+//     Post: Same as save/load on the file at path; false is also
+//           returned if the file can't be opened.
+
+#ifndef INT_SET_FILE_H
+#define INT_SET_FILE_H
+
+#include "IntSet.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+class IntSetFile
+{
+public:
+   static const unsigned VERSION = 1;
+   static bool save(const IntSet& is, std::ostream& out);
+   static bool load(std::istream& in, IntSet& is);
+   static bool loadMembers(std::istream& in, std::vector<int>& members);
+   static bool saveFile(const IntSet& is, const std::string& path);
+   static bool loadFile(const std::string& path, IntSet& is);
+
+private:
+   IntSetFile();
+};
+
+#endif
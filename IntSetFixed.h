@@ -0,0 +1,412 @@
+// FILE: IntSetFixed.h - header file for the fixed-size IntSet templates
+// TEMPLATES PROVIDED: FixedIntSet<N> (a set of at most N ints) and
+//                     BoundedIntSet<Min, Max> (a set of ints from Min
+//                     through Max); both keep their members inline,
+//                     in the object itself, and never allocate
+//
+// Both are meant for small, hot sets whose limits are known at
+// compile time (e.g. per-packet classification): declaring one costs
+// nothing but stack (or member) space, copying one is a memcpy, and
+// their loops have compile-time trip counts, so the compiler unrolls
+// and vectorizes them. They work with IntSet: each converts to an
+// IntSet, can be assigned from one, and can be an operand of the
+// IntSetExpr.h operators (|, & and -) alongside IntSet's; and an
+// expression can be evaluated straight into one, with no allocation
+// (save for BoundedIntSets over 64 KB; see assign).
+//
+// FixedIntSet<N>
+//   Members are kept in an array of N ints in membership order (as in
+//   IntSet), so lookups are a scan of all N slots; it suits small N
+//   (up to a few dozen).
+// BoundedIntSet<Min, Max>
+//   Membership is a bitmap of Max - Min + 1 bits, so lookups are one
+//   bit test whatever the size; it suits dense ranges (the object
+//   takes (Max - Min + 1) / 8 bytes, and the range may be at most
+//   MAX_RANGE wide). Members are enumerated in ascending order, NOT in
+//   membership order.
+//
+// CONSTRUCTOR (both)
+//   constexpr FixedIntSet()
+//   constexpr BoundedIntSet()
+//     Post: The invoking set is empty.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS, both)
+//   constexpr int size() const
+//   constexpr bool isEmpty() const
+//   constexpr int capacity() const
+//     Post: As for IntSet; the capacity is N, or Max - Min + 1.
+//   bool contains(int anInt) const         (constexpr for BoundedIntSet)
+//   void containsMany(const int* keys, size_t n, uint8_t* out) const
+//     Post: As for IntSet.
+//   IntSet toIntSet() const
+//   operator IntSet() const
+//     Post: An IntSet with the same members (in the order they are
+//           enumerated) is returned.
+//   template <class Sink> void generate(Sink& sink) const
+//     Post: sink(members, n) has been called with all members, in the
+//           order they are enumerated, n <= IntSetExprAccess::BATCH
+//           at a time (see IntSetExpr.h).
+//   const int* members() const                      (FixedIntSet only)
+//     Post: The members, in membership order, are returned.
+//
+// MODIFICATION MEMBER FUNCTIONS (MUTATORS, both)
+//   void reset()
+//     Post: The invoking set is empty.
+//   bool add(int anInt)
+//     Post: If anInt isn't a member and there is room for it (the
+//           FixedIntSet isn't full; anInt is within Min..Max), it has
+//           been added and true is returned; otherwise the invoking
+//           set is unchanged and false is returned.
+//   bool remove(int anInt)
+//     Post: As for IntSet.
+//   bool assign(const IntSet& is)
+//   template <class E> bool assign(const IntSetExpr<E>& expression)
+//     Post: If all the members of is (or of the value of expression)
+//           fit, the invoking set has been set to them and true is
+//           returned; otherwise it is unchanged and false is
+//           returned. The expression may refer to the invoking set
+//           itself. Evaluating it allocates nothing, except for a
+//           BoundedIntSet of over 64 KB, whose result is built in a
+//           heap temporary rather than on the stack.
+//
+// VALUE SEMANTICS (both)
+//   Assignment and the copy constructor may be used.
+
+#ifndef INT_SET_FIXED_H
+#define INT_SET_FIXED_H
+
+#include "IntSet.h"
+#include "IntSetExpr.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+template <int N>
+class FixedIntSet
+{
+public:
+   static_assert(N > 0, "FixedIntSet needs room for at least one member");
+
+   constexpr FixedIntSet() : data(), used(0) {}
+   constexpr int size() const { return used; }
+   constexpr bool isEmpty() const { return used == 0; }
+   constexpr int capacity() const { return N; }
+   const int* members() const { return data; }
+
+   bool contains(int anInt) const
+   {
+      // Unused slots hold 0, so only 0 needs to stop at used.
+      if (anInt == 0) {
+         for (int i = 0; i < used; ++i)
+            if (data[i] == 0)
+               return true;
+         return false;
+      }
+
+      // All N slots, without branching: a fixed trip count the
+      // compiler unrolls and vectorizes.
+      int hits = 0;
+      for (int i = 0; i < N; ++i)
+         hits |= data[i] == anInt;
+      return hits != 0;
+   }
+
+   void containsMany(const int* keys, size_t n, uint8_t* out) const
+   {
+      for (size_t k = 0; k < n; ++k)
+         out[k] = uint8_t(contains(keys[k]));
+   }
+
+   IntSet toIntSet() const
+   {
+      IntSet result(used);
+      for (int i = 0; i < used; ++i)
+         IntSetExprAccess::append(result, data[i]);
+      return result;
+   }
+   operator IntSet() const { return toIntSet(); }
+
+   template <class Sink> void generate(Sink& sink) const
+   {
+      for (int begin = 0; begin < used; begin += IntSetExprAccess::BATCH) {
+         int n = used - begin;
+         sink(data + begin, n < IntSetExprAccess::BATCH
+                            ? n : int(IntSetExprAccess::BATCH));
+      }
+   }
+
+   void reset()
+   {
+      memset(data, 0, sizeof data);
+      used = 0;
+   }
+
+   bool add(int anInt)
+   {
+      if (used == N || contains(anInt))
+         return false;
+      data[used++] = anInt;
+      return true;
+   }
+
+   bool remove(int anInt)
+   {
+      // Close the gap, keeping membership order, and clear the slot
+      // freed at the end (see contains).
+      for (int i = 0; i < used; ++i)
+         if (data[i] == anInt) {
+            memmove(data + i, data + i + 1, (used - i - 1) * sizeof(int));
+            data[--used] = 0;
+            return true;
+         }
+      return false;
+   }
+
+   bool assign(const IntSet& is)
+   {
+      if (is.size() > size_t(N))
+         return false;
+      reset();
+      memcpy(data, IntSetExprAccess::members(is), is.size() * sizeof(int));
+      used = int(is.size());
+      return true;
+   }
+
+   template <class E> bool assign(const IntSetExpr<E>& expression)
+   {
+      FixedIntSet result;
+      Collector collect(result);
+      expression.node().generate(collect);
+      if (!collect.fits)
+         return false;
+      *this = result;
+      return true;
+   }
+
+private:
+   // An IntSetExpr sink appending to a FixedIntSet (whose members it
+   // is never given twice) until it is full.
+   struct Collector
+   {
+      explicit Collector(FixedIntSet& s) : set(s), fits(true) {}
+      void operator()(const int* members, int n)
+      {
+         if (n > N - set.used) {
+            fits = false;
+            n = N - set.used;
+         }
+         memcpy(set.data + set.used, members, n * sizeof(int));
+         set.used += n;
+      }
+      FixedIntSet& set;
+      bool         fits;
+   };
+
+   int data[N];   // data[used..N-1] are 0
+   int used;
+};
+
+template <int Min, int Max>
+class BoundedIntSet
+{
+public:
+   static const long long MAX_RANGE = 1LL << 24;
+   static_assert(Min <= Max, "BoundedIntSet needs Min <= Max");
+   static_assert((long long)Max - Min < MAX_RANGE,
+                 "BoundedIntSet range too wide; use IntSet");
+
+   constexpr BoundedIntSet() : bits(), used(0) {}
+   constexpr int size() const { return used; }
+   constexpr bool isEmpty() const { return used == 0; }
+   constexpr int capacity() const { return RANGE; }
+
+   constexpr bool contains(int anInt) const
+   {
+      return Min <= anInt && anInt <= Max &&
+             ((bits[offset(anInt) / 64] >> (offset(anInt) % 64)) & 1) != 0;
+   }
+
+   void containsMany(const int* keys, size_t n, uint8_t* out) const
+   {
+      for (size_t k = 0; k < n; ++k)
+         out[k] = uint8_t(contains(keys[k]));
+   }
+
+   IntSet toIntSet() const
+   {
+      IntSet result(used);
+      IntSetAppendSink sink(result);
+      generate(sink);
+      return result;
+   }
+   operator IntSet() const { return toIntSet(); }
+
+   template <class Sink> void generate(Sink& sink) const
+   {
+      // Walk the set bits word by word, lowest first.
+      int batch[IntSetExprAccess::BATCH];
+      int n = 0;
+      for (int w = 0; w < WORDS; ++w)
+         for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+            batch[n++] = Min + w * 64 + lowestBit(word);
+            if (n == IntSetExprAccess::BATCH) {
+               sink(batch, n);
+               n = 0;
+            }
+         }
+      if (n > 0)
+         sink(batch, n);
+   }
+
+   void reset()
+   {
+      memset(bits, 0, sizeof bits);
+      used = 0;
+   }
+
+   bool add(int anInt)
+   {
+      if (anInt < Min || anInt > Max || contains(anInt))
+         return false;
+      bits[offset(anInt) / 64] |= uint64_t(1) << (offset(anInt) % 64);
+      ++used;
+      return true;
+   }
+
+   bool remove(int anInt)
+   {
+      if (!contains(anInt))
+         return false;
+      bits[offset(anInt) / 64] &= ~(uint64_t(1) << (offset(anInt) % 64));
+      --used;
+      return true;
+   }
+
+   bool assign(const IntSet& is)
+   {
+      // Check the range first, so the members go straight in (is has
+      // no duplicates, so every add then succeeds).
+      const int* members = IntSetExprAccess::members(is);
+      for (size_t i = 0; i < is.size(); ++i)
+         if (members[i] < Min || members[i] > Max)
+            return false;
+      reset();
+      for (size_t i = 0; i < is.size(); ++i)
+         add(members[i]);
+      return true;
+   }
+
+   template <class E> bool assign(const IntSetExpr<E>& expression)
+   {
+      return assignVia(expression, std::integral_constant<bool,
+                                      sizeof(BoundedIntSet) <= STACK_BYTES>());
+   }
+
+private:
+   static const int RANGE = int((long long)Max - Min + 1);
+   static const int WORDS = (RANGE + 63) / 64;
+   // The largest set assign builds its result in on the stack; a
+   // wider one (up to 2 MB, at MAX_RANGE) is built on the heap.
+   static const size_t STACK_BYTES = 64 * 1024;
+
+   // The expression may refer to the invoking set, so the result is
+   // built apart from it and then copied in.
+   template <class E>
+   bool assignVia(const IntSetExpr<E>& expression, std::true_type)
+   {
+      BoundedIntSet result;
+      return assignFrom(expression, result);
+   }
+   template <class E>
+   bool assignVia(const IntSetExpr<E>& expression, std::false_type)
+   {
+      std::unique_ptr<BoundedIntSet> result(new BoundedIntSet);
+      return assignFrom(expression, *result);
+   }
+   template <class E>
+   bool assignFrom(const IntSetExpr<E>& expression, BoundedIntSet& result)
+   {
+      Collector collect(result);
+      expression.node().generate(collect);
+      if (!collect.fits)
+         return false;
+      *this = result;
+      return true;
+   }
+
+   static constexpr unsigned offset(int anInt)
+   {
+      return unsigned((long long)anInt - Min);
+   }
+
+   static int lowestBit(uint64_t word)
+   {
+#if defined(__GNUC__)
+      return __builtin_ctzll(word);
+#else
+      int bit = 0;
+      while ((word & 1) == 0) {
+         word >>= 1;
+         ++bit;
+      }
+      return bit;
+#endif
+   }
+
+   // An IntSetExpr sink adding to a BoundedIntSet; notes any member
+   // out of range.
+   struct Collector
+   {
+      explicit Collector(BoundedIntSet& s) : set(s), fits(true) {}
+      void operator()(const int* members, int n)
+      {
+         for (int k = 0; k < n; ++k)
+            fits &= set.add(members[k]);
+      }
+      BoundedIntSet& set;
+      bool           fits;
+   };
+
+   uint64_t bits[WORDS];   // bit i: whether Min + i is a member
+   int      used;
+};
+
+// As an operand of the IntSetExpr.h operators, a fixed-size set is a
+// leaf like an IntSet (it has the containsMany and generate a leaf
+// needs).
+template <class S>
+class IntSetFixedLeafExpr : public IntSetExpr<IntSetFixedLeafExpr<S> >
+{
+public:
+   explicit IntSetFixedLeafExpr(const S& s) : set(&s) {}
+   size_t sizeBound() const { return size_t(set->size()); }
+   void test(const int* keys, int n, uint8_t* out) const
+   {
+      set->containsMany(keys, size_t(n), out);
+   }
+   template <class Sink> void generate(Sink& sink) const
+   {
+      set->generate(sink);
+   }
+
+private:
+   const S* set;
+};
+
+template <int N>
+struct IntSetOperand<FixedIntSet<N> >
+{
+   typedef IntSetFixedLeafExpr<FixedIntSet<N> > Node;
+   static Node wrap(const FixedIntSet<N>& s) { return Node(s); }
+};
+
+template <int Min, int Max>
+struct IntSetOperand<BoundedIntSet<Min, Max> >
+{
+   typedef IntSetFixedLeafExpr<BoundedIntSet<Min, Max> > Node;
+   static Node wrap(const BoundedIntSet<Min, Max>& s) { return Node(s); }
+};
+
+#endif
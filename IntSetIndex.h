@@ -0,0 +1,382 @@
+// FILE: IntSetIndex.h - header file for the IntSetIndex template
+// TEMPLATE PROVIDED: IntSetIndex<T> (the hash index, lookup and set
+//                    algebra kernels shared by IntSet, BasicIntSet<T>
+//                    and IntSetShared)
+//
+// Every set in the library keeps its members in membership order in
+// one array and indexes them in another: an open-addressing hash
+// table of T's, linear probing, a power-of-2 number of slots that is
+// at least twice the capacity (so it is never more than half full),
+// with the lowest T (MARKER) in the unused slots. MARKER itself can't
+// be stored in the index, so whether it is a member is kept apart (a
+// has_marker flag). The sets own and size their arrays; the code that
+// reads and writes them is here, once for every element type.
+//
+// T must be an integral type of 1, 2, 4 or 8 bytes. The hash is
+// 32-bit for types up to 32 bits wide and 64-bit for the others. The
+// scan of small sets is an SSE2 kernel for each width (plain C++
+// where SSE2 isn't available).
+//
+// CONSTANTS
+//   static const size_t MAX_CAPACITY
+//     The largest capacity whose index (and member array) can be
+//     addressed; sizeFor never overflows up to it.
+//   static const size_t SCAN_LIMIT = 64 / sizeof(T)
+//     Sets of at most this many members (one cache line of them) are
+//     scanned rather than looked up in the index.
+//   static const size_t BATCH = 256
+//     # of members the algebra kernels look up at a time.
+//
+// STATIC MEMBER FUNCTIONS
+//   static T marker()
+//     Post: MARKER, the lowest T, is returned.
+//   static size_t hash(T value)
+//     Post: value's bits, mixed so that runs of consecutive or
+//           equally-strided values spread evenly, are returned. (Part
+//           of IntSetShared's segment layout: don't change it without
+//           changing IntSetShared's LAYOUT.)
+//   static size_t sizeFor(size_t capacity)
+//     Pre:  capacity <= MAX_CAPACITY
+//     Post: The # of slots an index for capacity members has (the
+//           smallest power of 2, at least 8, that is >= 2 * capacity)
+//           is returned.
+//   static bool build(const T* members, size_t used, T* slots,
+//                     size_t num_slots)
+//     Pre:  members holds used distinct values; num_slots is a power
+//           of 2 >= 2 * used.
+//     Post: slots holds an index of exactly those members; whether
+//           MARKER is one of them is returned.
+//   static size_t find(const T* slots, size_t mask, T value)
+//     Pre:  value != MARKER; mask is the # of slots - 1.
+//     Post: The slot holding value is returned if it is indexed,
+//           otherwise the (unused) slot where it would go.
+//   static void eraseAt(T* slots, size_t mask, size_t hole)
+//     Pre:  slots[hole] holds a value (as found by find).
+//     Post: The value is no longer indexed; entries after it in the
+//           same probe run have been shifted back so no lookup will
+//           stop short of them.
+//   static void scanMany(const T* members, size_t used,
+//                        const T* keys, size_t n, uint8_t* out)
+//     Pre:  used <= SCAN_LIMIT
+//     Post: out[k] is 1 if keys[k] is one of the used members,
+//           otherwise 0 (for every k from 0 to n - 1).
+//   template <class OnProbe>
+//   static void probeMany(const T* slots, size_t num_slots,
+//                         bool has_marker, const T* keys, size_t n,
+//                         uint8_t* out, OnProbe on_probe)
+//     Post: As for scanMany, looking the keys up in the index
+//           (several at once, their slots prefetched ahead of the
+//           probes). on_probe(length) has been called with the # of
+//           slots each lookup of a key other than MARKER read.
+//   template <class Set>
+//   static size_t lookupAll(const T* keys, size_t n, const Set& set,
+//                           uint8_t* found)
+//     Post: found[k] is 1 if set has keys[k], otherwise 0 (looked up
+//           BATCH at a time with set.containsMany); the # of 1's is
+//           returned.
+//   template <class Set, class Keep>
+//   static void select(const T* keys, size_t n, const Set& set,
+//                      bool wanted, Keep keep)
+//     Post: keep(key) has been called, in order, for each of the keys
+//           that set has (if wanted) or doesn't have (if not).
+//   template <class Set>
+//   static bool allIn(const T* keys, size_t n, const Set& set)
+//     Post: True is returned if set has every one of the keys,
+//           otherwise false.
+
+#ifndef INT_SET_INDEX_H
+#define INT_SET_INDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// SSE2 lanes of each width: a key copied to every lane, and the lanes
+// of a vector of members equal to it (all bits set in each).
+template <size_t WIDTH> struct IntSetLanes;
+
+#if defined(__SSE2__)
+template <>
+struct IntSetLanes<1>
+{
+   static __m128i splat(uint64_t v) { return _mm_set1_epi8(char(v)); }
+   static __m128i equal(__m128i a, __m128i b)
+   {
+      return _mm_cmpeq_epi8(a, b);
+   }
+};
+
+template <>
+struct IntSetLanes<2>
+{
+   static __m128i splat(uint64_t v) { return _mm_set1_epi16(short(v)); }
+   static __m128i equal(__m128i a, __m128i b)
+   {
+      return _mm_cmpeq_epi16(a, b);
+   }
+};
+
+template <>
+struct IntSetLanes<4>
+{
+   static __m128i splat(uint64_t v) { return _mm_set1_epi32(int(v)); }
+   static __m128i equal(__m128i a, __m128i b)
+   {
+      return _mm_cmpeq_epi32(a, b);
+   }
+};
+
+template <>
+struct IntSetLanes<8>
+{
+   static __m128i splat(uint64_t v)
+   {
+      return _mm_set1_epi64x((long long)v);
+   }
+   // SSE2 compares 32 bits at most: a 64-bit lane is equal if both of
+   // its halves are.
+   static __m128i equal(__m128i a, __m128i b)
+   {
+      __m128i halves = _mm_cmpeq_epi32(a, b);
+      __m128i swapped = _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1));
+      return _mm_and_si128(halves, swapped);
+   }
+};
+#endif
+
+template <class T>
+class IntSetIndex
+{
+public:
+   static_assert(std::is_integral<T>::value &&
+                 (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 ||
+                  sizeof(T) == 8), "IntSetIndex holds 1- to 8-byte integers");
+
+   // Half the largest power of 2 of T's that can be addressed.
+   static const size_t MAX_CAPACITY =
+      ((std::numeric_limits<size_t>::max() / sizeof(T)) / 2 + 1) / 2;
+   static const size_t SCAN_LIMIT = 64 / sizeof(T);
+   static const size_t BATCH = 256;
+
+   static T marker() { return std::numeric_limits<T>::min(); }
+
+   static size_t hash(T value)
+   {
+      if (sizeof(T) <= 4) {
+         uint32_t h = uint32_t(value);
+         h ^= h >> 16;
+         h *= 0x85ebca6bu;
+         h ^= h >> 13;
+         h *= 0xc2b2ae35u;
+         h ^= h >> 16;
+         return h;
+      }
+      uint64_t h = uint64_t(value);
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdull;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ull;
+      h ^= h >> 33;
+      return size_t(h);
+   }
+
+   static size_t sizeFor(size_t capacity)
+   {
+      size_t size = MIN_SIZE;
+      while (size < 2 * capacity)
+         size *= 2;
+      return size;
+   }
+
+   static bool build(const T* members, size_t used, T* slots,
+                     size_t num_slots)
+   {
+      std::fill(slots, slots + num_slots, marker());
+      size_t mask = num_slots - 1;
+      bool has_marker = false;
+      for (size_t i = 0; i < used; ++i) {
+         if (members[i] == marker())
+            has_marker = true;
+         else
+            slots[find(slots, mask, members[i])] = members[i];
+      }
+      return has_marker;
+   }
+
+   static size_t find(const T* slots, size_t mask, T value)
+   {
+      size_t slot = hash(value) & mask;
+      while (slots[slot] != marker() && slots[slot] != value)
+         slot = (slot + 1) & mask;
+      return slot;
+   }
+
+   static void eraseAt(T* slots, size_t mask, size_t hole)
+   {
+      // Pull back every later entry of the probe run that may legally
+      // sit in the hole (its home slot is not between the hole and
+      // where it is now), moving the hole along.
+      size_t next = (hole + 1) & mask;
+      while (slots[next] != marker()) {
+         size_t home = hash(slots[next]) & mask;
+         if (((next - home) & mask) >= ((next - hole) & mask)) {
+            slots[hole] = slots[next];
+            hole = next;
+         }
+         next = (next + 1) & mask;
+      }
+      slots[hole] = marker();
+   }
+
+   static void scanMany(const T* members, size_t used, const T* keys,
+                        size_t n, uint8_t* out)
+   {
+#if defined(__SSE2__)
+      // The members fill at most one cache line: hold it in 4 vectors
+      // (zeros past used), compare each key against all of them at
+      // once and keep only the hits among the first used lanes.
+      typedef IntSetLanes<sizeof(T)> Lanes;
+      union Line
+      {
+         __m128i vectors[4];
+         T       values[SCAN_LIMIT];
+      } line;
+      for (int v = 0; v < 4; ++v)
+         line.vectors[v] = _mm_setzero_si128();
+      std::copy(members, members + used, line.values);
+      size_t bytes = used * sizeof(T);
+      uint64_t valid = bytes == 64 ? ~uint64_t(0)
+                                   : (uint64_t(1) << bytes) - 1;
+      for (size_t k = 0; k < n; ++k) {
+         __m128i key = Lanes::splat(uint64_t(keys[k]));
+         uint64_t hits = 0;
+         for (int v = 0; v < 4; ++v)
+            hits |= uint64_t(uint16_t(_mm_movemask_epi8(
+                        Lanes::equal(line.vectors[v], key)))) << (16 * v);
+         out[k] = uint8_t((hits & valid) != 0);
+      }
+#else
+      // Without branching, so the compiler can vectorize it.
+      for (size_t k = 0; k < n; ++k) {
+         T key = keys[k];
+         uint8_t hit = 0;
+         for (size_t i = 0; i < used; ++i)
+            hit |= uint8_t(members[i] == key);
+         out[k] = hit;
+      }
+#endif
+   }
+
+   template <class OnProbe>
+   static void probeMany(const T* slots, size_t num_slots, bool has_marker,
+                         const T* keys, size_t n, uint8_t* out,
+                         OnProbe on_probe)
+   {
+      // Keep the home slots of the next PREFETCH_DISTANCE keys in a
+      // ring, prefetching each one as it enters the ring, so the slot
+      // for keys[k] is (hopefully) cached by the time keys[k] is
+      // probed.
+      size_t mask = num_slots - 1;
+      size_t ahead[PREFETCH_DISTANCE];
+      size_t warm = std::min(n, PREFETCH_DISTANCE);
+      for (size_t k = 0; k < warm; ++k) {
+         ahead[k] = hash(keys[k]) & mask;
+         prefetch(slots + ahead[k]);
+      }
+      for (size_t k = 0; k < n; ++k) {
+         size_t slot = ahead[k & (PREFETCH_DISTANCE - 1)];
+         if (k + PREFETCH_DISTANCE < n) {
+            size_t next = hash(keys[k + PREFETCH_DISTANCE]) & mask;
+            ahead[k & (PREFETCH_DISTANCE - 1)] = next;
+            prefetch(slots + next);
+         }
+         T key = keys[k];
+         if (key == marker()) {
+            out[k] = uint8_t(has_marker);
+            continue;
+         }
+         size_t home = slot;
+         while (slots[slot] != marker() && slots[slot] != key)
+            slot = (slot + 1) & mask;
+         out[k] = uint8_t(slots[slot] == key);
+         on_probe(((slot - home) & mask) + 1);
+      }
+   }
+
+   template <class Set>
+   static size_t lookupAll(const T* keys, size_t n, const Set& set,
+                           uint8_t* found)
+   {
+      size_t hits = 0;
+      for (size_t begin = 0; begin < n; begin += BATCH) {
+         size_t count = std::min(BATCH, n - begin);
+         set.containsMany(keys + begin, count, found + begin);
+         for (size_t k = 0; k < count; ++k)
+            hits += found[begin + k];
+      }
+      return hits;
+   }
+
+   template <class Set, class Keep>
+   static void select(const T* keys, size_t n, const Set& set, bool wanted,
+                      Keep keep)
+   {
+      uint8_t found[BATCH];
+      for (size_t begin = 0; begin < n; begin += BATCH) {
+         size_t count = std::min(BATCH, n - begin);
+         set.containsMany(keys + begin, count, found);
+         for (size_t k = 0; k < count; ++k)
+            if ((found[k] != 0) == wanted)
+               keep(keys[begin + k]);
+      }
+   }
+
+   template <class Set>
+   static bool allIn(const T* keys, size_t n, const Set& set)
+   {
+      uint8_t found[BATCH];
+      for (size_t begin = 0; begin < n; begin += BATCH) {
+         size_t count = std::min(BATCH, n - begin);
+         set.containsMany(keys + begin, count, found);
+         for (size_t k = 0; k < count; ++k)
+            if (!found[k])
+               return false;
+      }
+      return true;
+   }
+
+private:
+   static const size_t MIN_SIZE = 8;
+   static const size_t PREFETCH_DISTANCE = 16;   // a power of 2
+
+   static void prefetch(const void* addr)
+   {
+#if defined(__GNUC__)
+      __builtin_prefetch(addr);
+#else
+      (void)addr;
+#endif
+   }
+
+   IntSetIndex();
+};
+
+template <class T> const size_t IntSetIndex<T>::MAX_CAPACITY;
+template <class T> const size_t IntSetIndex<T>::SCAN_LIMIT;
+template <class T> const size_t IntSetIndex<T>::BATCH;
+template <class T> const size_t IntSetIndex<T>::MIN_SIZE;
+template <class T> const size_t IntSetIndex<T>::PREFETCH_DISTANCE;
+
+// A probe-length callback that records nothing.
+struct IntSetNoProbe
+{
+   void operator()(size_t) const {}
+};
+
+#endif
@@ -0,0 +1,84 @@
+// FILE: IntSetJob.cpp
+//       Implementation file for the IntSetJob class
+//       (See IntSetJob.h for documentation.)
+// INVARIANT for the IntSetJob class:
+// (1) left and right point to the operands (lhs and rhs), kind is
+//     the operation, out holds the result so far.
+// (2) phase 0: left->data[0] through left->data[next - 1] have been
+//     processed (added to out if kind keeps them: always for UNION,
+//     only if in right for INTERSECT, only if not in right for
+//     SUBTRACT).
+//     phase 1 (UNION only): all of left and right->data[0] through
+//     right->data[next - 1] have been added to out.
+//     phase 2: the job is done.
+//     Walking left first (then right for UNION) gives out the same
+//     membership order the IntSet operations document.
+
+#include "IntSetJob.h"
+#include <chrono>
+using namespace std;
+
+namespace
+{
+    // # of elements processed between clock reads in runFor().
+    const size_t CLOCK_STRIDE = 4096;
+}
+
+IntSetJob::IntSetJob(Operation op, const IntSet& lhs, const IntSet& rhs)
+    : kind(op), left(&lhs), right(&rhs),
+      out(op == UNION ? lhs.size() + rhs.size() : lhs.size()),
+      phase(0), next(0)
+{
+}
+
+IntSetJob::Operation IntSetJob::operation() const
+{
+    return kind;
+}
+
+bool IntSetJob::isDone() const
+{
+    return phase == 2;
+}
+
+bool IntSetJob::step(size_t max_elements)
+{
+    while (max_elements > 0 && phase != 2) {
+
+        // Process the rest of the current operand, or as much of it
+        // as max_elements allows.
+        const IntSet* walked = (phase == 0) ? left : right;
+        size_t count = walked->used - next;
+        if (count > max_elements) { count = max_elements; }
+        max_elements -= count;
+
+        for (size_t stop = next + count; next < stop; ++next) {
+            int anInt = walked->data[next];
+            if (phase == 1 || kind == UNION ||
+                right->contains(anInt) == (kind == INTERSECT))
+                out.add(anInt);
+        }
+
+        // Move on once the operand is used up; only UNION has a
+        // second operand to walk.
+        if (next == walked->used) {
+            phase = (phase == 0 && kind == UNION) ? 1 : 2;
+            next = 0;
+        }
+    }
+    return isDone();
+}
+
+bool IntSetJob::runFor(long max_micros)
+{
+    chrono::steady_clock::time_point deadline =
+        chrono::steady_clock::now() + chrono::microseconds(max_micros);
+    while (!step(CLOCK_STRIDE) && chrono::steady_clock::now() < deadline)
+        ;
+    return isDone();
+}
+
+IntSet& IntSetJob::result()
+{
+    return out;
+}
@@ -0,0 +1,75 @@
+// FILE: IntSetJob.h - header file for IntSetJob class
+// CLASS PROVIDED: IntSetJob (a union, intersection or difference of
+//                 two IntSet's that is computed a few elements at a
+//                 time, so it can be spread over many short slices)
+//
+// ENUMERATION
+//   enum Operation { UNION, INTERSECT, SUBTRACT }
+//     Which of lhs.unionWith(rhs), lhs.intersect(rhs) or
+//     lhs.subtract(rhs) the job computes.
+//
+// CONSTRUCTOR
+//   IntSetJob(Operation op, const IntSet& lhs, const IntSet& rhs)
+//     Pre:  lhs and rhs outlive the job and are not modified until
+//           the job is done.
+//     Post: The invoking IntSetJob is ready to compute op on lhs and
+//           rhs; no elements have been processed yet.
+//     Note: The result's capacity is reserved up front (a single
+//           allocation plus clearing its hash index), so no step
+//           ever pauses to grow the result.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   Operation operation() const
+//     Post: The operation given at construction is returned.
+//   bool isDone() const
+//     Post: True is returned if every element of lhs and rhs has
+//           been processed (result() is then final), otherwise false
+//           is returned.
+//
+// MODIFICATION MEMBER FUNCTIONS (MUTATORS)
+//   bool step(size_t max_elements)
+//     Pre:  max_elements >= 1
+//     Post: Up to max_elements more operand elements have been
+//           processed; isDone() is returned.
+//   bool runFor(long max_micros)
+//     Post: Elements have been processed until the job was done or
+//           about max_micros microseconds had passed (the clock is
+//           checked every few thousand elements); isDone() is
+//           returned.
+//   IntSet& result()
+//     Post: The (possibly partial) result is returned. Once isDone()
+//           is true it is the same IntSet (same members, same
+//           membership order) that lhs.unionWith(rhs), lhs.intersect
+//           (rhs) or lhs.subtract(rhs) is documented to return. The
+//           caller may swap it out once the job is done.
+//
+// VALUE SEMANTICS
+//   Assignment and the copy constructor may be used with IntSetJob
+//   objects; the copy refers to the same operands.
+
+#ifndef INT_SET_JOB_H
+#define INT_SET_JOB_H
+
+#include "IntSet.h"
+
+class IntSetJob
+{
+public:
+   enum Operation { UNION, INTERSECT, SUBTRACT };
+   IntSetJob(Operation op, const IntSet& lhs, const IntSet& rhs);
+   Operation operation() const;
+   bool isDone() const;
+   bool step(size_t max_elements);
+   bool runFor(long max_micros);
+   IntSet& result();
+
+private:
+   Operation     kind;
+   const IntSet* left;
+   const IntSet* right;
+   IntSet        out;
+   int           phase;
+   size_t        next;
+};
+
+#endif
@@ -0,0 +1,109 @@
+// FILE: IntSetParallel.cpp
+//       Implementation file for the IntSetParallel class
+//       (See IntSetParallel.h for documentation.)
+
+#include "IntSetParallel.h"
+#include "IntSetStorage.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace
+{
+    // How often a scan checks whether another thread already settled
+    // the answer.
+    const size_t CANCEL_STRIDE = 4096;
+
+    // One contiguous piece of the scanned array and where to scan it.
+    struct Piece
+    {
+        size_t begin;
+        size_t end;
+        int    node;
+    };
+
+    // Cut data[0, used) of a capacity-element array into per-CPU
+    // pieces that follow IntSetStorage's per-node parts.
+    vector<Piece> cutPieces(size_t capacity, size_t used, int node_shift)
+    {
+        vector<Piece> pieces;
+        int nNodes = IntSetStorage::numaNodes();
+        for (int node = 0; node < nNodes; ++node) {
+            size_t begin, end;
+            IntSetStorage::partition(capacity, node, begin, end);
+            if (end > used) { end = used; }
+            if (begin >= end)
+                continue;
+
+            int nCpus = IntSetStorage::numaCpus(node);
+            int runNode = ((node + node_shift) % nNodes + nNodes) % nNodes;
+            for (int cpu = 0; cpu < nCpus; ++cpu) {
+                Piece piece;
+                piece.begin = begin + (end - begin) * cpu / nCpus;
+                piece.end = begin + (end - begin) * (cpu + 1) / nCpus;
+                piece.node = runNode;
+                if (piece.begin < piece.end)
+                    pieces.push_back(piece);
+            }
+        }
+        return pieces;
+    }
+
+    // Run scan(piece) for every piece, each on its own thread pinned to
+    // the piece's node (or inline if there is just one piece).
+    template <class Scan>
+    void scanPieces(const vector<Piece>& pieces, Scan scan)
+    {
+        if (pieces.size() == 1) {
+            scan(pieces[0]);
+            return;
+        }
+
+        vector<thread> pool;
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            pool.push_back(thread([&pieces, &scan, i]() {
+                IntSetStorage::pinToNode(pieces[i].node);
+                scan(pieces[i]);
+            }));
+        }
+        for (size_t i = 0; i < pool.size(); ++i)
+            pool[i].join();
+    }
+}
+
+bool IntSetParallel::isSubsetOf(const IntSet& sub, const IntSet& super,
+                                int node_shift)
+{
+    atomic<bool> missing(false);
+    const int* data = sub.data;
+
+    scanPieces(cutPieces(sub.cap, sub.used, node_shift),
+               [&](const Piece& piece) {
+        for (size_t i = piece.begin; i < piece.end; ++i) {
+            if ((i - piece.begin) % CANCEL_STRIDE == 0 && missing.load())
+                return;
+            if (!super.contains(data[i])) {
+                missing = true;
+                return;
+            }
+        }
+    });
+    return !missing;
+}
+
+size_t IntSetParallel::countCommon(const IntSet& lhs, const IntSet& rhs,
+                                   int node_shift)
+{
+    atomic<size_t> common(0);
+    const int* data = lhs.data;
+
+    scanPieces(cutPieces(lhs.cap, lhs.used, node_shift),
+               [&](const Piece& piece) {
+        size_t found = 0;
+        for (size_t i = piece.begin; i < piece.end; ++i)
+            found += rhs.contains(data[i]) ? 1 : 0;
+        common += found;
+    });
+    return common;
+}
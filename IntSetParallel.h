@@ -0,0 +1,47 @@
+// FILE: IntSetParallel.h - header file for IntSetParallel class
+// CLASS PROVIDED: IntSetParallel (multi-threaded scans over large
+//                 IntSet's; a non-instantiable collection of static
+//                 functions)
+//
+// HOW THE WORK IS SPLIT
+//   The scanned IntSet's data array is cut into the same per-node
+//   parts IntSetStorage::partition describes (the parts that
+//   IntSetStorage::NUMA_PARTITION places on each node). Each part is
+//   split again among the CPUs of its node, and every piece is
+//   scanned by a thread pinned to that node, so with NUMA_PARTITION
+//   storage every thread reads only node-local memory.
+//   node_shift moves every piece to the node node_shift places
+//   further on (wrapping around); 0 means "local". Anything else is
+//   only useful for measuring what remote access costs.
+//
+// STATIC MEMBER FUNCTIONS
+//   bool isSubsetOf(const IntSet& sub, const IntSet& super,
+//                   int node_shift = 0)
+//     Post: Same as sub.isSubsetOf(super).
+//   size_t countCommon(const IntSet& lhs, const IntSet& rhs,
+//                   int node_shift = 0)
+//     Post: # of elements lhs and rhs have in common (i.e., the size
+//           of lhs.intersect(rhs)) is returned; lhs is the IntSet
+//           that is scanned.
+//
+// NOTE
+//   The IntSet's involved must not be modified during a call.
+
+#ifndef INT_SET_PARALLEL_H
+#define INT_SET_PARALLEL_H
+
+#include "IntSet.h"
+
+class IntSetParallel
+{
+public:
+   static bool isSubsetOf(const IntSet& sub, const IntSet& super,
+                          int node_shift = 0);
+   static size_t countCommon(const IntSet& lhs, const IntSet& rhs,
+                             int node_shift = 0);
+
+private:
+   IntSetParallel();
+};
+
+#endif
@@ -0,0 +1,527 @@
+// FILE: IntSetQuery.cpp
+//       Implementation file for the IntSetQuery class
+//       (See IntSetQuery.h for documentation.)
+// INVARIANT for the IntSetQuery class:
+// (1) nodes holds every plan node built since the last compile();
+//     by_key maps each node's key to its index, so no two nodes have
+//     the same key (equal subexpressions are one node).
+// (2) Operands of a node always have smaller indices than the node,
+//     so nodes is in a valid evaluation order.
+// (3) An AND node has at least one operand in keep (its first is the
+//     one with the smallest estimate) and shares no operand between
+//     keep and drop; no operand in keep is an AND, and no operand
+//     in drop is an OR or EMPTY (they are flattened away). An OR node
+//     has at least two operands, none of them an OR or EMPTY, biggest
+//     estimate first.
+// (4) After a successful compile(), root is the plan's root node and
+//     message is empty; otherwise root is -1.
+// NOTES on the implementation:
+// (1) Parsing and rewriting are one step: the parser hands finished
+//     operand lists to makeAnd/makeOr, which apply de Morgan to the
+//     complements and build flattened, simplified, hash-consed nodes
+//     (andNode/orNode). The parser's Signed results therefore never
+//     hold a complement below the top of a subexpression.
+// (2) Keys list operands sorted by their own keys, so they don't
+//     depend on the order operands were written in, or on the
+//     (estimate) order they are evaluated in.
+
+#include "IntSetQuery.h"
+#include "IntSetExpr.h"
+#include "IntSetTrace.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <sstream>
+using namespace std;
+
+namespace
+{
+    const int BATCH = IntSetExprAccess::BATCH;
+
+    // Unions wider than this are not distributed over (the plan would
+    // grow with the product of the widths).
+    const size_t MAX_DISTRIBUTE = 8;
+    const size_t MAX_NODES = 10000;
+
+    bool isNameStart(char c)
+    {
+        return isalpha(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    bool isNameChar(char c)
+    {
+        return isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    // Keep (if keep_found) or drop the candidates that set has, moving
+    // the survivors to the front; the # of survivors is returned.
+    int filter(const IntSet& set, int* candidates, int n, bool keep_found)
+    {
+        uint8_t found[BATCH];
+        set.containsMany(candidates, size_t(n), found);
+        int m = 0;
+        for (int k = 0; k < n; ++k)
+            if (bool(found[k]) == keep_found)
+                candidates[m++] = candidates[k];
+        return m;
+    }
+}
+
+IntSetQuery::IntSetQuery() : root(-1), pos(0), depth(0)
+{
+}
+
+const string& IntSetQuery::error() const
+{
+    return message;
+}
+
+void IntSetQuery::define(const string& name, const IntSet& is)
+{
+    names[name] = &is;
+}
+
+bool IntSetQuery::compile(const string& expression)
+{
+    nodes.clear();
+    by_key.clear();
+    root = -1;
+    message.clear();
+    input = expression;
+    pos = 0;
+    depth = 0;
+
+    Signed result;
+    if (!parseExpr(result))
+        return false;
+    skipBlanks();
+    if (pos < input.size())
+        return fail(string("unexpected '") + input[pos] + "'");
+    if (result.negated) {
+        message = "the value is the complement of a finite set (no end)";
+        return false;
+    }
+    root = result.node;
+    return true;
+}
+
+bool IntSetQuery::fail(const string& why)
+{
+    ostringstream out;
+    out << why << " at column " << pos + 1;
+    message = out.str();
+    root = -1;
+    return false;
+}
+
+void IntSetQuery::skipBlanks()
+{
+    while (pos < input.size() && isspace(static_cast<unsigned char>(input[pos])))
+        ++pos;
+}
+
+bool IntSetQuery::parseExpr(Signed& out)
+{
+    vector<Signed> operands(1);
+    if (!parseTerm(operands[0]))
+        return false;
+    for (skipBlanks(); pos < input.size() && input[pos] == '|'; skipBlanks()) {
+        ++pos;
+        operands.push_back(Signed());
+        if (!parseTerm(operands.back()))
+            return false;
+    }
+    out = operands.size() == 1 ? operands[0] : makeOr(operands);
+    return true;
+}
+
+bool IntSetQuery::parseTerm(Signed& out)
+{
+    vector<Signed> operands(1);
+    if (!parseDiff(operands[0]))
+        return false;
+    for (skipBlanks(); pos < input.size() && input[pos] == '&'; skipBlanks()) {
+        ++pos;
+        operands.push_back(Signed());
+        if (!parseDiff(operands.back()))
+            return false;
+    }
+    out = operands.size() == 1 ? operands[0] : makeAnd(operands);
+    return true;
+}
+
+bool IntSetQuery::parseDiff(Signed& out)
+{
+    // a - b - c is a & ~b & ~c.
+    vector<Signed> operands(1);
+    if (!parseUnary(operands[0]))
+        return false;
+    for (skipBlanks(); pos < input.size() && input[pos] == '-'; skipBlanks()) {
+        ++pos;
+        operands.push_back(Signed());
+        if (!parseUnary(operands.back()))
+            return false;
+        operands.back().negated = !operands.back().negated;
+    }
+    out = operands.size() == 1 ? operands[0] : makeAnd(operands);
+    return true;
+}
+
+bool IntSetQuery::parseUnary(Signed& out)
+{
+    skipBlanks();
+    if (pos == input.size())
+        return fail("expression ends too soon");
+
+    // The parser recurses once per level of nesting, so the nesting
+    // is limited before the stack is.
+    if ((input[pos] == '~' || input[pos] == '(') && depth == MAX_DEPTH)
+        return fail("expression nested too deeply");
+
+    if (input[pos] == '~') {
+        ++pos;
+        ++depth;
+        if (!parseUnary(out))
+            return false;
+        --depth;
+        out.negated = !out.negated;
+        return true;
+    }
+    if (input[pos] == '(') {
+        ++pos;
+        ++depth;
+        if (!parseExpr(out))
+            return false;
+        --depth;
+        skipBlanks();
+        if (pos == input.size() || input[pos] != ')')
+            return fail("missing ')'");
+        ++pos;
+        return true;
+    }
+    if (!isNameStart(input[pos]))
+        return fail(string("unexpected '") + input[pos] + "'");
+
+    size_t start = pos;
+    while (pos < input.size() && isNameChar(input[pos]))
+        ++pos;
+    string name = input.substr(start, pos - start);
+    map<string, const IntSet*>::const_iterator it = names.find(name);
+    if (it == names.end()) {
+        pos = start;
+        return fail("unknown set " + name);
+    }
+
+    Node leaf;
+    leaf.kind = LEAF;
+    leaf.set = it->second;
+    leaf.estimate = it->second->size();
+    leaf.key = name;
+    leaf.text = name;
+    out.node = intern(leaf);
+    out.negated = false;
+    return true;
+}
+
+IntSetQuery::Signed IntSetQuery::makeAnd(const vector<Signed>& operands)
+{
+    vector<int> plain, complemented;
+    for (size_t i = 0; i < operands.size(); ++i)
+        (operands[i].negated ? complemented : plain).push_back(operands[i].node);
+
+    // ~a & ~b = ~(a | b)
+    Signed result;
+    result.negated = plain.empty();
+    result.node = plain.empty() ? orNode(complemented)
+                                : andNode(plain, complemented);
+    return result;
+}
+
+IntSetQuery::Signed IntSetQuery::makeOr(const vector<Signed>& operands)
+{
+    vector<int> plain, complemented;
+    for (size_t i = 0; i < operands.size(); ++i)
+        (operands[i].negated ? complemented : plain).push_back(operands[i].node);
+
+    // p | ~n = ~(n & ~p) = ~(n - p)
+    Signed result;
+    result.negated = !complemented.empty();
+    result.node = complemented.empty() ? orNode(plain)
+                                       : andNode(complemented, plain);
+    return result;
+}
+
+int IntSetQuery::andNode(vector<int> keep, vector<int> drop)
+{
+    // x & (a - b) = x & a - b;  x - (a | b) = x - a - b
+    Node node;
+    node.kind = AND;
+    node.set = NULL;
+    for (size_t i = 0; i < keep.size(); ++i) {
+        const Node& operand = nodes[keep[i]];
+        if (operand.kind == EMPTY)
+            return emptyNode();
+        if (operand.kind == AND) {
+            node.keep.insert(node.keep.end(), operand.keep.begin(), operand.keep.end());
+            node.drop.insert(node.drop.end(), operand.drop.begin(), operand.drop.end());
+        } else {
+            node.keep.push_back(keep[i]);
+        }
+    }
+    for (size_t i = 0; i < drop.size(); ++i) {
+        const Node& operand = nodes[drop[i]];
+        if (operand.kind == OR)
+            node.drop.insert(node.drop.end(), operand.keep.begin(), operand.keep.end());
+        else if (operand.kind != EMPTY)
+            node.drop.push_back(drop[i]);
+    }
+
+    // x & x = x;  x - x = {}
+    sort(node.keep.begin(), node.keep.end());
+    node.keep.erase(unique(node.keep.begin(), node.keep.end()), node.keep.end());
+    sort(node.drop.begin(), node.drop.end());
+    node.drop.erase(unique(node.drop.begin(), node.drop.end()), node.drop.end());
+    for (size_t i = 0; i < node.drop.size(); ++i)
+        if (binary_search(node.keep.begin(), node.keep.end(), node.drop[i]))
+            return emptyNode();
+
+    // s & (a | b) = (s & a) | (s & b), worth it when s is the smaller.
+    int widest = -1;
+    for (size_t i = 0; i < node.keep.size(); ++i) {
+        const Node& operand = nodes[node.keep[i]];
+        if (operand.kind == OR && operand.keep.size() <= MAX_DISTRIBUTE &&
+            (widest < 0 || operand.estimate > nodes[widest].estimate))
+            widest = node.keep[i];
+    }
+    if (widest >= 0 && nodes.size() < MAX_NODES) {
+        bool smaller = false;
+        for (size_t i = 0; i < node.keep.size(); ++i)
+            if (node.keep[i] != widest &&
+                nodes[node.keep[i]].estimate < nodes[widest].estimate)
+                smaller = true;
+        if (smaller) {
+            vector<int> others;
+            for (size_t i = 0; i < node.keep.size(); ++i)
+                if (node.keep[i] != widest)
+                    others.push_back(node.keep[i]);
+            vector<int> alternatives = nodes[widest].keep, branches;
+            for (size_t i = 0; i < alternatives.size(); ++i) {
+                vector<int> branch(others);
+                branch.push_back(alternatives[i]);
+                branches.push_back(andNode(branch, node.drop));
+            }
+            return orNode(branches);
+        }
+    }
+
+    if (node.keep.size() == 1 && node.drop.empty())
+        return node.keep[0];
+    node.key = "(&" + keyList(node.keep) + " -" + keyList(node.drop) + ")";
+    sortByEstimate(node.keep, true);
+    sortByEstimate(node.drop, false);
+    node.estimate = nodes[node.keep[0]].estimate;
+    return intern(node);
+}
+
+int IntSetQuery::orNode(vector<int> operands)
+{
+    Node node;
+    node.kind = OR;
+    node.set = NULL;
+    node.estimate = 0;
+    for (size_t i = 0; i < operands.size(); ++i) {
+        const Node& operand = nodes[operands[i]];
+        if (operand.kind == OR)
+            node.keep.insert(node.keep.end(), operand.keep.begin(), operand.keep.end());
+        else if (operand.kind != EMPTY)
+            node.keep.push_back(operands[i]);
+    }
+
+    // x | x = x
+    sort(node.keep.begin(), node.keep.end());
+    node.keep.erase(unique(node.keep.begin(), node.keep.end()), node.keep.end());
+    if (node.keep.empty())
+        return emptyNode();
+    if (node.keep.size() == 1)
+        return node.keep[0];
+
+    for (size_t i = 0; i < node.keep.size(); ++i)
+        node.estimate += nodes[node.keep[i]].estimate;
+    node.key = "(|" + keyList(node.keep) + ")";
+    sortByEstimate(node.keep, false);
+    return intern(node);
+}
+
+int IntSetQuery::emptyNode()
+{
+    Node node;
+    node.kind = EMPTY;
+    node.set = NULL;
+    node.estimate = 0;
+    node.key = "{}";
+    return intern(node);
+}
+
+int IntSetQuery::intern(const Node& node)
+{
+    map<string, int>::const_iterator it = by_key.find(node.key);
+    if (it != by_key.end())
+        return it->second;
+    nodes.push_back(node);
+    by_key[node.key] = int(nodes.size()) - 1;
+    return int(nodes.size()) - 1;
+}
+
+string IntSetQuery::keyList(const vector<int>& operands) const
+{
+    vector<string> keys;
+    for (size_t i = 0; i < operands.size(); ++i)
+        keys.push_back(nodes[operands[i]].key);
+    sort(keys.begin(), keys.end());
+    string list;
+    for (size_t i = 0; i < keys.size(); ++i)
+        list += " " + keys[i];
+    return list;
+}
+
+void IntSetQuery::sortByEstimate(vector<int>& operands, bool ascending) const
+{
+    const vector<Node>& all = nodes;
+    sort(operands.begin(), operands.end(), [&](int a, int b) {
+        if (all[a].estimate != all[b].estimate)
+            return ascending ? all[a].estimate < all[b].estimate
+                             : all[a].estimate > all[b].estimate;
+        return all[a].key < all[b].key;
+    });
+}
+
+string IntSetQuery::plan() const
+{
+    vector<int> uses(nodes.size(), 0), labels(nodes.size(), 0);
+    int next_label = 0;
+    string defs;
+    countUses(root, uses);
+    string main = render(root, uses, labels, next_label, defs);
+    return defs + main;
+}
+
+void IntSetQuery::countUses(int node, vector<int>& uses) const
+{
+    if (++uses[node] > 1)
+        return;
+    for (size_t i = 0; i < nodes[node].keep.size(); ++i)
+        countUses(nodes[node].keep[i], uses);
+    for (size_t i = 0; i < nodes[node].drop.size(); ++i)
+        countUses(nodes[node].drop[i], uses);
+}
+
+string IntSetQuery::render(int node, const vector<int>& uses,
+                           vector<int>& labels, int& next_label,
+                           string& defs) const
+{
+    const Node& n = nodes[node];
+    if (n.kind == LEAF)
+        return n.text;
+    if (n.kind == EMPTY)
+        return "(empty)";
+    if (labels[node] > 0) {
+        ostringstream label;
+        label << "$" << labels[node];
+        return label.str();
+    }
+
+    string body;
+    for (size_t i = 0; i < n.keep.size(); ++i) {
+        if (i > 0)
+            body += n.kind == AND ? " & " : " | ";
+        body += operand(n.keep[i], uses, labels, next_label, defs);
+    }
+    for (size_t i = 0; i < n.drop.size(); ++i)
+        body += " - " + operand(n.drop[i], uses, labels, next_label, defs);
+    if (uses[node] == 1)
+        return body;
+
+    labels[node] = ++next_label;
+    ostringstream label;
+    label << "$" << labels[node];
+    defs += label.str() + " = " + body + "; ";
+    return label.str();
+}
+
+string IntSetQuery::operand(int node, const vector<int>& uses,
+                            vector<int>& labels, int& next_label,
+                            string& defs) const
+{
+    string text = render(node, uses, labels, next_label, defs);
+    return nodes[node].kind == LEAF || text[0] == '$' ? text
+                                                     : "(" + text + ")";
+}
+
+IntSet IntSetQuery::run() const
+{
+    INTSET_TRACE_SCOPE("query", nodes[root].estimate);
+    vector<IntSet> results(nodes.size());
+    vector<bool> done(nodes.size(), false);
+    const IntSet* result = evaluate(root, results, done);
+    if (result != &results[root])
+        return *result;
+    IntSet value;
+    value.swap(results[root]);
+    return value;
+}
+
+const IntSet* IntSetQuery::evaluate(int node, vector<IntSet>& results,
+                                    vector<bool>& done) const
+{
+    const Node& n = nodes[node];
+    if (n.kind == LEAF)
+        return n.set;
+    if (done[node])
+        return &results[node];
+
+    vector<const IntSet*> keep, drop;
+    for (size_t i = 0; i < n.keep.size(); ++i)
+        keep.push_back(evaluate(n.keep[i], results, done));
+    for (size_t i = 0; i < n.drop.size(); ++i)
+        drop.push_back(evaluate(n.drop[i], results, done));
+
+    int candidates[BATCH];
+    if (n.kind == AND) {
+        // Candidates are the smallest operand's members; every other
+        // operand filters the survivors of the ones before it.
+        const IntSet& source = *keep[0];
+        const int* members = IntSetExprAccess::members(source);
+        IntSet out(source.size());
+        for (size_t begin = 0; begin < source.size(); begin += BATCH) {
+            int m = int(min(size_t(BATCH), source.size() - begin));
+            copy(members + begin, members + begin + m, candidates);
+            for (size_t i = 1; i < keep.size() && m > 0; ++i)
+                m = filter(*keep[i], candidates, m, true);
+            for (size_t i = 0; i < drop.size() && m > 0; ++i)
+                m = filter(*drop[i], candidates, m, false);
+            for (int k = 0; k < m; ++k)
+                IntSetExprAccess::append(out, candidates[k]);
+        }
+        results[node].swap(out);
+    } else if (n.kind == OR) {
+        // Each operand contributes the members no earlier one has.
+        size_t bound = 0;
+        for (size_t i = 0; i < keep.size(); ++i)
+            bound += min(keep[i]->size(), IntSet::MAX_CAPACITY - bound);
+        IntSet out(bound);
+        for (size_t j = 0; j < keep.size(); ++j) {
+            const int* members = IntSetExprAccess::members(*keep[j]);
+            for (size_t begin = 0; begin < keep[j]->size(); begin += BATCH) {
+                int m = int(min(size_t(BATCH), keep[j]->size() - begin));
+                copy(members + begin, members + begin + m, candidates);
+                for (size_t i = 0; i < j && m > 0; ++i)
+                    m = filter(*keep[i], candidates, m, false);
+                for (int k = 0; k < m; ++k)
+                    IntSetExprAccess::append(out, candidates[k]);
+            }
+        }
+        results[node].swap(out);
+    }
+    done[node] = true;
+    return &results[node];
+}
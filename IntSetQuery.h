@@ -0,0 +1,166 @@
+// FILE: IntSetQuery.h - header file for IntSetQuery class
+// CLASS PROVIDED: IntSetQuery (a set expression over named IntSet's,
+//                 parsed from text, rewritten into an optimized plan
+//                 and evaluated on the IntSet engine)
+//
+// EXPRESSION SYNTAX
+//   expr := term { '|' term }         union
+//   term := diff { '&' diff }         intersection
+//   diff := unary { '-' unary }       difference
+//   unary := '~' unary | '(' expr ')' | name
+//   Names are those given to define(); blanks are ignored. The
+//   precedence is the C++ one (as for IntSetExpr.h): - binds tighter
+//   than &, which binds tighter than |. ~x is the complement of x:
+//   every int that is not in x. It may appear anywhere as long as the
+//   whole expression is finite, e.g. (is1 | is2) & ~is3 (which is
+//   (is1 | is2) - is3), but not ~is1 or is1 | ~is2.
+//   Parentheses and ~'s may be nested at most MAX_DEPTH deep.
+//
+// THE PLAN
+//   compile() rewrites the expression before anything is evaluated:
+//   - Complements are pushed up the tree (de Morgan) until each one
+//     is absorbed into a difference: a & ~b is a - b, ~a & ~b is
+//     ~(a | b), a | ~b is ~(b - a), and so on.
+//   - Chains of & and - become one n-ary intersection (operands to
+//     keep and operands to drop), chains of | one n-ary union.
+//     x & x, x | x and x - x are simplified away.
+//   - Intersections are pushed down into unions whenever another
+//     operand of the intersection is estimated to be smaller than the
+//     union: s & (a | b) becomes (s & a) | (s & b).
+//   - Intersection operands are evaluated smallest first (by size
+//     estimate); union operands biggest first.
+//   - Equal subexpressions are recognized (up to the order of the
+//     operands of & and |) and evaluated only once.
+//   An n-ary intersection is a single pass over its smallest operand,
+//   each batch of candidates being filtered by the other operands in
+//   turn (with containsMany); an n-ary union is a single pass over its
+//   operands, each keeping the members no earlier operand has. Either
+//   allocates only its result; operands that are named sets are used
+//   in place. Only the results of nested intersections/unions are
+//   materialized.
+//
+// CONSTRUCTOR
+//   IntSetQuery()
+//     Post: The invoking IntSetQuery has no names and no plan.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   const std::string& error() const
+//     Post: Why the last compile() failed is returned ("" if it
+//           didn't).
+//   std::string plan() const
+//     Pre:  The last compile() succeeded.
+//     Post: The optimized plan is returned as an expression in the
+//           same syntax, with operands in evaluation order; a
+//           subexpression that is used more than once is written out
+//           once as "$k = ...;" and referred to as $k afterwards.
+//           An expression that is always empty (e.g. is1 - is1) has
+//           the plan "(empty)".
+//   IntSet run() const
+//     Pre:  The last compile() succeeded and the named sets still
+//           exist.
+//     Post: The value of the compiled expression is returned.
+//     Note: The members are those of the expression, but their
+//           membership order is the plan's (the optimizer reorders
+//           operands), not necessarily that of the equivalent
+//           unionWith/intersect/subtract chain.
+//
+// MODIFICATION MEMBER FUNCTIONS (MUTATORS)
+//   void define(const std::string& name, const IntSet& is)
+//     Pre:  name is made of letters, digits and '_' and starts with a
+//           letter or '_'; is outlives every run() of the plans
+//           compiled while it is defined.
+//     Post: name refers to is in expressions compiled from now on.
+//   bool compile(const std::string& expression)
+//     Post: If expression is well-formed (nested no deeper than
+//           MAX_DEPTH), uses only defined names and
+//           has a finite value, it has been parsed and optimized into
+//           the plan that run() evaluates, and true is returned
+//           (the size estimates come from the sizes the named sets
+//           have now); otherwise false is returned and error() tells
+//           why.
+//
+// VALUE SEMANTICS
+//   Assignment and the copy constructor may be used with IntSetQuery
+//   objects; the copy refers to the same named sets.
+
+#ifndef INT_SET_QUERY_H
+#define INT_SET_QUERY_H
+
+#include "IntSet.h"
+#include <map>
+#include <string>
+#include <vector>
+
+class IntSetQuery
+{
+public:
+   IntSetQuery();
+   const std::string& error() const;
+   std::string plan() const;
+   IntSet run() const;
+   void define(const std::string& name, const IntSet& is);
+   bool compile(const std::string& expression);
+
+   static const size_t MAX_DEPTH = 256;
+
+private:
+   enum Kind { EMPTY, LEAF, AND, OR };
+
+   // One node of the plan. Nodes are hash-consed on key, so equal
+   // subexpressions are the same node.
+   struct Node
+   {
+      Kind             kind;
+      const IntSet*    set;    // LEAF: the named set
+      std::vector<int> keep;   // AND: operands; OR: operands
+      std::vector<int> drop;   // AND: operands subtracted
+      double           estimate;
+      std::string      key;
+      std::string      text;   // LEAF: name
+   };
+
+   // A parsed subexpression: a plan node, possibly complemented.
+   struct Signed
+   {
+      int  node;
+      bool negated;
+   };
+
+   // Recursive-descent parser (see EXPRESSION SYNTAX).
+   bool parseExpr(Signed& out);
+   bool parseTerm(Signed& out);
+   bool parseDiff(Signed& out);
+   bool parseUnary(Signed& out);
+   void skipBlanks();
+   bool fail(const std::string& why);
+
+   Signed makeAnd(const std::vector<Signed>& operands);
+   Signed makeOr(const std::vector<Signed>& operands);
+   int andNode(std::vector<int> keep, std::vector<int> drop);
+   int orNode(std::vector<int> operands);
+   int emptyNode();
+   int intern(const Node& node);
+   std::string keyList(const std::vector<int>& operands) const;
+   void sortByEstimate(std::vector<int>& operands, bool ascending) const;
+
+   void countUses(int node, std::vector<int>& uses) const;
+   std::string render(int node, const std::vector<int>& uses,
+                      std::vector<int>& labels, int& next_label,
+                      std::string& defs) const;
+   std::string operand(int node, const std::vector<int>& uses,
+                       std::vector<int>& labels, int& next_label,
+                       std::string& defs) const;
+   const IntSet* evaluate(int node, std::vector<IntSet>& results,
+                          std::vector<bool>& done) const;
+
+   std::map<std::string, const IntSet*> names;
+   std::vector<Node>                    nodes;
+   std::map<std::string, int>           by_key;
+   int                                  root;
+   std::string                          input;
+   size_t                               pos;
+   size_t                               depth;   // of ( and ~ at pos
+   std::string                          message;
+};
+
+#endif
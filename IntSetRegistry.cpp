@@ -0,0 +1,199 @@
+// FILE: IntSetRegistry.cpp
+//       Implementation file for the IntSetRegistry class
+//       (See IntSetRegistry.h for documentation.)
+// INVARIANT for the IntSetRegistry class:
+// (1) sets maps every name to its Entry. A resident entry holds the
+//     set itself and appears exactly once in lru_order (through its
+//     lru iterator), most recently found first; a spilled entry holds
+//     an empty IntSet, is not in lru_order, and its members are in
+//     spillPath(name), spilled_size of them.
+// (2) resident_bytes is the sum of bytes over the resident entries;
+//     bytes is the entry's memoryUsage() when it was created,
+//     reloaded or last re-measured by trim(). Sets that may have
+//     changed since (every set found since the last trim()) are
+//     listed in touched (possibly more than once, possibly dropped
+//     since).
+// NOTES on the implementation:
+// (1) std::unordered_map never moves its elements, so the pointers
+//     find() hands out survive other sets being created, and only
+//     trim() (which frees spilled sets) and drop() invalidate them.
+
+#include "IntSetRegistry.h"
+#include "IntSetFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+using namespace std;
+
+namespace
+{
+    const size_t MAX_NAME = 64;
+}
+
+IntSetRegistry::IntSetRegistry(size_t memory_limit, const string& spill_dir)
+    : limit(memory_limit), resident_bytes(0), dir(spill_dir),
+      num_evictions(0), num_reloads(0)
+{
+}
+
+IntSetRegistry::~IntSetRegistry()
+{
+    for (Table::iterator it = sets.begin(); it != sets.end(); ++it)
+        if (!it->second.resident)
+            remove(spillPath(it->first).c_str());
+}
+
+bool IntSetRegistry::validName(const string& name)
+{
+    if (name.empty() || name.size() > MAX_NAME ||
+        isdigit(static_cast<unsigned char>(name[0])))
+        return false;
+    for (size_t i = 0; i < name.size(); ++i)
+        if (!isalnum(static_cast<unsigned char>(name[i])) && name[i] != '_')
+            return false;
+    return true;
+}
+
+size_t IntSetRegistry::count() const
+{
+    return sets.size();
+}
+
+bool IntSetRegistry::exists(const string& name) const
+{
+    return sets.find(name) != sets.end();
+}
+
+vector<string> IntSetRegistry::names() const
+{
+    vector<string> result;
+    result.reserve(sets.size());
+    for (Table::const_iterator it = sets.begin(); it != sets.end(); ++it)
+        result.push_back(it->first);
+    sort(result.begin(), result.end());
+    return result;
+}
+
+ptrdiff_t IntSetRegistry::sizeOf(const string& name) const
+{
+    Table::const_iterator it = sets.find(name);
+    if (it == sets.end())
+        return -1;
+    return ptrdiff_t(it->second.resident ? it->second.set.size()
+                                         : it->second.spilled_size);
+}
+
+bool IntSetRegistry::isResident(const string& name) const
+{
+    Table::const_iterator it = sets.find(name);
+    return it != sets.end() && it->second.resident;
+}
+
+size_t IntSetRegistry::memoryLimit() const
+{
+    return limit;
+}
+
+size_t IntSetRegistry::residentBytes() const
+{
+    return resident_bytes;
+}
+
+unsigned long IntSetRegistry::evictions() const
+{
+    return num_evictions;
+}
+
+unsigned long IntSetRegistry::reloads() const
+{
+    return num_reloads;
+}
+
+bool IntSetRegistry::create(const string& name)
+{
+    if (!validName(name) || exists(name))
+        return false;
+    Entry& entry = sets[name];
+    entry.resident = true;
+    entry.spilled_size = 0;
+    entry.bytes = entry.set.memoryUsage();
+    lru_order.push_front(name);
+    entry.lru = lru_order.begin();
+    resident_bytes += entry.bytes;
+    return true;
+}
+
+bool IntSetRegistry::drop(const string& name)
+{
+    Table::iterator it = sets.find(name);
+    if (it == sets.end())
+        return false;
+    if (it->second.resident) {
+        resident_bytes -= it->second.bytes;
+        lru_order.erase(it->second.lru);
+    } else {
+        remove(spillPath(name).c_str());
+    }
+    sets.erase(it);
+    return true;
+}
+
+IntSet* IntSetRegistry::find(const string& name)
+{
+    Table::iterator it = sets.find(name);
+    if (it == sets.end())
+        return NULL;
+    Entry& entry = it->second;
+    if (entry.resident) {
+        lru_order.splice(lru_order.begin(), lru_order, entry.lru);
+    } else {
+        string path = spillPath(name);
+        if (!IntSetFile::loadFile(path, entry.set))
+            return NULL;
+        remove(path.c_str());
+        ++num_reloads;
+        entry.resident = true;
+        entry.bytes = entry.set.memoryUsage();
+        resident_bytes += entry.bytes;
+        lru_order.push_front(name);
+        entry.lru = lru_order.begin();
+    }
+    touched.push_back(name);
+    return &entry.set;
+}
+
+void IntSetRegistry::setMemoryLimit(size_t bytes)
+{
+    limit = bytes;
+}
+
+void IntSetRegistry::trim()
+{
+    for (size_t i = 0; i < touched.size(); ++i) {
+        Table::iterator it = sets.find(touched[i]);
+        if (it == sets.end() || !it->second.resident)
+            continue;
+        resident_bytes -= it->second.bytes;
+        it->second.bytes = it->second.set.memoryUsage();
+        resident_bytes += it->second.bytes;
+    }
+    touched.clear();
+
+    while (limit > 0 && resident_bytes > limit && lru_order.size() > 1) {
+        const string& name = lru_order.back();
+        Entry& entry = sets.find(name)->second;
+        if (!IntSetFile::saveFile(entry.set, spillPath(name)))
+            return;
+        ++num_evictions;
+        entry.resident = false;
+        entry.spilled_size = entry.set.size();
+        IntSet().swap(entry.set);
+        resident_bytes -= entry.bytes;
+        lru_order.pop_back();
+    }
+}
+
+string IntSetRegistry::spillPath(const string& name) const
+{
+    return dir + "/" + name + ".iset";
+}
@@ -0,0 +1,140 @@
+// FILE: IntSetRegistry.h - header file for IntSetRegistry class
+// CLASS PROVIDED: IntSetRegistry (any number of IntSet's looked up by
+//                 name, with a cap on the memory the resident ones
+//                 may use: the least recently used sets beyond it
+//                 are spilled to disk and reloaded on their next use)
+//
+// Lookups are hash-table lookups (O(1) expected), whatever the number
+// of sets. Spilled sets are kept in the IntSetFile format, one file
+// per set, named NAME.iset in the spill directory.
+//
+// CONSTRUCTOR
+//   IntSetRegistry(size_t memory_limit = 0,
+//                  const std::string& spill_dir = ".")
+//     Pre:  spill_dir exists, is writable, and no other registry
+//           spills into it.
+//     Post: The invoking IntSetRegistry holds no sets; resident sets
+//           may use up to memory_limit bytes (0 = no limit, nothing
+//           is ever spilled) and spill into spill_dir.
+//
+// DESTRUCTOR
+//   ~IntSetRegistry()
+//     Post: The spill files of the sets still on disk are deleted.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   static bool validName(const std::string& name)
+//     Post: True is returned if name can name a set: 1 to 64
+//           letters, digits and '_', not starting with a digit
+//           (i.e. it is also a name in IntSetQuery expressions).
+//   size_t count() const
+//     Post: # of sets (resident or not) is returned.
+//   bool exists(const std::string& name) const
+//     Post: True is returned if there is a set called name.
+//   std::vector<std::string> names() const
+//     Post: The names of all sets are returned, in ascending order.
+//   std::ptrdiff_t sizeOf(const std::string& name) const
+//     Post: The size of the set called name is returned (-1 if there
+//           is none); a spilled set is not reloaded to find out.
+//   bool isResident(const std::string& name) const
+//     Post: True is returned if the set called name is in memory.
+//   size_t memoryLimit() const
+//     Post: The memory limit in bytes is returned (0 = none).
+//   size_t residentBytes() const
+//     Post: The memoryUsage() of all resident sets, as of the last
+//           trim() (or create/drop/reload since), is returned.
+//   unsigned long evictions() const
+//   unsigned long reloads() const
+//     Post: # of times a set has been spilled to / reloaded from
+//           disk is returned.
+//
+// MODIFICATION MEMBER FUNCTIONS (MUTATORS)
+//   bool create(const std::string& name)
+//     Post: If name is valid and not taken, an empty set called name
+//           has been added and true is returned; otherwise nothing
+//           has changed and false is returned.
+//   bool drop(const std::string& name)
+//     Post: If there is a set called name, it (and its spill file,
+//           if any) is gone and true is returned; otherwise false is
+//           returned.
+//   IntSet* find(const std::string& name)
+//     Post: The set called name is returned, reloaded from disk first
+//           if it had been spilled, and it has become the most
+//           recently used set. NULL is returned if there is no such
+//           set or its spill file can't be read back.
+//     Note: The pointer stays valid until the set is dropped or the
+//           next trim(); sets are only ever spilled by trim(), so any
+//           number of sets found one after the other can be used
+//           together.
+//   void setMemoryLimit(size_t bytes)
+//     Post: The memory limit is bytes (0 = none); it is enforced by
+//           the next trim().
+//   void trim()
+//     Post: The sizes of the sets found since the last trim() have
+//           been re-measured; then, while residentBytes() exceeds the
+//           memory limit, the least recently used resident set other
+//           than the most recently used one has been written to disk
+//           and freed. Spilling stops early if a spill file can't be
+//           written (the set stays resident).
+//
+// VALUE SEMANTICS
+//   IntSetRegistry objects may not be copied or assigned (they own
+//   their spill files).
+
+#ifndef INT_SET_REGISTRY_H
+#define INT_SET_REGISTRY_H
+
+#include "IntSet.h"
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class IntSetRegistry
+{
+public:
+   IntSetRegistry(size_t memory_limit = 0, const std::string& spill_dir = ".");
+   ~IntSetRegistry();
+   static bool validName(const std::string& name);
+   size_t count() const;
+   bool exists(const std::string& name) const;
+   std::vector<std::string> names() const;
+   std::ptrdiff_t sizeOf(const std::string& name) const;
+   bool isResident(const std::string& name) const;
+   size_t memoryLimit() const;
+   size_t residentBytes() const;
+   unsigned long evictions() const;
+   unsigned long reloads() const;
+   bool create(const std::string& name);
+   bool drop(const std::string& name);
+   IntSet* find(const std::string& name);
+   void setMemoryLimit(size_t bytes);
+   void trim();
+
+private:
+   IntSetRegistry(const IntSetRegistry& src);
+   IntSetRegistry& operator=(const IntSetRegistry& rhs);
+
+   struct Entry
+   {
+      IntSet                           set;
+      bool                             resident;
+      size_t                           spilled_size;  // size on disk
+      size_t                           bytes;         // as last measured
+      std::list<std::string>::iterator lru;           // if resident
+   };
+   typedef std::unordered_map<std::string, Entry> Table;
+
+   std::string spillPath(const std::string& name) const;
+
+   Table                    sets;
+   std::list<std::string>   lru_order;   // resident sets, most recent first
+   std::vector<std::string> touched;     // found since the last trim()
+   size_t                   limit;
+   size_t                   resident_bytes;
+   std::string              dir;
+   unsigned long            num_evictions;
+   unsigned long            num_reloads;
+};
+
+#endif
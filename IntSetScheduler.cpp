@@ -0,0 +1,178 @@
+// FILE: IntSetScheduler.cpp
+//       Implementation file for the IntSetScheduler class
+//       (See IntSetScheduler.h for documentation.)
+// INVARIANT for the IntSetScheduler class:
+// (1) Every job whose callback hasn't been run is in exactly one of:
+//     sliced (waiting for poll() to advance it), queued (waiting for
+//     a worker), running on a worker, or finished (waiting for poll()
+//     to run its callback). in_flight counts the jobs in queued,
+//     running on a worker, or in finished.
+// (2) Tasks are heap allocated and owned by whichever of the above
+//     holds them; a Task never moves, so its job may safely refer to
+//     the task's own lhs_copy/rhs_copy.
+// (3) stopping is set only by the destructor; workers exit when they
+//     see it set.
+
+#include "IntSetScheduler.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+using namespace std;
+
+IntSetScheduler::Task::Task(IntSetJob::Operation op, const IntSet& lhs,
+                            const IntSet& rhs, bool copy_operands,
+                            Callback done)
+    : lhs_copy(copy_operands ? lhs : IntSet()),
+      rhs_copy(copy_operands ? rhs : IntSet()),
+      job(op, copy_operands ? lhs_copy : lhs, copy_operands ? rhs_copy : rhs),
+      done(done)
+{
+}
+
+IntSetScheduler::IntSetScheduler(int num_workers)
+    : in_flight(0), stopping(false)
+{
+    for (int i = 0; i < num_workers; ++i)
+        workers.push_back(thread(&IntSetScheduler::workerLoop, this));
+}
+
+IntSetScheduler::~IntSetScheduler()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+
+    // Whatever is left never gets its callback run.
+    for (size_t i = 0; i < sliced.size(); ++i)
+        delete sliced[i];
+    for (size_t i = 0; i < queued.size(); ++i)
+        delete queued[i];
+    for (size_t i = 0; i < finished.size(); ++i)
+        delete finished[i];
+}
+
+int IntSetScheduler::pending() const
+{
+    lock_guard<mutex> guard(lock);
+    return int(sliced.size()) + in_flight;
+}
+
+void IntSetScheduler::runSliced(IntSetJob::Operation op, const IntSet& lhs,
+                                const IntSet& rhs, Callback done)
+{
+    sliced.push_back(new Task(op, lhs, rhs, false, done));
+}
+
+void IntSetScheduler::offload(IntSetJob::Operation op, const IntSet& lhs,
+                              const IntSet& rhs, Callback done)
+{
+    Task* task = new Task(op, lhs, rhs, true, done);
+
+    // Without workers the copies are still taken, so the caller gets
+    // the same "free to change the operands now" guarantee.
+    if (workers.empty()) {
+        sliced.push_back(task);
+        return;
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        queued.push_back(task);
+        ++in_flight;
+    }
+    work_ready.notify_one();
+}
+
+void IntSetScheduler::setWakeup(function<void()> wakeup)
+{
+    lock_guard<mutex> guard(lock);
+    this->wakeup = wakeup;
+}
+
+int IntSetScheduler::poll(long budget_micros)
+{
+    int ran = 0;
+
+    // Run the callbacks of jobs the workers finished, outside the lock
+    // so a callback may queue more work. If one throws, its job is
+    // dropped and the jobs after it go back to finished for the next
+    // poll(), still counted in in_flight.
+    deque<Task*> done;
+    {
+        lock_guard<mutex> guard(lock);
+        done.swap(finished);
+    }
+    while (!done.empty()) {
+        unique_ptr<Task> task(done.front());
+        done.pop_front();
+        {
+            lock_guard<mutex> guard(lock);
+            --in_flight;
+        }
+        try {
+            task->done(task->job.result());
+        } catch (...) {
+            lock_guard<mutex> guard(lock);
+            finished.insert(finished.begin(), done.begin(), done.end());
+            throw;
+        }
+        ++ran;
+    }
+
+    // Spend the rest of the budget on sliced jobs, giving each one an
+    // equal share of what is left and moving unfinished ones to the
+    // back so no job starves the others.
+    chrono::steady_clock::time_point deadline =
+        chrono::steady_clock::now() + chrono::microseconds(budget_micros);
+    size_t turns = sliced.size();
+    while (turns > 0 && !sliced.empty()) {
+        long left = long(chrono::duration_cast<chrono::microseconds>(
+                            deadline - chrono::steady_clock::now()).count());
+        if (left <= 0)
+            break;
+
+        // A finished job's task is deleted even if its callback throws.
+        unique_ptr<Task> task(sliced.front());
+        sliced.pop_front();
+        --turns;
+        if (task->job.runFor(left / long(turns + 1))) {
+            task->done(task->job.result());
+            ++ran;
+        } else {
+            sliced.push_back(task.get());
+            task.release();
+        }
+    }
+    return ran;
+}
+
+void IntSetScheduler::workerLoop()
+{
+    for (;;) {
+        Task* task;
+        {
+            unique_lock<mutex> guard(lock);
+            while (!stopping && queued.empty())
+                work_ready.wait(guard);
+            if (stopping)
+                return;
+            task = queued.front();
+            queued.pop_front();
+        }
+
+        task->job.step(SIZE_MAX);
+
+        function<void()> notify;
+        {
+            lock_guard<mutex> guard(lock);
+            finished.push_back(task);
+            notify = wakeup;
+        }
+        if (notify)
+            notify();
+    }
+}
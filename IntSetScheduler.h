@@ -0,0 +1,116 @@
+// FILE: IntSetScheduler.h - header file for IntSetScheduler class
+// CLASS PROVIDED: IntSetScheduler (runs IntSetJob's for a
+//                 single-threaded event loop, either in bounded time
+//                 slices on the loop's own thread or on a pool of
+//                 worker threads, and hands each result to a
+//                 continuation callback on the loop's thread)
+//
+// TYPEDEF
+//   typedef std::function<void(IntSet&)> Callback
+//     A continuation; it is given the finished result, which it may
+//     swap into an IntSet of its own.
+//
+// CONSTRUCTOR
+//   IntSetScheduler(int num_workers = 0)
+//     Post: The invoking IntSetScheduler has num_workers worker
+//           threads (none if num_workers <= 0) and no jobs.
+//
+// DESTRUCTOR
+//   ~IntSetScheduler()
+//     Post: The worker threads have been joined once they finished
+//           the job (if any) they were running. Callbacks that have
+//           not been run by poll() are dropped without being run.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   int pending() const
+//     Post: # of jobs whose callback has not been run yet is returned.
+//
+// MODIFICATION MEMBER FUNCTIONS (MUTATORS)
+//   void runSliced(IntSetJob::Operation op, const IntSet& lhs,
+//                  const IntSet& rhs, Callback done)
+//     Pre:  lhs and rhs are not modified or destroyed until done has
+//           been run.
+//     Post: A job computing op on lhs and rhs has been queued; it is
+//           advanced only inside poll(), on the caller's thread, and
+//           done is run by the poll() call that finishes it.
+//   void offload(IntSetJob::Operation op, const IntSet& lhs,
+//                const IntSet& rhs, Callback done)
+//     Post: Copies of lhs and rhs have been taken (so the caller may
+//           change or destroy them right away) and a job computing op
+//           on the copies has been queued for the worker threads; done
+//           is run by the first poll() after a worker finishes it.
+//           With no worker threads, this is the same as runSliced on
+//           the copies.
+//   void setWakeup(std::function<void()> wakeup)
+//     Pre:  No offloaded job is running.
+//     Post: Each time a worker finishes a job, wakeup is called (on
+//           the worker's thread) so that the event loop can be told
+//           to call poll() (e.g. by writing to an eventfd or pipe).
+//   int poll(long budget_micros)
+//     Pre:  Called from the event loop's thread only.
+//     Post: The callbacks of all jobs finished by workers have been
+//           run, then sliced jobs have been advanced round-robin for
+//           about budget_micros microseconds in total (running the
+//           callback of each one that finished). # of callbacks run
+//           is returned. If a callback throws, the exception is
+//           passed on: that job is dropped, and every other job is
+//           kept (a later poll() runs the callbacks not yet run).
+//
+// VALUE SEMANTICS
+//   Assignment and the copy constructor may NOT be used with
+//   IntSetScheduler objects.
+
+#ifndef INT_SET_SCHEDULER_H
+#define INT_SET_SCHEDULER_H
+
+#include "IntSetJob.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class IntSetScheduler
+{
+public:
+   typedef std::function<void(IntSet&)> Callback;
+   IntSetScheduler(int num_workers = 0);
+   ~IntSetScheduler();
+   int pending() const;
+   void runSliced(IntSetJob::Operation op, const IntSet& lhs,
+                  const IntSet& rhs, Callback done);
+   void offload(IntSetJob::Operation op, const IntSet& lhs,
+                const IntSet& rhs, Callback done);
+   void setWakeup(std::function<void()> wakeup);
+   int poll(long budget_micros);
+
+private:
+   // A job plus its continuation; offloaded tasks also own copies of
+   // their operands (the job refers to those instead of the caller's).
+   struct Task
+   {
+      Task(IntSetJob::Operation op, const IntSet& lhs, const IntSet& rhs,
+           bool copy_operands, Callback done);
+      IntSet    lhs_copy;
+      IntSet    rhs_copy;
+      IntSetJob job;
+      Callback  done;
+   };
+
+   IntSetScheduler(const IntSetScheduler&);
+   IntSetScheduler& operator=(const IntSetScheduler&);
+   void workerLoop();
+
+   std::deque<Task*>        sliced;     // loop thread only
+   std::deque<Task*>        queued;     // guarded by lock
+   std::deque<Task*>        finished;   // guarded by lock
+   int                      in_flight;  // guarded by lock
+   bool                     stopping;   // guarded by lock
+   mutable std::mutex       lock;
+   std::condition_variable  work_ready;
+   std::function<void()>    wakeup;
+   std::vector<std::thread> workers;
+};
+
+#endif
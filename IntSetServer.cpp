@@ -0,0 +1,433 @@
+// FILE: IntSetServer.cpp
+//       Implementation file for the IntSetServer class
+//       (See IntSetServer.h for documentation.)
+// INVARIANT for the IntSetServer class:
+// (1) connections holds every open connection, by fd; a closed one
+//     has fd -1 (workers may still hold it until they are done).
+// (2) A connection with requests is busy, and a busy connection is
+//     either in ready (waiting for a worker) or being served by
+//     exactly one worker (or, with no workers, by the loop), so its
+//     requests are run one at a time, in order. Each response goes to
+//     responses, and from there (on the loop's thread) to output and
+//     the socket, in the same order.
+// (3) events is what epoll watches on the connection for: EPOLLIN
+//     while more requests may come and the connection's backlog is
+//     small, EPOLLOUT while output isn't empty. A connection epoll
+//     doesn't watch at all is one whose peer has hung up and that is
+//     waiting for a worker; it is closed once it is neither busy nor
+//     has output left.
+// (4) stopped is set only by stop(), stopping only by the destructor.
+// NOTES on the implementation:
+// (1) Workers tell the loop that a connection has responses by adding
+//     it to answered and writing to the eventfd wake_fd, which the
+//     loop polls along with the sockets; stop() does the same write
+//     (write() and a lock-free atomic store being all a signal
+//     handler may safely do).
+// (2) A worker serves one batch of requests per turn and then puts
+//     the connection back at the end of ready, so one client
+//     streaming requests can't starve the others.
+// (3) The loop reads at most READ_CHUNK bytes from a connection per
+//     wakeup. epoll is level-triggered, so a connection with more
+//     waiting is reported again, after the others have had their
+//     turn; and since flush() stops watching a connection whose
+//     backlog is full, a client that never stops writing holds no
+//     more than about MAX_QUEUED requests and MAX_LINE + READ_CHUNK
+//     bytes of input.
+
+#include "IntSetServer.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+using namespace std;
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const size_t READ_CHUNK = 64 * 1024;      // bytes read at a time
+    const size_t MAX_OUTPUT = 4 << 20;        // unwritten response bytes
+    const size_t MAX_QUEUED = 4096;           // unserved requests
+    const int    MAX_EVENTS = 64;             // per epoll_wait
+}
+
+IntSetServer::Connection::Connection(int fd)
+    : fd(fd), hung_up(false), events(0), busy(false)
+{
+}
+
+IntSetServer::IntSetServer(Handler handler, int num_workers)
+    : handler(handler), listen_fd(-1), epoll_fd(-1), wake_fd(-1),
+      stopped(false), served(0), stopping(false)
+{
+#ifdef __linux__
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+    for (int i = 0; i < num_workers; ++i)
+        workers.push_back(thread(&IntSetServer::workerLoop, this));
+}
+
+IntSetServer::~IntSetServer()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+
+#ifdef __linux__
+    for (map<int, ConnectionPtr>::iterator it = connections.begin();
+         it != connections.end(); ++it)
+        ::close(it->first);
+    if (listen_fd >= 0)
+        ::close(listen_fd);
+    if (epoll_fd >= 0)
+        ::close(epoll_fd);
+    if (wake_fd >= 0)
+        ::close(wake_fd);
+    if (!socket_path.empty())
+        unlink(socket_path.c_str());
+#endif
+}
+
+const string& IntSetServer::error() const
+{
+    return message;
+}
+
+unsigned long IntSetServer::requestsServed() const
+{
+    return served;
+}
+
+// Run the requests conn has now; true is returned if more came in
+// meanwhile (conn is still busy), false if it is idle again.
+bool IntSetServer::serve(Connection& conn)
+{
+    deque<string> batch;
+    {
+        lock_guard<mutex> guard(lock);
+        batch.swap(conn.requests);
+    }
+
+    string responses;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        try {
+            responses += handler(batch[i]);
+        } catch (const exception& e) {
+            responses += "error ";
+            responses += e.what();
+        }
+        responses += '\n';
+        ++served;
+    }
+
+    lock_guard<mutex> guard(lock);
+    conn.responses += responses;
+    conn.busy = !conn.requests.empty();
+    return conn.busy;
+}
+
+void IntSetServer::workerLoop()
+{
+    for (;;) {
+        ConnectionPtr conn;
+        {
+            unique_lock<mutex> guard(lock);
+            while (!stopping && ready.empty())
+                work_ready.wait(guard);
+            if (stopping)
+                return;
+            conn = ready.front();
+            ready.pop_front();
+        }
+
+        bool more = serve(*conn);
+        {
+            lock_guard<mutex> guard(lock);
+            if (more)
+                ready.push_back(conn);
+            answered.push_back(conn);
+        }
+        if (more)
+            work_ready.notify_one();
+        wake();
+    }
+}
+
+bool IntSetServer::fail(const string& why)
+{
+    message = why;
+    return false;
+}
+
+#ifdef __linux__
+
+bool IntSetServer::listen(const string& path)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof address.sun_path)
+        return fail("socket path must be 1 to " +
+                    to_string(sizeof address.sun_path - 1) + " bytes");
+    memcpy(address.sun_path, path.c_str(), path.size());
+    if (wake_fd < 0)
+        return fail(string("eventfd: ") + strerror(errno));
+
+    // Replace a socket left over from an earlier run, but nothing else.
+    struct stat status;
+    if (lstat(path.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode))
+            return fail(path + " exists and is not a socket");
+        unlink(path.c_str());
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return fail(string("socket: ") + strerror(errno));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0) {
+        string why = path + ": " + strerror(errno);
+        ::close(fd);
+        return fail(why);
+    }
+    socket_path = path;
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event;
+    memset(&event, 0, sizeof event);
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    bool watched = epoll_fd >= 0 &&
+                   epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+    event.data.fd = wake_fd;
+    watched = watched &&
+              epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) == 0;
+    listen_fd = fd;
+    if (!watched)
+        return fail(string("epoll: ") + strerror(errno));
+    message.clear();
+    return true;
+}
+
+bool IntSetServer::run()
+{
+    if (listen_fd < 0 || epoll_fd < 0)
+        return fail("not listening");
+
+    epoll_event events[MAX_EVENTS];
+    while (!stopped) {
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return fail(string("epoll_wait: ") + strerror(errno));
+
+        for (int i = 0; i < n && !stopped; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd) {
+                accept();
+            } else if (fd == wake_fd) {
+                uint64_t count;
+                while (read(wake_fd, &count, sizeof count) > 0)
+                    ;
+                deque<ConnectionPtr> done;
+                {
+                    lock_guard<mutex> guard(lock);
+                    done.swap(answered);
+                }
+                for (size_t k = 0; k < done.size(); ++k)
+                    flush(done[k]);
+            } else {
+                map<int, ConnectionPtr>::iterator it = connections.find(fd);
+                if (it == connections.end())
+                    continue;
+                ConnectionPtr conn = it->second;
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    receive(conn);
+                flush(conn);
+            }
+        }
+    }
+
+    while (!connections.empty())
+        close(connections.begin()->second);
+    return true;
+}
+
+void IntSetServer::stop()
+{
+    stopped = true;
+    wake();
+}
+
+void IntSetServer::wake()
+{
+    uint64_t one = 1;
+    if (wake_fd >= 0 && write(wake_fd, &one, sizeof one) < 0) {
+        // The counter is already nonzero, so the loop will wake anyway.
+    }
+}
+
+void IntSetServer::accept()
+{
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;   // none left (or out of fds: retried next event)
+        ConnectionPtr conn(new Connection(fd));
+        connections[fd] = conn;
+        watch(*conn, true, false);
+    }
+}
+
+// Read what conn's peer has sent, and queue each whole line in it as a
+// request.
+void IntSetServer::receive(const ConnectionPtr& conn)
+{
+    if (conn->hung_up)
+        return;
+
+    // One chunk per call (see note (3)).
+    char buffer[READ_CHUNK];
+    ssize_t n = read(conn->fd, buffer, sizeof buffer);
+    if (n > 0)
+        conn->input.append(buffer, size_t(n));
+    else if (n == 0 ||
+             (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        conn->hung_up = true;
+
+    deque<string> lines;
+    size_t begin = 0, end;
+    while ((end = conn->input.find('\n', begin)) != string::npos) {
+        size_t length = end - begin;
+        if (length > 0 && conn->input[end - 1] == '\r')
+            --length;
+        lines.push_back(conn->input.substr(begin, length));
+        begin = end + 1;
+    }
+    conn->input.erase(0, begin);
+    if (conn->input.size() > MAX_LINE) {
+        conn->hung_up = true;
+        conn->input.clear();
+    }
+    if (lines.empty())
+        return;
+
+    bool start;
+    {
+        lock_guard<mutex> guard(lock);
+        for (size_t i = 0; i < lines.size(); ++i)
+            conn->requests.push_back(lines[i]);
+        start = !conn->busy;
+        conn->busy = true;
+        if (start && !workers.empty())
+            ready.push_back(conn);
+    }
+    if (!start)
+        return;
+    if (workers.empty())
+        serve(*conn);
+    else
+        work_ready.notify_one();
+}
+
+// Write as much of conn's responses as the socket takes, then decide
+// what to wait for on it next (or close it).
+void IntSetServer::flush(const ConnectionPtr& conn)
+{
+    if (conn->fd < 0)
+        return;
+
+    bool busy;
+    size_t queued;
+    {
+        lock_guard<mutex> guard(lock);
+        conn->output += conn->responses;
+        conn->responses.clear();
+        busy = conn->busy;
+        queued = conn->requests.size();
+    }
+
+    size_t written = 0;
+    while (written < conn->output.size()) {
+        ssize_t n = send(conn->fd, conn->output.data() + written,
+                         conn->output.size() - written, MSG_NOSIGNAL);
+        if (n > 0) {
+            written += size_t(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                conn->hung_up = true;   // the peer is gone
+                conn->output.clear();
+                written = 0;
+            }
+            break;
+        }
+    }
+    conn->output.erase(0, written);
+
+    if (conn->hung_up && !busy && conn->output.empty())
+        close(conn);
+    else
+        watch(*conn, !conn->hung_up && conn->output.size() < MAX_OUTPUT &&
+                     queued < MAX_QUEUED,
+              !conn->output.empty());
+}
+
+void IntSetServer::watch(Connection& conn, bool reading, bool writing)
+{
+    unsigned events = (reading ? unsigned(EPOLLIN) : 0u) |
+                      (writing ? unsigned(EPOLLOUT) : 0u);
+    if (events == conn.events)
+        return;
+    epoll_event event;
+    memset(&event, 0, sizeof event);
+    event.events = events;
+    event.data.fd = conn.fd;
+    int op = events == 0 ? EPOLL_CTL_DEL
+           : conn.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    epoll_ctl(epoll_fd, op, conn.fd, &event);
+    conn.events = events;
+}
+
+void IntSetServer::close(const ConnectionPtr& conn)
+{
+    connections.erase(conn->fd);
+    ::close(conn->fd);   // which also takes it out of epoll
+    conn->fd = -1;
+}
+
+#else
+
+bool IntSetServer::listen(const string&)
+{
+    return fail("Unix domain socket serving is only supported on Linux");
+}
+
+bool IntSetServer::run()
+{
+    return fail("not listening");
+}
+
+void IntSetServer::stop()
+{
+    stopped = true;
+}
+
+void IntSetServer::wake()
+{
+}
+
+#endif
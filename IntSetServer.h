@@ -0,0 +1,141 @@
+// FILE: IntSetServer.h - header file for IntSetServer class
+// CLASS PROVIDED: IntSetServer (a Unix-domain-socket server for a line
+//                 protocol: one epoll event loop multiplexing any
+//                 number of clients, a pool of worker threads running
+//                 the requests, and pipelining on every connection)
+//
+// THE PROTOCOL
+//   A request is one line of text ('\n'-terminated; a '\r' before the
+//   '\n' is dropped); its response is whatever the handler returns for
+//   it, written back followed by '\n'. A client may send any number of
+//   requests without waiting for their responses (pipelining): the
+//   responses on a connection always come back in the order of its
+//   requests, however many workers there are. A line longer than
+//   MAX_LINE bytes ends the connection.
+//
+// TYPEDEF
+//   typedef std::function<std::string(const std::string&)> Handler
+//     Runs one request (the line, without its '\n') and returns the
+//     response (which should not itself contain '\n'). It is called
+//     from the worker threads, several at a time for different
+//     connections, so it must do its own locking. If it throws a
+//     std::exception, the response is "error " and the exception's
+//     what().
+//
+// CONSTRUCTOR
+//   IntSetServer(Handler handler, int num_workers = 0)
+//     Post: The invoking IntSetServer answers requests with handler,
+//           on num_workers worker threads (if num_workers <= 0,
+//           requests are run on the event loop's thread); it isn't
+//           listening yet.
+//
+// DESTRUCTOR
+//   ~IntSetServer()
+//     Post: The worker threads have been joined once they finished
+//           the requests they were running, every connection has been
+//           closed and the socket file (if any) removed.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   const std::string& error() const
+//     Post: Why the last listen() or run() failed is returned ("" if
+//           neither has).
+//   unsigned long requestsServed() const
+//     Post: # of requests whose handler has returned is returned.
+//
+// MODIFICATION MEMBER FUNCTIONS (MUTATORS)
+//   bool listen(const std::string& path)
+//     Pre:  listen() hasn't succeeded before.
+//     Post: If a Unix domain socket could be bound to path (a stale
+//           socket file there is replaced; any other file is left
+//           alone and is an error), it is listening and true is
+//           returned; otherwise false is returned and error() tells
+//           why. Only supported on Linux.
+//   bool run()
+//     Pre:  listen() has succeeded.
+//     Post: Clients have been accepted and served until stop() was
+//           called; then every connection has been closed (responses
+//           not yet written are dropped) and true is returned. False
+//           is returned (and error() tells why) if waiting for events
+//           failed.
+//   void stop()
+//     Post: run() returns as soon as it sees this (right away if it
+//           isn't blocked on a handler). Safe to call from another
+//           thread or from a signal handler.
+//
+// VALUE SEMANTICS
+//   Assignment and the copy constructor may NOT be used with
+//   IntSetServer objects.
+
+#ifndef INT_SET_SERVER_H
+#define INT_SET_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class IntSetServer
+{
+public:
+   typedef std::function<std::string(const std::string&)> Handler;
+   static const size_t MAX_LINE = 1 << 20;   // bytes per request
+   IntSetServer(Handler handler, int num_workers = 0);
+   ~IntSetServer();
+   const std::string& error() const;
+   unsigned long requestsServed() const;
+   bool listen(const std::string& path);
+   bool run();
+   void stop();
+
+private:
+   struct Connection
+   {
+      Connection(int fd);
+      int                     fd;
+      std::string             input;      // loop: bytes of unended line
+      std::string             output;     // loop: response bytes to write
+      bool                    hung_up;    // loop: no more requests coming
+      unsigned                events;     // loop: watched (0: not at all)
+      std::deque<std::string> requests;   // guarded by lock
+      std::string             responses;  // guarded by lock
+      bool                    busy;       // guarded by lock: being served
+   };
+   typedef std::shared_ptr<Connection> ConnectionPtr;
+
+   IntSetServer(const IntSetServer&);
+   IntSetServer& operator=(const IntSetServer&);
+   void workerLoop();
+   bool serve(Connection& conn);
+   void wake();
+   void accept();
+   void receive(const ConnectionPtr& conn);
+   void flush(const ConnectionPtr& conn);
+   void watch(Connection& conn, bool reading, bool writing);
+   void close(const ConnectionPtr& conn);
+   bool fail(const std::string& why);
+
+   Handler                       handler;
+   int                           listen_fd;
+   int                           epoll_fd;
+   int                           wake_fd;
+   std::string                   socket_path;
+   std::string                   message;
+   std::map<int, ConnectionPtr>  connections;   // loop only, by fd
+   std::atomic<bool>             stopped;
+   std::atomic<unsigned long>    served;
+   std::deque<ConnectionPtr>     ready;      // guarded by lock
+   std::deque<ConnectionPtr>     answered;   // guarded by lock
+   bool                          stopping;   // guarded by lock
+   std::mutex                    lock;
+   std::condition_variable       work_ready;
+   std::vector<std::thread>      workers;
+};
+
+#endif
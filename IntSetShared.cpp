@@ -0,0 +1,416 @@
+// FILE: IntSetShared.cpp
+//       Implementation file for the IntSetShared class
+//       (See IntSetShared.h for documentation.)
+// INVARIANT for the IntSetShared class:
+// (1) Either nothing is mapped (control, header, member_array and
+//     slot_array are NULL, bytes and mask 0), or control maps name's
+//     control segment (sizeof(Control) bytes, read-only) and header
+//     maps version header->version of name (bytes bytes, read-only),
+//     with member_array and slot_array pointing at its members and
+//     index, and mask being its # of index slots - 1.
+// (2) A version segment is never written once its number has been
+//     stored in the control segment.
+// NOTES on the implementation:
+// (1) The layout of a version (all offsets from its start):
+//       0:              Header
+//       members_offset: count int32's, the members in membership order
+//       slots_offset:   num_slots int32's, the index: linear probing,
+//                       never more than half full, INDEX_MARKER in
+//                       the unused slots (whether INDEX_MARKER itself
+//                       is a member is in has_marker), the same
+//                       scheme and code (IntSetIndex<int>) as
+//                       IntSet's own index.
+//     The index is part of the layout, so its hash function is too:
+//     changing either means a new LAYOUT.
+// (2) The control segment's version is a std::atomic in shared
+//     memory; the writer stores a new version number (release) only
+//     after the segment it names is complete, and readers load it
+//     (acquire) before opening that segment.
+// (3) A reader can race the writer: the version it read may be
+//     unlinked before it opens it. It then simply reads the control
+//     segment again and retries with the newer version.
+
+#include "IntSetShared.h"
+#include "IntSetIndex.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+using namespace std;
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char     MAGIC[8] = { 'I', 'S', 'E', 'T', 'S', 'H', 'M', 0 };
+    const uint32_t LAYOUT = 1;
+    const size_t   ALIGNMENT = 64;        // of the member and index arrays
+    const int      OPEN_RETRIES = 8;      // see note (3)
+
+    // The index, as IntSet keeps it; its hash is part of LAYOUT.
+    typedef IntSetIndex<int> Index;
+
+    inline uint64_t alignUp(uint64_t offset)
+    {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    bool validName(const string& name)
+    {
+        return name.size() > 1 && name.size() <= IntSetShared::MAX_NAME &&
+               name[0] == '/' && name.find('/', 1) == string::npos;
+    }
+
+    string versionName(const string& name, unsigned long long version)
+    {
+        return name + "." + to_string(version);
+    }
+}
+
+struct IntSetShared::Control
+{
+    char                  magic[8];
+    uint32_t              layout;
+    uint32_t              unused;
+    std::atomic<uint64_t> version;    // current; 0 = none published yet
+};
+
+struct IntSetShared::Header
+{
+    char     magic[8];
+    uint32_t layout;
+    uint32_t has_marker;
+    uint64_t version;
+    uint64_t count;
+    uint64_t num_slots;
+    uint64_t members_offset;
+    uint64_t slots_offset;
+    uint64_t unused;
+};
+
+IntSetShared::IntSetShared()
+    : control(NULL), header(NULL), bytes(0), member_array(NULL),
+      slot_array(NULL), mask(0)
+{
+}
+
+IntSetShared::~IntSetShared()
+{
+    detach();
+}
+
+bool IntSetShared::isAttached() const
+{
+    return header != NULL;
+}
+
+unsigned long long IntSetShared::version() const
+{
+    return header == NULL ? 0 : header->version;
+}
+
+bool IntSetShared::isStale() const
+{
+    return control != NULL &&
+           control->version.load(memory_order_acquire) != header->version;
+}
+
+size_t IntSetShared::mappedBytes() const
+{
+    return bytes;
+}
+
+size_t IntSetShared::size() const
+{
+    return header == NULL ? 0 : size_t(header->count);
+}
+
+bool IntSetShared::isEmpty() const
+{
+    return size() == 0;
+}
+
+bool IntSetShared::contains(int anInt) const
+{
+    if (header == NULL)
+        return false;
+    if (anInt == Index::marker())
+        return header->has_marker != 0;
+    return slot_array[Index::find(slot_array, mask, anInt)] == anInt;
+}
+
+void IntSetShared::containsMany(const int* keys, size_t n, uint8_t* out) const
+{
+    if (header == NULL) {
+        memset(out, 0, n);
+        return;
+    }
+    Index::probeMany(slot_array, mask + 1, header->has_marker != 0, keys, n,
+                     out, IntSetNoProbe());
+}
+
+const int* IntSetShared::members() const
+{
+    return member_array;
+}
+
+IntSet IntSetShared::toIntSet() const
+{
+    IntSet result(size());
+    for (size_t i = 0; i < size(); ++i)
+        result.append(member_array[i]);
+    return result;
+}
+
+void IntSetShared::use(const Control* new_control, const Header* new_header,
+                       size_t new_bytes)
+{
+    control = new_control;
+    header = new_header;
+    bytes = new_bytes;
+    const char* base = reinterpret_cast<const char*>(header);
+    member_array = reinterpret_cast<const int*>(base + header->members_offset);
+    slot_array = reinterpret_cast<const int*>(base + header->slots_offset);
+    mask = size_t(header->num_slots - 1);
+}
+
+#ifdef __linux__
+
+bool IntSetShared::publish(const string& name, const IntSet& is)
+{
+    if (!validName(name))
+        return false;
+
+    // Open (or create and initialize) the control segment.
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return false;
+    struct stat status;
+    bool fresh = false;
+    if (fstat(fd, &status) != 0 ||
+        ((fresh = status.st_size == 0) && ftruncate(fd, sizeof(Control)) != 0) ||
+        (!fresh && size_t(status.st_size) < sizeof(Control))) {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(NULL, sizeof(Control), PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    Control* ctl = static_cast<Control*>(mapped);
+    if (fresh) {
+        memcpy(ctl->magic, MAGIC, sizeof MAGIC);
+        ctl->layout = LAYOUT;
+        new (&ctl->version) std::atomic<uint64_t>(0);
+    } else if (memcmp(ctl->magic, MAGIC, sizeof MAGIC) != 0 ||
+               ctl->layout != LAYOUT) {
+        munmap(mapped, sizeof(Control));
+        return false;
+    }
+
+    // Lay the new version out.
+    uint64_t version = ctl->version.load(memory_order_relaxed) + 1;
+    uint64_t count = uint64_t(is.used);
+    uint64_t num_slots = Index::sizeFor(size_t(count));
+    uint64_t members_offset = alignUp(sizeof(Header));
+    uint64_t slots_offset = alignUp(members_offset + count * sizeof(int));
+    uint64_t total = slots_offset + num_slots * sizeof(int);
+
+    // Write it. A segment by this name can only be left over from a
+    // writer that died before publishing it.
+    string segment = versionName(name, version);
+    fd = shm_open(segment.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        shm_unlink(segment.c_str());
+        fd = shm_open(segment.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    }
+    void* block = MAP_FAILED;
+    if (fd >= 0 && ftruncate(fd, off_t(total)) == 0)
+        block = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (fd >= 0)
+        close(fd);
+    if (block == MAP_FAILED) {
+        if (fd >= 0)
+            shm_unlink(segment.c_str());
+        munmap(mapped, sizeof(Control));
+        return false;
+    }
+
+    char* base = static_cast<char*>(block);
+    Header* head = reinterpret_cast<Header*>(base);
+    memcpy(head->magic, MAGIC, sizeof MAGIC);
+    head->layout = LAYOUT;
+    head->has_marker = is.has_marker ? 1 : 0;
+    head->version = version;
+    head->count = count;
+    head->num_slots = num_slots;
+    head->members_offset = members_offset;
+    head->slots_offset = slots_offset;
+    head->unused = 0;
+    int* members = reinterpret_cast<int*>(base + members_offset);
+    int* slots = reinterpret_cast<int*>(base + slots_offset);
+    memcpy(members, is.data, count * sizeof(int));
+    Index::build(members, size_t(count), slots, size_t(num_slots));
+    munmap(block, total);
+
+    // Publish it, and retire the version it replaces.
+    ctl->version.store(version, memory_order_release);
+    munmap(mapped, sizeof(Control));
+    if (version > 1)
+        shm_unlink(versionName(name, version - 1).c_str());
+    return true;
+}
+
+bool IntSetShared::destroy(const string& name)
+{
+    if (!validName(name))
+        return false;
+    IntSetShared current;
+    if (current.attach(name))
+        shm_unlink(versionName(name, current.version()).c_str());
+    return shm_unlink(name.c_str()) == 0;
+}
+
+// Map the current version of name (whose control segment is mapped at
+// control) read-only; NULL if there is none or it can't be mapped.
+const IntSetShared::Header* IntSetShared::mapVersion(const string& name,
+                                                     const Control* control,
+                                                     size_t& bytes)
+{
+    for (int attempt = 0; attempt < OPEN_RETRIES; ++attempt) {
+        uint64_t version = control->version.load(memory_order_acquire);
+        if (version == 0)
+            return NULL;
+        int fd = shm_open(versionName(name, version).c_str(), O_RDONLY, 0);
+        if (fd < 0 && errno == ENOENT)
+            continue;   // just retired; see note (3)
+        if (fd < 0)
+            return NULL;
+
+        struct stat status;
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &status) == 0 && size_t(status.st_size) >= sizeof(Header))
+            mapped = mmap(NULL, size_t(status.st_size), PROT_READ, MAP_SHARED,
+                          fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED)
+            return NULL;
+
+        // Check the layout before trusting any offset in it.
+        const Header* header = static_cast<const Header*>(mapped);
+        uint64_t size = uint64_t(status.st_size);
+        bool sane = memcmp(header->magic, MAGIC, sizeof MAGIC) == 0 &&
+                    header->layout == LAYOUT &&
+                    header->version == version &&
+                    header->count <= uint64_t(IntSet::MAX_CAPACITY) &&
+                    header->num_slots >= 2 * header->count &&
+                    (header->num_slots & (header->num_slots - 1)) == 0 &&
+                    header->num_slots <= 4 * uint64_t(IntSet::MAX_CAPACITY) &&
+                    header->members_offset >= sizeof(Header) &&
+                    header->members_offset + header->count * sizeof(int) <=
+                        header->slots_offset &&
+                    header->slots_offset + header->num_slots * sizeof(int) <=
+                        size;
+        if (!sane) {
+            munmap(mapped, size_t(status.st_size));
+            return NULL;
+        }
+        bytes = size_t(status.st_size);
+        return header;
+    }
+    return NULL;
+}
+
+bool IntSetShared::attach(const string& name)
+{
+    if (!validName(name))
+        return false;
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+    struct stat status;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && size_t(status.st_size) >= sizeof(Control))
+        mapped = mmap(NULL, sizeof(Control), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+
+    const Control* new_control = static_cast<const Control*>(mapped);
+    size_t new_bytes = 0;
+    const Header* new_header = NULL;
+    if (memcmp(new_control->magic, MAGIC, sizeof MAGIC) == 0 &&
+        new_control->layout == LAYOUT)
+        new_header = mapVersion(name, new_control, new_bytes);
+    if (new_header == NULL) {
+        munmap(mapped, sizeof(Control));
+        return false;
+    }
+
+    detach();
+    use(new_control, new_header, new_bytes);
+    this->name = name;
+    return true;
+}
+
+bool IntSetShared::refresh()
+{
+    if (!isStale())
+        return false;
+    size_t new_bytes = 0;
+    const Header* new_header = mapVersion(name, control, new_bytes);
+    if (new_header == NULL)
+        return false;
+    munmap(const_cast<Header*>(header), bytes);
+    use(control, new_header, new_bytes);
+    return true;
+}
+
+void IntSetShared::detach()
+{
+    if (header != NULL)
+        munmap(const_cast<Header*>(header), bytes);
+    if (control != NULL)
+        munmap(const_cast<Control*>(control), sizeof(Control));
+    control = NULL;
+    header = NULL;
+    bytes = 0;
+    member_array = NULL;
+    slot_array = NULL;
+    mask = 0;
+    name.clear();
+}
+
+#else
+
+bool IntSetShared::publish(const string&, const IntSet&)
+{
+    return false;
+}
+
+bool IntSetShared::destroy(const string&)
+{
+    return false;
+}
+
+bool IntSetShared::attach(const string&)
+{
+    return false;
+}
+
+bool IntSetShared::refresh()
+{
+    return false;
+}
+
+void IntSetShared::detach()
+{
+}
+
+#endif
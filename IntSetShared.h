@@ -0,0 +1,137 @@
+// FILE: IntSetShared.h - header file for IntSetShared class
+// CLASS PROVIDED: IntSetShared (a read-only IntSet that lives in POSIX
+//                 shared memory, so any number of processes can map
+//                 one copy of it; one writer publishes new versions
+//                 of it, which readers pick up when they refresh)
+//
+// Each published version is an immutable shared memory segment named
+// NAME.V (V = 1, 2, ...) holding a header, the members in membership
+// order and a hash index over them. The layout is pointer-free (all
+// positions are offsets from the start of the segment), so every
+// process may map it at a different address. A small control segment,
+// NAME itself, holds the number of the current version. Publishing
+// writes the whole new version first, then switches the control
+// segment to it and unlinks the previous version: readers still
+// mapping that one keep a consistent (if old) snapshot until they
+// refresh or detach, and the memory is freed once the last of them
+// has. Lookups are O(1) expected and touch only the shared pages.
+//
+// STATIC MEMBER FUNCTIONS (THE WRITER)
+//   bool publish(const std::string& name, const IntSet& is)
+//     Pre:  name starts with '/', has no other '/' and is at most
+//           MAX_NAME chars long. This process is the only one
+//           publishing under name.
+//     Post: If the shared memory could be created, a copy of is has
+//           become the current version of name (the first one if
+//           name had none) and true is returned; otherwise nothing
+//           has changed and false is returned.
+//   bool destroy(const std::string& name)
+//     Post: The control segment and current version of name have
+//           been unlinked (true is returned if there was a control
+//           segment); attached readers keep what they have mapped.
+//
+// CONSTRUCTOR
+//   IntSetShared()
+//     Post: The invoking IntSetShared is not attached to anything
+//           (it behaves as an empty set, version 0).
+//
+// DESTRUCTOR
+//   ~IntSetShared()
+//     Post: Whatever was mapped has been unmapped.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   bool isAttached() const
+//     Post: True is returned if a version is mapped.
+//   unsigned long long version() const
+//     Post: The number of the version mapped is returned (0 if none).
+//   bool isStale() const
+//     Post: True is returned if a newer version has been published
+//           since the one mapped.
+//   size_t mappedBytes() const
+//     Post: Size of the mapped version (shared with the other
+//           processes mapping it) in bytes is returned.
+//   size_t size() const
+//   bool isEmpty() const
+//   bool contains(int anInt) const
+//   void containsMany(const int* keys, size_t n, uint8_t* out) const
+//     Post: As for IntSet, on the version mapped.
+//   const int* members() const
+//     Post: The members of the version mapped, in membership order,
+//           are returned (size() of them); the array stays valid
+//           until the next refresh() or detach().
+//   IntSet toIntSet() const
+//     Post: A private copy of the version mapped is returned.
+//
+// MODIFICATION MEMBER FUNCTIONS (MUTATORS)
+//   bool attach(const std::string& name)
+//     Post: If name has a published version that could be mapped, the
+//           invoking IntSetShared has been detached from what it had
+//           and maps name's current version read-only, and true is
+//           returned; otherwise it is unchanged and false is returned.
+//   bool refresh()
+//     Pre:  isAttached().
+//     Post: If a newer version has been published and could be
+//           mapped, it has replaced the one mapped and true is
+//           returned; otherwise false is returned.
+//   void detach()
+//     Post: Nothing is mapped any more (as just constructed).
+//
+// VALUE SEMANTICS
+//   Assignment and the copy constructor may NOT be used with
+//   IntSetShared objects (use toIntSet() for a copy, or attach a
+//   second one).
+//
+// Shared memory is only supported on Linux; elsewhere publish() and
+// attach() always fail.
+
+#ifndef INT_SET_SHARED_H
+#define INT_SET_SHARED_H
+
+#include "IntSet.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class IntSetShared
+{
+public:
+   static const size_t MAX_NAME = 200;
+   static bool publish(const std::string& name, const IntSet& is);
+   static bool destroy(const std::string& name);
+   IntSetShared();
+   ~IntSetShared();
+   bool isAttached() const;
+   unsigned long long version() const;
+   bool isStale() const;
+   size_t mappedBytes() const;
+   size_t size() const;
+   bool isEmpty() const;
+   bool contains(int anInt) const;
+   void containsMany(const int* keys, size_t n, uint8_t* out) const;
+   const int* members() const;
+   IntSet toIntSet() const;
+   bool attach(const std::string& name);
+   bool refresh();
+   void detach();
+
+private:
+   struct Control;
+   struct Header;
+
+   IntSetShared(const IntSetShared&);
+   IntSetShared& operator=(const IntSetShared&);
+   static const Header* mapVersion(const std::string& name,
+                                   const Control* control, size_t& bytes);
+   void use(const Control* new_control, const Header* new_header,
+            size_t new_bytes);
+
+   const Control* control;        // name's control segment
+   const Header*  header;         // the version mapped
+   size_t         bytes;          // of the version mapped
+   const int*     member_array;   // into the version mapped
+   const int*     slot_array;     // into the version mapped
+   size_t         mask;           // # of index slots - 1
+   std::string    name;
+};
+
+#endif
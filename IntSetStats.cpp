@@ -0,0 +1,195 @@
+// FILE: IntSetStats.cpp
+//       Implementation file for the IntSetStats class
+//       (See IntSetStats.h for documentation.)
+// NOTES on the implementation:
+// (1) Every counter is a relaxed atomic so IntSet's used from many
+//     threads can all record without locks; a snapshot taken while
+//     others record is therefore not one single instant, but every
+//     counter in it is exact for some instant.
+// (2) Bucket b < 2 * SUB_BUCKETS holds latency b ns exactly. Above
+//     that, a latency v with highest set bit e (e >= 5) goes to
+//     bucket 2 * SUB_BUCKETS + (e - 5) * SUB_BUCKETS + (the 4 bits of
+//     v just below bit e); latencies past the last bucket land in it.
+
+#include "IntSetStats.h"
+#include <atomic>
+#include <iomanip>
+using namespace std;
+
+namespace
+{
+    typedef atomic<unsigned long long> Counter;
+
+    const int SUB_BITS = 4;  // log2(SUB_BUCKETS)
+
+    Counter resizes(0);
+    Counter bytesCopied(0);
+    Counter lookups(0);
+    Counter probes(0);
+    Counter calls[IntSetStats::NUM_OPERATIONS];
+    Counter totalNs[IntSetStats::NUM_OPERATIONS];
+    Counter maxNs[IntSetStats::NUM_OPERATIONS];
+    Counter buckets[IntSetStats::NUM_OPERATIONS][IntSetStats::NUM_BUCKETS];
+
+    const char* const OPERATION_NAMES[IntSetStats::NUM_OPERATIONS] = {
+        "add", "remove", "contains", "unionWith", "intersect", "subtract",
+        "isSubsetOf", "operator==", "copy", "assignment"
+    };
+
+    int highestBit(unsigned long long v)
+    {
+        int bit = 0;
+        while (v >>= 1)
+            ++bit;
+        return bit;
+    }
+
+    int bucketOf(unsigned long long ns)
+    {
+        if (ns < 2 * IntSetStats::SUB_BUCKETS)
+            return int(ns);
+        int e = highestBit(ns);
+        int sub = int(ns >> (e - SUB_BITS)) & (IntSetStats::SUB_BUCKETS - 1);
+        int bucket = 2 * IntSetStats::SUB_BUCKETS +
+                     (e - SUB_BITS - 1) * IntSetStats::SUB_BUCKETS + sub;
+        return bucket < IntSetStats::NUM_BUCKETS ? bucket
+                                                 : IntSetStats::NUM_BUCKETS - 1;
+    }
+
+    // Largest latency that falls in bucket.
+    unsigned long long bucketTop(int bucket)
+    {
+        if (bucket < 2 * IntSetStats::SUB_BUCKETS)
+            return (unsigned long long)(bucket);
+        int e = (bucket - 2 * IntSetStats::SUB_BUCKETS) / IntSetStats::SUB_BUCKETS
+                + SUB_BITS + 1;
+        int sub = (bucket - 2 * IntSetStats::SUB_BUCKETS) % IntSetStats::SUB_BUCKETS;
+        unsigned long long width = 1ULL << (e - SUB_BITS);
+        return (1ULL << e) + (unsigned long long)(sub + 1) * width - 1;
+    }
+}
+
+bool IntSetStats::enabled()
+{
+#ifdef INTSET_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+IntSetStats::Snapshot IntSetStats::snapshot()
+{
+    Snapshot stats;
+    stats.resizes = resizes.load(memory_order_relaxed);
+    stats.bytes_copied = bytesCopied.load(memory_order_relaxed);
+    stats.lookups = lookups.load(memory_order_relaxed);
+    stats.probes = probes.load(memory_order_relaxed);
+    for (int op = 0; op < NUM_OPERATIONS; ++op) {
+        stats.calls[op] = calls[op].load(memory_order_relaxed);
+        stats.total_ns[op] = totalNs[op].load(memory_order_relaxed);
+        stats.max_ns[op] = maxNs[op].load(memory_order_relaxed);
+        for (int b = 0; b < NUM_BUCKETS; ++b)
+            stats.buckets[op][b] = buckets[op][b].load(memory_order_relaxed);
+    }
+    return stats;
+}
+
+void IntSetStats::reset()
+{
+    resizes = 0;
+    bytesCopied = 0;
+    lookups = 0;
+    probes = 0;
+    for (int op = 0; op < NUM_OPERATIONS; ++op) {
+        calls[op] = 0;
+        totalNs[op] = 0;
+        maxNs[op] = 0;
+        for (int b = 0; b < NUM_BUCKETS; ++b)
+            buckets[op][b] = 0;
+    }
+}
+
+unsigned long long IntSetStats::percentile(const Snapshot& stats,
+                                           Operation op, double q)
+{
+    unsigned long long total = 0;
+    for (int b = 0; b < NUM_BUCKETS; ++b)
+        total += stats.buckets[op][b];
+    if (total == 0)
+        return 0;
+
+    // Walk up the buckets until q of the calls have been passed.
+    unsigned long long wanted = (unsigned long long)(q * double(total));
+    if (wanted >= total) { wanted = total - 1; }
+    unsigned long long seen = 0;
+    for (int b = 0; b < NUM_BUCKETS; ++b) {
+        seen += stats.buckets[op][b];
+        if (seen > wanted)
+            return bucketTop(b) < stats.max_ns[op] ? bucketTop(b)
+                                                   : stats.max_ns[op];
+    }
+    return stats.max_ns[op];
+}
+
+void IntSetStats::dumpStats(ostream& out)
+{
+    if (!enabled()) {
+        out << "IntSet statistics are off (build with INTSET_STATS)" << endl;
+        return;
+    }
+
+    Snapshot stats = snapshot();
+    out << "resizes: " << stats.resizes
+        << "  bytes copied: " << stats.bytes_copied
+        << "  lookups: " << stats.lookups
+        << "  probes/lookup: " << fixed << setprecision(3)
+        << (stats.lookups ? double(stats.probes) / double(stats.lookups) : 0.0)
+        << endl;
+
+    out << left << setw(12) << "operation" << right << setw(14) << "calls"
+        << setw(12) << "mean_ns" << setw(12) << "p50_ns" << setw(12)
+        << "p99_ns" << setw(12) << "p999_ns" << setw(14) << "max_ns" << endl;
+    for (int op = 0; op < NUM_OPERATIONS; ++op) {
+        if (stats.calls[op] == 0)
+            continue;
+        Operation which = Operation(op);
+        out << left << setw(12) << OPERATION_NAMES[op] << right
+            << setw(14) << stats.calls[op]
+            << setw(12) << setprecision(0)
+            << double(stats.total_ns[op]) / double(stats.calls[op])
+            << setw(12) << percentile(stats, which, 0.50)
+            << setw(12) << percentile(stats, which, 0.99)
+            << setw(12) << percentile(stats, which, 0.999)
+            << setw(14) << stats.max_ns[op] << endl;
+    }
+}
+
+void IntSetStats::recordResize(size_t bytes_copied)
+{
+    resizes.fetch_add(1, memory_order_relaxed);
+    bytesCopied.fetch_add(bytes_copied, memory_order_relaxed);
+}
+
+void IntSetStats::recordCopy(size_t bytes_copied)
+{
+    bytesCopied.fetch_add(bytes_copied, memory_order_relaxed);
+}
+
+void IntSetStats::recordLookup(unsigned probe_count)
+{
+    lookups.fetch_add(1, memory_order_relaxed);
+    probes.fetch_add(probe_count, memory_order_relaxed);
+}
+
+void IntSetStats::recordLatency(Operation op, unsigned long long ns)
+{
+    calls[op].fetch_add(1, memory_order_relaxed);
+    totalNs[op].fetch_add(ns, memory_order_relaxed);
+    buckets[op][bucketOf(ns)].fetch_add(1, memory_order_relaxed);
+
+    unsigned long long longest = maxNs[op].load(memory_order_relaxed);
+    while (ns > longest &&
+           !maxNs[op].compare_exchange_weak(longest, ns, memory_order_relaxed))
+        ;
+}
@@ -0,0 +1,140 @@
+// FILE: IntSetStats.h - header file for IntSetStats class
+// CLASS PROVIDED: IntSetStats (process-wide operation counters and
+//                 latency histograms for IntSet; a non-instantiable
+//                 collection of static functions)
+//
+// COMPILE-TIME SWITCH
+//   IntSet only records anything when it is compiled with
+//   INTSET_STATS defined (cmake -DINTSET_STATS=ON). Otherwise the
+//   recording hooks in IntSet.cpp expand to nothing, so they cost
+//   nothing; the functions below still exist and report zeros.
+//
+// ENUMERATION
+//   enum Operation { OP_ADD, OP_REMOVE, OP_CONTAINS, OP_UNION,
+//                    OP_INTERSECT, OP_SUBTRACT, OP_SUBSET, OP_EQUAL,
+//                    OP_COPY, OP_ASSIGN, NUM_OPERATIONS }
+//     The IntSet operations that get a latency histogram (add,
+//     remove, contains, unionWith, intersect, subtract, isSubsetOf,
+//     operator==, the copy constructor and assignment). Calls made
+//     from inside other operations (e.g. the adds inside unionWith)
+//     are recorded too.
+//
+// CONSTANTS
+//   static const int SUB_BUCKETS = ____
+//   static const int NUM_BUCKETS = ____
+//     Latencies are kept in HDR-style log-linear buckets: values below
+//     2 * SUB_BUCKETS nanoseconds get a bucket each, and every power
+//     of 2 above that is split into SUB_BUCKETS equal buckets, so any
+//     recorded latency is known to within 1/SUB_BUCKETS of its value.
+//
+// STRUCT
+//   struct Snapshot
+//     A copy of every counter at one moment:
+//     resizes:      # of times an IntSet reallocated its data array.
+//     bytes_copied: bytes of members and index copied by resizes,
+//                   and by the first change to an IntSet sharing
+//                   its storage with copies (copy constructions and
+//                   assignments themselves copy nothing).
+//     lookups:      # of hash index lookups.
+//     probes:       # of index slots those lookups examined
+//                   (probes / lookups is the average probe length).
+//     calls[op], total_ns[op], max_ns[op], buckets[op][b]:
+//                   per-operation call count, summed and longest
+//                   latency, and latency histogram.
+//
+// STATIC MEMBER FUNCTIONS
+//   bool enabled()
+//     Post: True is returned if IntSet was compiled with
+//           INTSET_STATS, otherwise false.
+//   Snapshot snapshot()
+//     Post: The current counters are returned.
+//   void reset()
+//     Post: Every counter is back to 0.
+//   unsigned long long percentile(const Snapshot& stats, Operation op,
+//                                 double q)
+//     Pre:  0 <= q <= 1
+//     Post: The latency (ns) below which a fraction q of op's
+//           recorded calls fell is returned (the upper edge of the
+//           bucket it falls in); 0 if op has no calls.
+//   void dumpStats(std::ostream& out)
+//     Post: The counters, and count/mean/p50/p99/p999/max for every
+//           operation that was called, have been written to out.
+//
+// RECORDING HOOKS (used by IntSet.cpp through the INTSET_STATS_*
+// macros below; not meant to be called directly)
+//   void recordResize(size_t bytes_copied)
+//   void recordCopy(size_t bytes_copied)
+//   void recordLookup(unsigned probe_count)
+//   void recordLatency(Operation op, unsigned long long ns)
+//   class Timer
+//     Records the latency of op from construction to destruction.
+
+#ifndef INT_SET_STATS_H
+#define INT_SET_STATS_H
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+class IntSetStats
+{
+public:
+   enum Operation { OP_ADD, OP_REMOVE, OP_CONTAINS, OP_UNION,
+                    OP_INTERSECT, OP_SUBTRACT, OP_SUBSET, OP_EQUAL,
+                    OP_COPY, OP_ASSIGN, NUM_OPERATIONS };
+   static const int SUB_BUCKETS = 16;
+   static const int NUM_BUCKETS = 2 * SUB_BUCKETS + 43 * SUB_BUCKETS;
+
+   struct Snapshot
+   {
+      unsigned long long resizes;
+      unsigned long long bytes_copied;
+      unsigned long long lookups;
+      unsigned long long probes;
+      unsigned long long calls[NUM_OPERATIONS];
+      unsigned long long total_ns[NUM_OPERATIONS];
+      unsigned long long max_ns[NUM_OPERATIONS];
+      unsigned long long buckets[NUM_OPERATIONS][NUM_BUCKETS];
+   };
+
+   class Timer
+   {
+   public:
+      explicit Timer(Operation op)
+         : timed(op), start(std::chrono::steady_clock::now()) {}
+      ~Timer()
+      {
+         recordLatency(timed, static_cast<unsigned long long>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start).count()));
+      }
+
+   private:
+      Operation                             timed;
+      std::chrono::steady_clock::time_point start;
+   };
+
+   static bool enabled();
+   static Snapshot snapshot();
+   static void reset();
+   static unsigned long long percentile(const Snapshot& stats, Operation op,
+                                        double q);
+   static void dumpStats(std::ostream& out);
+   static void recordResize(size_t bytes_copied);
+   static void recordCopy(size_t bytes_copied);
+   static void recordLookup(unsigned probe_count);
+   static void recordLatency(Operation op, unsigned long long ns);
+
+private:
+   IntSetStats();
+};
+
+#ifdef INTSET_STATS
+#define INTSET_STATS_TIME(op) IntSetStats::Timer statsTimer(IntSetStats::op)
+#define INTSET_STATS_RECORD(call) IntSetStats::call
+#else
+#define INTSET_STATS_TIME(op)
+#define INTSET_STATS_RECORD(call)
+#endif
+
+#endif
@@ -0,0 +1,389 @@
+// FILE: IntSetStorage.cpp
+//       Implementation file for the IntSetStorage class
+//       (See IntSetStorage.h for documentation.)
+// NOTES on the implementation:
+// (1) Whether an array is "large" depends only on its size, so
+//     release() can tell how an array was obtained from its count
+//     alone, even if the NUMA policy changed in between.
+// (2) Large arrays are mapped with mmap and placed with the mbind
+//     system call BEFORE anything touches them, so every page lands
+//     where the policy says the first time it is faulted in. mbind is
+//     called through syscall() so that libnuma isn't needed.
+// (3) Large arrays are always mapped 2 MB aligned and 2 MB rounded
+//     (see HUGE_PAGE_BYTES), whatever the page mode, so release()
+//     knows the mapping's extent from count alone. Alignment comes
+//     from over-mapping by 2 MB and unmapping the unaligned ends.
+// (4) The NUMA topology (which nodes have memory and which CPUs each
+//     one has) is read once from /sys/devices/system/node; anything
+//     unreadable is treated as a single node holding every CPU.
+// (5) liveBytes and peakBytes count blockBytes(count), the memory
+//     an array really ties up, so a slightly-over-2 MB array counts
+//     as 4 MB. The peak is raised with a compare-and-swap loop, so
+//     it may briefly lag liveBytes but never misses a high point.
+
+#include "IntSetStorage.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+namespace
+{
+    // Memory policy modes from <linux/mempolicy.h>.
+    const int MODE_PREFERRED = 1;
+    const int MODE_INTERLEAVE = 3;
+
+    // Node mask handed to mbind: room for 1024 nodes.
+    const int MASK_WORDS = 16;
+    const int MASK_BITS = MASK_WORDS * 8 * int(sizeof(unsigned long));
+
+    atomic<int> currentPolicy(IntSetStorage::NUMA_DEFAULT);
+    atomic<int> currentPageMode(IntSetStorage::PAGES_DEFAULT);
+    atomic<unsigned long> hugetlbBlocks(0);
+    atomic<unsigned long> advisedBlocks(0);
+    atomic<unsigned long> fallbackBlocks(0);
+    atomic<unsigned long> allocations(0);
+    atomic<unsigned long long> bytesHandedOut(0);
+    atomic<size_t> bytesLive(0);
+    atomic<size_t> bytesPeak(0);
+
+    struct Topology
+    {
+        vector<int>          nodeIds;   // kernel node # of each node
+        vector< vector<int> > cpus;     // CPUs of each node
+    };
+
+    // Expand a sysfs list such as "0-3,8,10-11".
+    vector<int> parseList(const string& text)
+    {
+        vector<int> ids;
+        stringstream in(text);
+        string range;
+        while (getline(in, range, ',')) {
+            int lo, hi;
+            char dash;
+            stringstream part(range);
+            if (!(part >> lo))
+                continue;
+            hi = (part >> dash >> hi) ? hi : lo;
+            for (int id = lo; id <= hi; ++id)
+                ids.push_back(id);
+        }
+        return ids;
+    }
+
+    string readLine(const string& path)
+    {
+        ifstream in(path.c_str());
+        string line;
+        getline(in, line);
+        return line;
+    }
+
+    Topology loadTopology()
+    {
+        Topology topo;
+        const string root = "/sys/devices/system/node/";
+        vector<int> ids = parseList(readLine(root + "has_memory"));
+        if (ids.empty())
+            ids = parseList(readLine(root + "online"));
+
+        for (size_t i = 0; i < ids.size(); ++i) {
+            stringstream path;
+            path << root << "node" << ids[i] << "/cpulist";
+            vector<int> cpus = parseList(readLine(path.str()));
+            if (!cpus.empty() && ids[i] < MASK_BITS) {
+                topo.nodeIds.push_back(ids[i]);
+                topo.cpus.push_back(cpus);
+            }
+        }
+
+        if (topo.nodeIds.empty()) {
+            int nCpus = int(thread::hardware_concurrency());
+            topo.nodeIds.push_back(0);
+            topo.cpus.push_back(vector<int>());
+            for (int cpu = 0; cpu < (nCpus > 0 ? nCpus : 1); ++cpu)
+                topo.cpus[0].push_back(cpu);
+        }
+        return topo;
+    }
+
+    const Topology& topology()
+    {
+        static const Topology topo = loadTopology();
+        return topo;
+    }
+
+    // Size of the mapping behind a large array of count ints.
+    size_t mappedBytes(size_t count)
+    {
+        const size_t huge = IntSetStorage::HUGE_PAGE_BYTES;
+        return (count * sizeof(int) + huge - 1) / huge * huge;
+    }
+
+#ifdef __linux__
+    // Map bytes (a multiple of HUGE_PAGE_BYTES) of fresh memory that
+    // starts on a HUGE_PAGE_BYTES boundary; NULL if the OS says no.
+    void* mapAligned(size_t bytes)
+    {
+        const size_t huge = IntSetStorage::HUGE_PAGE_BYTES;
+        void* raw = mmap(NULL, bytes + huge, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            return NULL;
+
+        // Keep the aligned bytes in the middle; give back the head (if
+        // any) and the tail (never empty, since the head is < huge).
+        char* start = static_cast<char*>(raw);
+        size_t head = (huge - reinterpret_cast<uintptr_t>(raw) % huge) % huge;
+        if (head > 0)
+            munmap(start, head);
+        munmap(start + head + bytes, huge - head);
+        return start + head;
+    }
+
+    // Get a mapping for a large array backed the way mode says.
+    void* mapLarge(size_t bytes, IntSetStorage::PageMode mode)
+    {
+        if (mode == IntSetStorage::PAGES_HUGETLB) {
+            void* block = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                               -1, 0);
+            if (block != MAP_FAILED) {
+                ++hugetlbBlocks;
+                return block;
+            }
+        }
+
+        void* block = mapAligned(bytes);
+        if (block == NULL || mode == IntSetStorage::PAGES_DEFAULT)
+            return block;
+
+#ifdef MADV_HUGEPAGE
+        if (madvise(block, bytes, MADV_HUGEPAGE) == 0) {
+            ++advisedBlocks;
+            return block;
+        }
+#endif
+        ++fallbackBlocks;
+        return block;
+    }
+
+    // Apply a memory policy to [addr, addr + bytes) for the given node
+    // indexes (positions in topology(), not kernel node #'s). Failure
+    // only means the pages go wherever the OS likes, so it is ignored.
+    void bindRange(void* addr, size_t bytes, int mode,
+                   const vector<int>& nodes)
+    {
+        unsigned long mask[MASK_WORDS] = { 0 };
+        const int wordBits = 8 * int(sizeof(unsigned long));
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            int id = topology().nodeIds[nodes[i]];
+            mask[id / wordBits] |= 1UL << (id % wordBits);
+        }
+        syscall(SYS_mbind, addr, bytes, mode, mask,
+                (unsigned long)(MASK_BITS), 0UL);
+    }
+
+    void place(int* block, size_t count)
+    {
+        int nNodes = IntSetStorage::numaNodes();
+        IntSetStorage::NumaPolicy policy = IntSetStorage::numaPolicy();
+        if (nNodes <= 1 || policy == IntSetStorage::NUMA_DEFAULT)
+            return;
+
+        if (policy == IntSetStorage::NUMA_INTERLEAVE) {
+            vector<int> all;
+            for (int node = 0; node < nNodes; ++node)
+                all.push_back(node);
+            bindRange(block, mappedBytes(count), MODE_INTERLEAVE, all);
+            return;
+        }
+
+        for (int node = 0; node < nNodes; ++node) {
+            size_t begin, end;
+            IntSetStorage::partition(count, node, begin, end);
+            if (begin < end)
+                bindRange(block + begin,
+                          mappedBytes(end - begin), MODE_PREFERRED,
+                          vector<int>(1, node));
+        }
+    }
+#endif
+}
+
+int* IntSetStorage::allocate(size_t count)
+{
+    if (count == 0) { count = 1; }
+
+    // Get the block first: if that throws, nothing was handed out and
+    // the counters must not say otherwise.
+    int* block;
+#ifdef __linux__
+    if (count * sizeof(int) >= LARGE_BLOCK_BYTES) {
+        block = static_cast<int*>(mapLarge(mappedBytes(count), pageMode()));
+        if (block == NULL)
+            throw bad_alloc();
+        place(block, count);
+    } else
+#endif
+    block = new int[count];
+
+    allocations.fetch_add(1, memory_order_relaxed);
+    bytesHandedOut.fetch_add(count * sizeof(int), memory_order_relaxed);
+    size_t bytes = blockBytes(count);
+    size_t live = bytesLive.fetch_add(bytes, memory_order_relaxed) + bytes;
+    size_t peak = bytesPeak.load(memory_order_relaxed);
+    while (live > peak &&
+           !bytesPeak.compare_exchange_weak(peak, live, memory_order_relaxed))
+        ;
+    return block;
+}
+
+void IntSetStorage::release(int* block, size_t count)
+{
+    if (block == NULL)
+        return;
+    if (count == 0) { count = 1; }
+    bytesLive.fetch_sub(blockBytes(count), memory_order_relaxed);
+#ifdef __linux__
+    if (count * sizeof(int) >= LARGE_BLOCK_BYTES) {
+        munmap(block, mappedBytes(count));
+        return;
+    }
+#endif
+    delete [] block;
+}
+
+void IntSetStorage::setNumaPolicy(NumaPolicy policy)
+{
+    currentPolicy = policy;
+}
+
+IntSetStorage::NumaPolicy IntSetStorage::numaPolicy()
+{
+    return NumaPolicy(currentPolicy.load());
+}
+
+void IntSetStorage::setPageMode(PageMode mode)
+{
+    currentPageMode = mode;
+}
+
+IntSetStorage::PageMode IntSetStorage::pageMode()
+{
+    return PageMode(currentPageMode.load());
+}
+
+IntSetStorage::PageStats IntSetStorage::pageStats()
+{
+    PageStats stats;
+    stats.hugetlb_blocks = hugetlbBlocks;
+    stats.advised_blocks = advisedBlocks;
+    stats.fallback_blocks = fallbackBlocks;
+    return stats;
+}
+
+unsigned long IntSetStorage::allocationCount()
+{
+    return allocations.load(memory_order_relaxed);
+}
+
+unsigned long long IntSetStorage::allocatedBytes()
+{
+    return bytesHandedOut.load(memory_order_relaxed);
+}
+
+size_t IntSetStorage::blockBytes(size_t count)
+{
+    if (count == 0) { count = 1; }
+#ifdef __linux__
+    if (count * sizeof(int) >= LARGE_BLOCK_BYTES)
+        return mappedBytes(count);
+#endif
+    return count * sizeof(int);
+}
+
+size_t IntSetStorage::liveBytes()
+{
+    return bytesLive.load(memory_order_relaxed);
+}
+
+size_t IntSetStorage::peakBytes()
+{
+    return bytesPeak.load(memory_order_relaxed);
+}
+
+void IntSetStorage::resetPeak()
+{
+    bytesPeak = bytesLive.load(memory_order_relaxed);
+}
+
+size_t IntSetStorage::residentHugeBytes()
+{
+    // Add up the huge page lines of every mapping; they are in kB.
+    ifstream smaps("/proc/self/smaps");
+    string line;
+    size_t total = 0;
+    while (getline(smaps, line)) {
+        if (line.compare(0, 14, "AnonHugePages:") != 0 &&
+            line.compare(0, 16, "Private_Hugetlb:") != 0 &&
+            line.compare(0, 15, "Shared_Hugetlb:") != 0)
+            continue;
+        stringstream fields(line.substr(line.find(':') + 1));
+        size_t kb = 0;
+        if (fields >> kb)
+            total += kb * 1024;
+    }
+    return total;
+}
+
+int IntSetStorage::numaNodes()
+{
+    return int(topology().nodeIds.size());
+}
+
+int IntSetStorage::numaCpus(int node)
+{
+    return int(topology().cpus[node].size());
+}
+
+void IntSetStorage::partition(size_t count, int node, size_t& begin, size_t& end)
+{
+    // Hand out whole huge pages, as evenly as possible, in node order.
+    size_t perPage = HUGE_PAGE_BYTES / sizeof(int);
+    size_t pages = (count + perPage - 1) / perPage;
+    size_t nNodes = size_t(numaNodes());
+
+    begin = pages * size_t(node) / nNodes * perPage;
+    end = pages * size_t(node + 1) / nNodes * perPage;
+    if (begin > count) { begin = count; }
+    if (end > count) { end = count; }
+}
+
+bool IntSetStorage::pinToNode(int node)
+{
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    const vector<int>& ids = topology().cpus[node];
+    for (size_t i = 0; i < ids.size(); ++i)
+        if (ids[i] < CPU_SETSIZE)
+            CPU_SET(ids[i], &cpus);
+    return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+    (void)node;
+    return false;
+#endif
+}
@@ -0,0 +1,156 @@
+// FILE: IntSetStorage.h - header file for IntSetStorage class
+// CLASS PROVIDED: IntSetStorage (where the dynamic arrays of every
+//                 IntSet come from; a non-instantiable collection of
+//                 static functions)
+//
+// ENUMERATION
+//   enum NumaPolicy { NUMA_DEFAULT, NUMA_INTERLEAVE, NUMA_PARTITION }
+//     How the pages of LARGE arrays are spread over NUMA nodes:
+//     NUMA_DEFAULT:    wherever the OS puts them (normally on the node
+//                      of the thread that first touches each page).
+//     NUMA_INTERLEAVE: round-robin over all nodes, page by page.
+//     NUMA_PARTITION:  the array is cut into numaNodes() contiguous
+//                      parts (see partition()) and part i is placed on
+//                      node i, so that a worker running on node i can
+//                      scan part i without crossing the interconnect.
+//     Small arrays (fewer than LARGE_BLOCK_BYTES bytes) always come
+//     from operator new[] and are never placed.
+//   enum PageMode { PAGES_DEFAULT, PAGES_TRANSPARENT, PAGES_HUGETLB }
+//     What kind of pages back LARGE arrays:
+//     PAGES_DEFAULT:     whatever the OS does by default.
+//     PAGES_TRANSPARENT: the array is marked with
+//                        madvise(MADV_HUGEPAGE) so the kernel backs
+//                        it with transparent huge pages if it can.
+//     PAGES_HUGETLB:     explicit huge pages (MAP_HUGETLB) are tried
+//                        first; if none are reserved, the array falls
+//                        back to PAGES_TRANSPARENT.
+//
+// STRUCT
+//   struct PageStats
+//     Counts of large arrays allocated so far:
+//     hugetlb_blocks:  backed by explicit huge pages.
+//     advised_blocks:  marked for transparent huge pages (the kernel
+//                      may still use small pages; see
+//                      residentHugeBytes()).
+//     fallback_blocks: huge pages were asked for, but neither kind
+//                      could be had.
+//
+// CONSTANTS
+//   static const size_t LARGE_BLOCK_BYTES = ____
+//     Arrays at least this big are mapped straight from the OS (and
+//     placed according to the NUMA policy and page mode); smaller
+//     ones are not.
+//   static const size_t HUGE_PAGE_BYTES = ____
+//     Large arrays start on, and are mapped in whole multiples of,
+//     this many bytes so that any of them can use huge pages. (The
+//     untouched tail of a mapping costs address space, not memory.)
+//
+// STATIC MEMBER FUNCTIONS
+//   int* allocate(size_t count)
+//     Post: An (uninitialized) array of count ints has been obtained
+//           and is returned; large arrays have been placed according
+//           to the current NUMA policy and backed according to the
+//           current page mode. std::bad_alloc is thrown if no memory
+//           could be had.
+//   void release(int* block, size_t count)
+//     Pre:  block was returned by allocate(count) (same count) and
+//           has not been released yet, or block is NULL.
+//     Post: The array has been given back.
+//   void setNumaPolicy(NumaPolicy policy)
+//     Post: Arrays allocated from now on are placed according to
+//           policy (arrays already allocated stay where they are).
+//           Without NUMA support (non-Linux, or a single node) the
+//           policy is remembered but has no effect.
+//   NumaPolicy numaPolicy()
+//     Post: The current NUMA policy is returned.
+//   void setPageMode(PageMode mode)
+//     Post: Large arrays allocated from now on are backed according
+//           to mode (arrays already allocated are unaffected).
+//   PageMode pageMode()
+//     Post: The current page mode is returned.
+//   PageStats pageStats()
+//     Post: The huge page counters are returned.
+//   unsigned long allocationCount()
+//     Post: # of arrays allocate() has handed out so far is returned.
+//   unsigned long long allocatedBytes()
+//     Post: Total # of bytes allocate() has handed out so far (the
+//           ints asked for, not counting rounding) is returned.
+//   size_t blockBytes(size_t count)
+//     Post: # of bytes allocate(count) actually reserves is returned
+//           (large arrays are rounded up to whole HUGE_PAGE_BYTES;
+//           the bookkeeping of operator new[] isn't counted).
+//   size_t liveBytes()
+//     Post: Total blockBytes of the arrays handed out and not yet
+//           released, i.e. the memory all IntSet's hold right now,
+//           is returned.
+//   size_t peakBytes()
+//     Post: The highest liveBytes() has been since the program
+//           started (or since the last resetPeak()) is returned.
+//   void resetPeak()
+//     Post: peakBytes() has been lowered to the current liveBytes().
+//   size_t residentHugeBytes()
+//     Post: # of bytes of this process's memory currently backed by
+//           huge pages of either kind (from /proc/self/smaps) is
+//           returned; 0 if that can't be read. This is what tells
+//           whether PAGES_TRANSPARENT actually got huge pages.
+//   int numaNodes()
+//     Post: # of NUMA nodes with memory is returned (1 if unknown).
+//   int numaCpus(int node)
+//     Pre:  0 <= node < numaNodes()
+//     Post: # of CPUs on node is returned (at least 1).
+//   void partition(size_t count, int node, size_t& begin, size_t& end)
+//     Pre:  0 <= node < numaNodes()
+//     Post: begin/end delimit the elements [begin, end) of a
+//           count-element array that NUMA_PARTITION places on node.
+//           The parts are contiguous, cover the array, and (except
+//           possibly the last) start and end on HUGE_PAGE_BYTES
+//           boundaries, so no page is split between two nodes.
+//   bool pinToNode(int node)
+//     Pre:  0 <= node < numaNodes()
+//     Post: The calling thread has been restricted to run on the
+//           CPUs of node and true is returned; if that isn't
+//           possible, the thread is left as it was and false is
+//           returned.
+
+#ifndef INT_SET_STORAGE_H
+#define INT_SET_STORAGE_H
+
+#include <cstddef>
+
+class IntSetStorage
+{
+public:
+   enum NumaPolicy { NUMA_DEFAULT, NUMA_INTERLEAVE, NUMA_PARTITION };
+   enum PageMode { PAGES_DEFAULT, PAGES_TRANSPARENT, PAGES_HUGETLB };
+   struct PageStats
+   {
+      unsigned long hugetlb_blocks;
+      unsigned long advised_blocks;
+      unsigned long fallback_blocks;
+   };
+   static const size_t LARGE_BLOCK_BYTES = size_t(2) << 20;
+   static const size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+   static int* allocate(size_t count);
+   static void release(int* block, size_t count);
+   static void setNumaPolicy(NumaPolicy policy);
+   static NumaPolicy numaPolicy();
+   static void setPageMode(PageMode mode);
+   static PageMode pageMode();
+   static PageStats pageStats();
+   static unsigned long allocationCount();
+   static unsigned long long allocatedBytes();
+   static size_t blockBytes(size_t count);
+   static size_t liveBytes();
+   static size_t peakBytes();
+   static void resetPeak();
+   static size_t residentHugeBytes();
+   static int numaNodes();
+   static int numaCpus(int node);
+   static void partition(size_t count, int node, size_t& begin, size_t& end);
+   static bool pinToNode(int node);
+
+private:
+   IntSetStorage();
+};
+
+#endif
@@ -0,0 +1,129 @@
+// FILE: IntSetTrace.cpp
+//       Implementation file for the IntSetTrace class
+//       (See IntSetTrace.h for documentation.)
+// NOTES on the implementation:
+// (1) Each thread gets its own Ring the first time it records an
+//     event; only that thread ever writes to it, so recording takes
+//     no lock and no read-modify-write: the event goes in the slot at
+//     count % RING_EVENTS and count is then published with a release
+//     store. The registry lock is taken once per thread (to add its
+//     Ring) and by writeJson/clear.
+// (2) Rings are owned by the registry, not by their thread, so the
+//     events of threads that have exited (e.g. IntSetBuilder's
+//     workers) are still there to be written out.
+// (3) writeJson reads rings that other threads may write to, which
+//     is why it requires that no traced operation be running.
+
+#include "IntSetTrace.h"
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+using namespace std;
+
+atomic<bool> IntSetTrace::on(false);
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        long long   size;
+        long long   begin;   // ns
+        long long   end;     // ns
+    };
+
+    struct Ring
+    {
+        explicit Ring(int thread_id) : tid(thread_id), count(0),
+                                       events(IntSetTrace::RING_EVENTS) {}
+        int                  tid;
+        atomic<long long>    count;    // events ever recorded
+        vector<Event>        events;
+    };
+
+    mutex registryLock;
+    vector< unique_ptr<Ring> >& registry()
+    {
+        static vector< unique_ptr<Ring> > rings;
+        return rings;
+    }
+
+    thread_local Ring* myRing = NULL;
+
+    Ring* ringOfThisThread()
+    {
+        if (myRing == NULL) {
+            lock_guard<mutex> guard(registryLock);
+            registry().push_back(
+                unique_ptr<Ring>(new Ring(int(registry().size()) + 1)));
+            myRing = registry().back().get();
+        }
+        return myRing;
+    }
+}
+
+void IntSetTrace::start()
+{
+    on.store(true, memory_order_relaxed);
+}
+
+void IntSetTrace::stop()
+{
+    on.store(false, memory_order_relaxed);
+}
+
+void IntSetTrace::record(const char* name, long long size,
+                         long long begin, long long end)
+{
+    Ring* ring = ringOfThisThread();
+    long long n = ring->count.load(memory_order_relaxed);
+    Event& slot = ring->events[size_t(n % RING_EVENTS)];
+    slot.name = name;
+    slot.size = size;
+    slot.begin = begin;
+    slot.end = end;
+    ring->count.store(n + 1, memory_order_release);
+}
+
+void IntSetTrace::writeJson(ostream& out)
+{
+    lock_guard<mutex> guard(registryLock);
+#ifdef __linux__
+    long pid = long(getpid());
+#else
+    long pid = 1;
+#endif
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    ios_base::fmtflags flags = out.flags();
+    out << fixed << setprecision(3);
+    for (size_t r = 0; r < registry().size(); ++r) {
+        const Ring& ring = *registry()[r];
+        long long count = ring.count.load(memory_order_acquire);
+        long long oldest = count > RING_EVENTS ? count - RING_EVENTS : 0;
+        for (long long n = oldest; n < count; ++n) {
+            const Event& e = ring.events[size_t(n % RING_EVENTS)];
+            out << (first ? "\n" : ",\n")
+                << "{\"name\":\"" << e.name << "\",\"cat\":\"IntSet\""
+                << ",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << ring.tid
+                << ",\"ts\":" << double(e.begin) / 1e3
+                << ",\"dur\":" << double(e.end - e.begin) / 1e3
+                << ",\"args\":{\"n\":" << e.size << "}}";
+            first = false;
+        }
+    }
+    out << "\n]}" << endl;
+    out.flags(flags);
+}
+
+void IntSetTrace::clear()
+{
+    lock_guard<mutex> guard(registryLock);
+    for (size_t r = 0; r < registry().size(); ++r)
+        registry()[r]->count.store(0, memory_order_relaxed);
+}
@@ -0,0 +1,105 @@
+// FILE: IntSetTrace.h - header file for IntSetTrace class
+// CLASS PROVIDED: IntSetTrace (scoped trace events for IntSet's heavy
+//                 operations, kept in per-thread ring buffers and
+//                 written out as Chrome trace-event JSON, which
+//                 chrome://tracing and Perfetto load directly; a
+//                 non-instantiable collection of static functions)
+//
+// Tracing is switched on and off at run time. While it is off, a
+// traced operation costs one relaxed atomic load and a branch.
+//
+// CONSTANT
+//   static const int RING_EVENTS = ____
+//     # of events each thread's ring buffer holds; once it is full,
+//     a thread's newest events overwrite its oldest.
+//
+// STATIC MEMBER FUNCTIONS
+//   void start()
+//     Post: Traced operations record events from now on.
+//   void stop()
+//     Post: Traced operations no longer record events (events already
+//           recorded are kept).
+//   bool enabled()
+//     Post: True is returned if events are being recorded.
+//   void writeJson(std::ostream& out)
+//     Pre:  No traced operation is running on another thread (e.g.
+//           call it after stop() once the workers are idle).
+//     Post: Every recorded event still in a ring buffer has been
+//           written to out as one Chrome trace-event JSON object
+//           ("X" complete events, timestamps in microseconds, one
+//           tid per thread that recorded anything).
+//   void clear()
+//     Pre:  Same as writeJson.
+//     Post: All recorded events have been discarded.
+//
+// CLASS
+//   class Scope
+//     Scope(const char* name, long long size)
+//       Pre:  name outlives the trace (a string literal).
+//       Post: If tracing is on, an event called name whose "n"
+//             argument is size is recorded when the Scope is
+//             destroyed, spanning the Scope's lifetime.
+//
+// MACRO
+//   INTSET_TRACE_SCOPE(name, size)
+//     Declares a Scope for the rest of the enclosing block.
+
+#ifndef INT_SET_TRACE_H
+#define INT_SET_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+class IntSetTrace
+{
+public:
+   static const int RING_EVENTS = 1 << 15;
+
+   class Scope
+   {
+   public:
+      Scope(const char* name, long long size)
+         : event_name(name), event_size(size), begin(enabled() ? now() : -1)
+      {}
+      ~Scope()
+      {
+         if (begin >= 0)
+            record(event_name, event_size, begin, now());
+      }
+
+   private:
+      Scope(const Scope&);
+      Scope& operator=(const Scope&);
+
+      const char* event_name;
+      long long   event_size;
+      long long   begin;   // ns since the trace clock's epoch; -1: off
+   };
+
+   static void start();
+   static void stop();
+   static bool enabled()
+   {
+      return on.load(std::memory_order_relaxed);
+   }
+   static void writeJson(std::ostream& out);
+   static void clear();
+
+private:
+   IntSetTrace();
+   static long long now()
+   {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now().time_since_epoch()).count();
+   }
+   static void record(const char* name, long long size,
+                      long long begin, long long end);
+
+   static std::atomic<bool> on;
+};
+
+#define INTSET_TRACE_SCOPE(name, size) \
+   IntSetTrace::Scope traceScope(name, (long long)(size))
+
+#endif
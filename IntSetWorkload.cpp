@@ -0,0 +1,237 @@
+// FILE: IntSetWorkload.cpp
+//       Implementation file for the IntSetWorkload class
+//       (See IntSetWorkload.h for documentation.)
+// NOTES on the implementation:
+// (1) ZIPF ids come from inverting the CDF of the continuous power
+//     law x^-s on [1, range + 1] and taking floor(x) - 1, which needs
+//     no table (so any range works) and is close to the discrete Zipf
+//     law everywhere but the first few ranks.
+// (2) Only std::mt19937's raw output is used (never the standard
+//     distributions, whose algorithms differ between library
+//     vendors), so a seed gives the same workload on every platform.
+
+#include "IntSetWorkload.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+using namespace std;
+
+namespace
+{
+    const char* const MIX_COMMANDS = "abcdeikmrsuz";
+
+    // Uniform in [0, bound) from 32 raw bits (bias < bound / 2^32).
+    int below(mt19937& rng, int bound)
+    {
+        return int((unsigned long long)(rng()) * unsigned(bound) >> 32);
+    }
+
+    // Uniform in [0, 1).
+    double unit(mt19937& rng)
+    {
+        return double(rng()) / 4294967296.0;
+    }
+}
+
+IntSetWorkload::IntSetWorkload(unsigned seed)
+    : rng(seed), dist(UNIFORM), range(1000000), zipf_s(1.0),
+      cluster_len(64), run_next(0), run_left(0), seq_next(0)
+{
+    setMix("a=30,c=25,k=15,u=5,i=5,s=5,b=5,e=5,d=5");
+}
+
+IntSetWorkload::Distribution IntSetWorkload::distribution() const
+{
+    return dist;
+}
+
+int IntSetWorkload::valueRange() const
+{
+    return range;
+}
+
+double IntSetWorkload::zipfExponent() const
+{
+    return zipf_s;
+}
+
+int IntSetWorkload::clusterLength() const
+{
+    return cluster_len;
+}
+
+void IntSetWorkload::setDistribution(Distribution new_dist)
+{
+    dist = new_dist;
+}
+
+void IntSetWorkload::setValueRange(int new_range)
+{
+    range = new_range;
+    seq_next = 0;
+    run_left = 0;
+}
+
+void IntSetWorkload::setZipfExponent(double s)
+{
+    zipf_s = s;
+}
+
+void IntSetWorkload::setClusterLength(int length)
+{
+    cluster_len = length;
+    run_left = 0;
+}
+
+bool IntSetWorkload::setMix(const string& spec)
+{
+    vector<Weight> parsed;
+    int total = 0;
+    stringstream in(spec);
+    string item;
+    while (getline(in, item, ',')) {
+        Weight w;
+        char equals;
+        stringstream fields(item);
+        if (!(fields >> w.command >> equals >> w.weight) || equals != '=' ||
+            w.weight < 0 || string(MIX_COMMANDS).find(w.command) == string::npos)
+            return false;
+        parsed.push_back(w);
+        total += w.weight;
+    }
+    if (total <= 0)
+        return false;
+    mix = parsed;
+    return true;
+}
+
+void IntSetWorkload::reseed(unsigned seed)
+{
+    rng.seed(seed);
+    run_left = 0;
+    seq_next = 0;
+}
+
+int IntSetWorkload::nextValue()
+{
+    switch (dist)
+    {
+    case ZIPF:
+        {
+            double u = unit(rng), x;
+            if (fabs(zipf_s - 1.0) < 1e-9) {
+                x = exp(u * log(double(range) + 1.0));
+            } else {
+                double a = 1.0 - zipf_s;
+                x = pow((pow(double(range) + 1.0, a) - 1.0) * u + 1.0, 1.0 / a);
+            }
+            int id = int(x) - 1;
+            return id < 0 ? 0 : id >= range ? range - 1 : id;
+        }
+    case CLUSTERED:
+        if (run_left == 0) {
+            run_next = below(rng, range);
+            run_left = cluster_len;
+        }
+        --run_left;
+        {
+            int id = run_next;
+            run_next = run_next + 1 < range ? run_next + 1 : 0;
+            return id;
+        }
+    case SEQUENTIAL:
+        {
+            int id = seq_next;
+            seq_next = seq_next + 1 < range ? seq_next + 1 : 0;
+            return id;
+        }
+    default:
+        return below(rng, range);
+    }
+}
+
+void IntSetWorkload::drawInto(IntSet& into, vector<int>& added, int size,
+                              const IntSet& avoid)
+{
+    long draws = 16L * size;
+    int last = 0;
+    while (into.size() < size_t(size) && draws-- > 0) {
+        last = nextValue();
+        if (!avoid.contains(last) && into.add(last))
+            added.push_back(last);
+    }
+
+    // The distribution keeps repeating itself: take the unused ids
+    // that follow the last one drawn.
+    for (long long k = 1; into.size() < size_t(size) && k <= range; ++k) {
+        int id = int((last + k) % range);
+        if (!avoid.contains(id) && into.add(id))
+            added.push_back(id);
+    }
+}
+
+IntSet IntSetWorkload::makeSet(int size)
+{
+    IntSet result(size);
+    vector<int> added;
+    drawInto(result, added, size, IntSet());
+    return result;
+}
+
+void IntSetWorkload::makePair(int size, int overlap_percent,
+                              IntSet& lhs, IntSet& rhs)
+{
+    IntSet left(size), right(size);
+    vector<int> leftIds, rightIds;
+    drawInto(left, leftIds, size, IntSet());
+
+    // A random overlap_percent of lhs's members (partial shuffle),
+    // then fresh ids that lhs doesn't have.
+    int shared = int((long long)(size) * overlap_percent / 100);
+    for (int i = 0; i < shared; ++i) {
+        int j = i + below(rng, size - i);
+        swap(leftIds[i], leftIds[j]);
+        right.add(leftIds[i]);
+    }
+    drawInto(right, rightIds, size, left);
+
+    lhs.swap(left);
+    rhs.swap(right);
+}
+
+string IntSetWorkload::script(long commands)
+{
+    int totalWeight = 0;
+    for (size_t m = 0; m < mix.size(); ++m)
+        totalWeight += mix[m].weight;
+    const int hybrids[] = { 1, 2, 3, 12, 13, 23, 123 };
+
+    ostringstream out;
+    for (long n = 0; n < commands; ++n) {
+        int w = below(rng, totalWeight);
+        size_t m = 0;
+        while (w >= mix[m].weight)
+            w -= mix[m++].weight;
+
+        char command = mix[m].command;
+        out << command << '\n';
+        switch (command)
+        {
+        case 'a': case 'c': case 'k':
+            out << 1 + below(rng, 3) << '\n';
+            out << nextValue() << '\n';
+            break;
+        case 'd': case 'm': case 'r': case 'z':
+            out << hybrids[below(rng, 7)] << '\n';
+            break;
+        default:
+            {
+                int primary = 1 + below(rng, 3);
+                int secondary = 1 + below(rng, 3);
+                out << primary * 10 + secondary << '\n';
+            }
+        }
+    }
+    out << "q\n";
+    return out.str();
+}
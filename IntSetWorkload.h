@@ -0,0 +1,127 @@
+// FILE: IntSetWorkload.h - header file for IntSetWorkload class
+// CLASS PROVIDED: IntSetWorkload (a deterministic generator of test
+//                 data for IntSet: ids from a chosen distribution,
+//                 sets and pairs of sets with a given overlap, and
+//                 command streams for the interactive test program)
+//
+// Everything an IntSetWorkload produces depends only on its settings
+// and seed, so the same workload can be regenerated anywhere.
+//
+// ENUMERATION
+//   enum Distribution { UNIFORM, ZIPF, CLUSTERED, SEQUENTIAL }
+//     How ids are drawn from [0, valueRange()):
+//     UNIFORM:    every id equally likely.
+//     ZIPF:       id k has probability roughly proportional to
+//                 1 / (k + 1)^s (see setZipfExponent): 0 is the
+//                 hottest id, and most ids are rare.
+//     CLUSTERED:  runs of clusterLength() consecutive ids, each run
+//                 starting at a uniformly chosen id.
+//     SEQUENTIAL: 0, 1, 2, ... wrapping around at valueRange().
+//
+// CONSTRUCTOR
+//   IntSetWorkload(unsigned seed = 1)
+//     Post: The invoking IntSetWorkload draws UNIFORM ids from
+//           [0, 1000000) with Zipf exponent 1.0, clusters of 64 and
+//           the default command mix (see setMix), from seed.
+//
+// CONSTANT MEMBER FUNCTIONS (ACCESSORS)
+//   Distribution distribution() const
+//   int valueRange() const
+//   double zipfExponent() const
+//   int clusterLength() const
+//     Post: The corresponding setting is returned.
+//
+// MODIFICATION MEMBER FUNCTIONS (MUTATORS)
+//   void setDistribution(Distribution dist)
+//   void setValueRange(int range)          (Pre: range >= 1)
+//   void setZipfExponent(double s)         (Pre: s > 0)
+//   void setClusterLength(int length)      (Pre: length >= 1)
+//     Post: The setting has been changed; ids drawn from now on
+//           follow it.
+//   bool setMix(const std::string& spec)
+//     Post: If spec is a comma-separated list of command=weight
+//           pairs (e.g. "a=30,c=25,k=15,u=5"), where each command is
+//           one of a b c d e i k m r s u z and each weight >= 0 with at
+//           least one > 0, it has become the command mix used by
+//           script() and true is returned; otherwise the mix is
+//           unchanged and false is returned.
+//           Default: a=30,c=25,k=15,u=5,i=5,s=5,b=5,e=5,d=5.
+//   void reseed(unsigned seed)
+//     Post: The generator restarts from seed (settings are kept).
+//   int nextValue()
+//     Post: The next id from the distribution is returned.
+//   IntSet makeSet(int size)
+//     Pre:  0 <= size <= valueRange()
+//     Post: An IntSet of size distinct ids drawn from the
+//           distribution (in draw order) is returned. Ids are drawn
+//           until size distinct ones turn up; if a skewed
+//           distribution keeps repeating itself (after 16 * size
+//           draws), the rest are the unused ids following the
+//           repeats, so the size is always met.
+//   void makePair(int size, int overlap_percent, IntSet& lhs, IntSet& rhs)
+//     Pre:  0 <= overlap_percent <= 100, and 2 * size <= valueRange()
+//     Post: lhs is makeSet(size); rhs has size members of which
+//           size * overlap_percent / 100 are members of lhs (chosen at
+//           random) and the rest are drawn from the distribution
+//           and are not members of lhs.
+//   std::string script(long commands)
+//     Post: commands commands for the interactive test program (in
+//           its batch-mode input format, i.e. each command letter and
+//           argument on a line of its own), drawn from the command
+//           mix, with ids from the distribution and objects chosen
+//           uniformly, followed by q, are returned.
+//
+// VALUE SEMANTICS
+//   Assignment and the copy constructor may be used with
+//   IntSetWorkload objects (a copy continues from the same point).
+
+#ifndef INT_SET_WORKLOAD_H
+#define INT_SET_WORKLOAD_H
+
+#include "IntSet.h"
+#include <random>
+#include <string>
+#include <vector>
+
+class IntSetWorkload
+{
+public:
+   enum Distribution { UNIFORM, ZIPF, CLUSTERED, SEQUENTIAL };
+   IntSetWorkload(unsigned seed = 1);
+   Distribution distribution() const;
+   int valueRange() const;
+   double zipfExponent() const;
+   int clusterLength() const;
+   void setDistribution(Distribution dist);
+   void setValueRange(int range);
+   void setZipfExponent(double s);
+   void setClusterLength(int length);
+   bool setMix(const std::string& spec);
+   void reseed(unsigned seed);
+   int nextValue();
+   IntSet makeSet(int size);
+   void makePair(int size, int overlap_percent, IntSet& lhs, IntSet& rhs);
+   std::string script(long commands);
+
+private:
+   struct Weight
+   {
+      char command;
+      int  weight;
+   };
+
+   void drawInto(IntSet& into, std::vector<int>& added, int size,
+                 const IntSet& avoid);
+
+   std::mt19937        rng;
+   Distribution        dist;
+   int                 range;
+   double              zipf_s;
+   int                 cluster_len;
+   int                 run_next;     // CLUSTERED: next id of the run
+   int                 run_left;     // CLUSTERED: ids left in the run
+   int                 seq_next;     // SEQUENTIAL: next id
+   std::vector<Weight> mix;
+};
+
+#endif
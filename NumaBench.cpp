@@ -0,0 +1,97 @@
+// FILE: NumaBench.cpp
+//       Measures IntSetParallel scan throughput for each NUMA
+//       placement policy, with every piece scanned on its local node
+//       and again with every piece scanned one node over (remote).
+//
+// USAGE: intset_numa_bench [members [repeats]]
+//   members: # of elements in the scanned IntSet (default 20000000)
+//   repeats: # of timed scans per configuration (default 5); the
+//            best time is reported.
+
+#include "IntSet.h"
+#include "IntSetParallel.h"
+#include "IntSetStorage.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+using namespace std;
+
+namespace
+{
+    const char* policyName(IntSetStorage::NumaPolicy policy)
+    {
+        switch (policy)
+        {
+        case IntSetStorage::NUMA_INTERLEAVE:
+            return "interleave";
+        case IntSetStorage::NUMA_PARTITION:
+            return "partition";
+        default:
+            return "default";
+        }
+    }
+
+    // Best-of-repeats countCommon time in seconds.
+    double timeScan(const IntSet& lhs, const IntSet& rhs, int node_shift,
+                    int repeats, size_t& common)
+    {
+        double best = 0;
+        for (int r = 0; r < repeats; ++r) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            common = IntSetParallel::countCommon(lhs, rhs, node_shift);
+            double secs = chrono::duration<double>(
+                              chrono::steady_clock::now() - start).count();
+            if (r == 0 || secs < best) { best = secs; }
+        }
+        return best;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int members = argc > 1 ? atoi(argv[1]) : 20000000;
+    int repeats = argc > 2 ? atoi(argv[2]) : 5;
+    if (members < 1) { members = 1; }
+    if (repeats < 1) { repeats = 1; }
+
+    int nNodes = IntSetStorage::numaNodes();
+    cout << "NUMA nodes: " << nNodes;
+    for (int node = 0; node < nNodes; ++node)
+        cout << (node == 0 ? " (cpus: " : ", ") << IntSetStorage::numaCpus(node);
+    cout << ")" << endl;
+    if (nNodes == 1)
+        cout << "Single node: local and remote runs are the same." << endl;
+
+    const IntSetStorage::NumaPolicy policies[] = {
+        IntSetStorage::NUMA_DEFAULT,
+        IntSetStorage::NUMA_INTERLEAVE,
+        IntSetStorage::NUMA_PARTITION
+    };
+
+    cout << left << setw(12) << "policy" << setw(10) << "schedule"
+         << right << setw(14) << "Melem/s" << setw(12) << "common" << endl;
+    for (int p = 0; p < 3; ++p) {
+
+        // Build both operands under the policy being measured; rhs
+        // holds every other element of lhs.
+        IntSetStorage::setNumaPolicy(policies[p]);
+        IntSet lhs(members), rhs(members / 2 + 1);
+        for (int i = 0; i < members; ++i) {
+            lhs.add(i);
+            if (i % 2 == 0)
+                rhs.add(i);
+        }
+
+        for (int shift = 0; shift < 2; ++shift) {
+            size_t common = 0;
+            double secs = timeScan(lhs, rhs, shift, repeats, common);
+            cout << left << setw(12) << policyName(policies[p])
+                 << setw(10) << (shift == 0 ? "local" : "remote")
+                 << right << setw(14) << fixed << setprecision(1)
+                 << members / secs / 1e6 << setw(12) << common << endl;
+        }
+    }
+    IntSetStorage::setNumaPolicy(IntSetStorage::NUMA_DEFAULT);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,327 @@
+// FILE: PerfGuard.cpp
+//       Performance regression guard for IntSet: runs a fixed set of
+//       scenarios and compares them against baseline numbers kept in
+//       the repository (perf_baselines.txt), failing if one got slower
+//       by more than a tolerance or allocates more than it used to.
+//       CTest runs one scenario per test when the build is configured
+//       with -DINTSET_PERF_TESTS=ON.
+//
+// USAGE: intset_perf_guard --baselines=FILE [--tolerance=X] [--update]
+//                          [scenario ...]
+//   --baselines: baseline file (see below)
+//   --tolerance: a scenario fails if its ns/op is more than X times
+//                its baseline (default 2.5; timings from different
+//                machines or a loaded machine need the slack)
+//   --update:    instead of checking, write the measured numbers of
+//                the scenarios run into FILE (others are kept)
+//   scenario:    scenarios to run (default: all of them)
+//
+// Scenario sizes are fixed, so an operation that turns quadratic
+// shows up as a many-fold slowdown, far past any tolerance. Allocation
+// counts are deterministic and are held to their baseline exactly
+// (give or take rounding).
+//
+// BASELINE FILE: one line per scenario, "name ns_per_op allocs_per_op";
+// lines starting with # are comments.
+//
+// Exit status is 0 if every scenario run is within its baseline, 1
+// otherwise (including a scenario with no baseline).
+
+#include "IntSet.h"
+#include "IntSetStorage.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace
+{
+    const int SIZE = 10000;          // elements per set in every scenario
+    const int BATCHES = 5;           // best-of-BATCHES is reported
+    const double BATCH_SECONDS = 0.05;
+
+    struct Result
+    {
+        double ns_per_op;
+        double allocs_per_op;
+    };
+
+    // Keeps results alive so the compiler can't drop the work.
+    volatile long sink;
+
+    // Times regions and counts allocations made inside them.
+    class Stopwatch
+    {
+    public:
+        Stopwatch() : seconds(0), allocs(0) {}
+        void start()
+        {
+            allocs0 = IntSetStorage::allocationCount();
+            t0 = chrono::steady_clock::now();
+        }
+        void stop()
+        {
+            seconds += chrono::duration<double>(
+                           chrono::steady_clock::now() - t0).count();
+            allocs += IntSetStorage::allocationCount() - allocs0;
+        }
+        double        seconds;
+        unsigned long allocs;
+
+    private:
+        chrono::steady_clock::time_point t0;
+        unsigned long                    allocs0;
+    };
+
+    // Operands shared by the scenarios: lhs and rhs hold SIZE shuffled
+    // values each and overlap by half; keys are rhs's values and
+    // order is lhs's values reshuffled.
+    struct Inputs
+    {
+        vector<int> values;
+        vector<int> keys;
+        vector<int> order;
+        IntSet      lhs;
+        IntSet      rhs;
+    };
+
+    Inputs makeInputs()
+    {
+        Inputs in;
+        mt19937 rng(2024u);
+        for (int i = 0; i < 2 * SIZE; ++i)
+            in.values.push_back(i * 7);
+        shuffle(in.values.begin(), in.values.end(), rng);
+        for (int i = 0; i < SIZE; ++i)
+            in.lhs.add(in.values[i]);
+        in.order.assign(in.values.begin(), in.values.begin() + SIZE);
+        shuffle(in.order.begin(), in.order.end(), rng);
+        for (int i = SIZE / 2; i < SIZE + SIZE / 2; ++i) {
+            in.rhs.add(in.values[i]);
+            in.keys.push_back(in.values[i]);
+        }
+        return in;
+    }
+
+    // One iteration of a scenario; returns the # of operations done.
+    long runOnce(const string& scenario, const Inputs& in, Stopwatch& watch)
+    {
+        if (scenario == "add") {
+            IntSet is;
+            watch.start();
+            for (int i = 0; i < SIZE; ++i)
+                is.add(in.values[i]);
+            watch.stop();
+            sink += is.size();
+            return SIZE;
+        }
+        if (scenario == "remove") {
+            // A copy shares in.lhs's storage until it changes; a remove
+            // and add back make it copy now, so only removals are timed.
+            IntSet is = in.lhs;
+            is.remove(in.order[0]);
+            is.add(in.order[0]);
+            watch.start();
+            for (int i = 0; i < SIZE; ++i)
+                is.remove(in.order[i]);
+            watch.stop();
+            sink += is.size();
+            return SIZE;
+        }
+        if (scenario == "contains") {
+            long hits = 0;
+            watch.start();
+            for (int i = 0; i < SIZE; ++i)
+                hits += in.lhs.contains(in.keys[i]);
+            watch.stop();
+            sink += hits;
+            return SIZE;
+        }
+        if (scenario == "copy") {
+            watch.start();
+            IntSet is(in.lhs);
+            watch.stop();
+            sink += is.size();
+            return 1;
+        }
+        if (scenario == "assignment") {
+            IntSet is;
+            watch.start();
+            is = in.lhs;
+            watch.stop();
+            sink += is.size();
+            return 1;
+        }
+
+        watch.start();
+        if (scenario == "unionWith")
+            sink += in.lhs.unionWith(in.rhs).size();
+        else if (scenario == "intersect")
+            sink += in.lhs.intersect(in.rhs).size();
+        else if (scenario == "subtract")
+            sink += in.lhs.subtract(in.rhs).size();
+        else if (scenario == "isSubsetOf")
+            sink += in.lhs.isSubsetOf(in.rhs);
+        else
+            sink += in.lhs == in.rhs;
+        watch.stop();
+        return 1;
+    }
+
+    const char* const SCENARIOS[] = {
+        "add", "remove", "contains", "copy", "assignment", "unionWith",
+        "intersect", "subtract", "isSubsetOf", "equal"
+    };
+    const int NUM_SCENARIOS = int(sizeof(SCENARIOS) / sizeof(SCENARIOS[0]));
+
+    bool known(const string& scenario)
+    {
+        for (int s = 0; s < NUM_SCENARIOS; ++s)
+            if (scenario == SCENARIOS[s])
+                return true;
+        return false;
+    }
+
+    // Best (lowest) ns/op over BATCHES batches of at least
+    // BATCH_SECONDS each; every batch has the same allocs/op.
+    Result measure(const string& scenario, const Inputs& in)
+    {
+        Result best = { 0, 0 };
+        for (int b = 0; b < BATCHES; ++b) {
+            Stopwatch watch;
+            long ops = 0;
+            do {
+                ops += runOnce(scenario, in, watch);
+            } while (watch.seconds < BATCH_SECONDS);
+            double ns = watch.seconds * 1e9 / double(ops);
+            if (b == 0 || ns < best.ns_per_op)
+                best.ns_per_op = ns;
+            best.allocs_per_op = double(watch.allocs) / double(ops);
+        }
+        return best;
+    }
+
+    map<string, Result> readBaselines(const string& path)
+    {
+        map<string, Result> baselines;
+        ifstream in(path.c_str());
+        string line;
+        while (getline(in, line)) {
+            if (line.empty() || line[0] == '#')
+                continue;
+            stringstream fields(line);
+            string name;
+            Result r;
+            if (fields >> name >> r.ns_per_op >> r.allocs_per_op)
+                baselines[name] = r;
+        }
+        return baselines;
+    }
+
+    bool writeBaselines(const string& path, const map<string, Result>& baselines)
+    {
+        ofstream out(path.c_str());
+        out << "# IntSet performance baselines (see PerfGuard.cpp)\n"
+            << "# scenario    ns_per_op    allocs_per_op\n";
+        for (map<string, Result>::const_iterator it = baselines.begin();
+             it != baselines.end(); ++it)
+            out << left << setw(14) << it->first << right << fixed
+                << setprecision(2) << setw(14) << it->second.ns_per_op
+                << setprecision(4) << setw(12) << it->second.allocs_per_op
+                << '\n';
+        return bool(out);
+    }
+
+    bool parseOption(const char* arg, const char* flag, string& value)
+    {
+        size_t len = strlen(flag);
+        if (strncmp(arg, flag, len) != 0 || arg[len] != '=')
+            return false;
+        value = arg + len + 1;
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    string path;
+    double tolerance = 2.5;
+    bool update = false;
+    vector<string> scenarios;
+
+    for (int a = 1; a < argc; ++a) {
+        string value;
+        if (parseOption(argv[a], "--baselines", value)) {
+            path = value;
+        } else if (parseOption(argv[a], "--tolerance", value)) {
+            tolerance = atof(value.c_str());
+        } else if (strcmp(argv[a], "--update") == 0) {
+            update = true;
+        } else if (known(argv[a])) {
+            scenarios.push_back(argv[a]);
+        } else {
+            cerr << "Unknown option or scenario " << argv[a] << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (path.empty()) {
+        cerr << "--baselines=FILE is required" << endl;
+        return EXIT_FAILURE;
+    }
+    if (scenarios.empty())
+        scenarios.assign(SCENARIOS, SCENARIOS + NUM_SCENARIOS);
+
+    Inputs in = makeInputs();
+    map<string, Result> baselines = readBaselines(path);
+    bool passed = true;
+
+    for (size_t s = 0; s < scenarios.size(); ++s) {
+        const string& name = scenarios[s];
+        Result now = measure(name, in);
+        cout << left << setw(12) << name << right << fixed
+             << setprecision(1) << setw(14) << now.ns_per_op << " ns/op"
+             << setprecision(2) << setw(10) << now.allocs_per_op
+             << " allocs/op";
+
+        if (update) {
+            baselines[name] = now;
+            cout << "  (recorded)" << endl;
+            continue;
+        }
+
+        map<string, Result>::const_iterator it = baselines.find(name);
+        if (it == baselines.end()) {
+            cout << "  FAIL: no baseline" << endl;
+            passed = false;
+            continue;
+        }
+        const Result& base = it->second;
+        bool slow = now.ns_per_op > base.ns_per_op * tolerance;
+        bool allocs = now.allocs_per_op > base.allocs_per_op * 1.001 + 1e-4;
+        cout << "  (baseline " << setprecision(1) << base.ns_per_op
+             << " ns/op, " << setprecision(2) << base.allocs_per_op
+             << " allocs/op)";
+        if (slow || allocs) {
+            cout << "  FAIL:" << (slow ? " slower than tolerance" : "")
+                 << (allocs ? " more allocations" : "") << endl;
+            passed = false;
+        } else {
+            cout << "  ok" << endl;
+        }
+    }
+
+    if (update && !writeBaselines(path, baselines)) {
+        cerr << "Could not write " << path << endl;
+        return EXIT_FAILURE;
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
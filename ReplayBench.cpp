@@ -0,0 +1,140 @@
+// FILE: ReplayBench.cpp
+//       Replays a generated command stream through the same command
+//       dispatch the interactive test program uses (run_command in
+//       Driver.cpp, in batch mode), with all output thrown away, and
+//       reports throughput and per-command latency percentiles.
+//
+// USAGE: intset_replay_bench [commands [value_range [seed [distribution]]]]
+//   commands:     # of commands to replay (default 1000000)
+//   value_range:  values added/queried/removed are drawn from
+//                 [0, value_range), which bounds the set sizes
+//                 (default 1000)
+//   seed:         random seed for the command stream (default 1)
+//   distribution: uniform (default), zipf, clustered or sequential
+//
+// The stream comes from IntSetWorkload::script with its default mix
+// of a (add), c (contains), k (remove), u (union), i (intersect),
+// s (subtract), b (subset), e (equal) and d (display) commands, with
+// adds outnumbering removes so the sets fill up.
+// Each command is timed from just after its letter is read until it
+// has been carried out (i.e., argument parsing is included). When the
+// library is built with INTSET_STATS, IntSet's own counters and
+// per-operation latencies for the run are printed as well.
+
+#include "Driver.h"
+#include "IntSet.h"
+#include "IntSetStats.h"
+#include "IntSetStorage.h"
+#include "IntSetWorkload.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace
+{
+    // A stream buffer that accepts and discards everything.
+    class NullBuffer : public streambuf
+    {
+    protected:
+        int overflow(int c) { return traits_type::not_eof(c); }
+        streamsize xsputn(const char*, streamsize n) { return n; }
+    };
+
+    // Latency at fraction q (0..1) of sorted nanosecond samples.
+    double percentile(const vector<long long>& sorted, double q)
+    {
+        size_t at = size_t(q * double(sorted.size() - 1) + 0.5);
+        return double(sorted[at]);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 1000000;
+    int valueRange = argc > 2 ? atoi(argv[2]) : 1000;
+    unsigned seed = argc > 3 ? unsigned(atoi(argv[3])) : 1u;
+    string distName = argc > 4 ? argv[4] : "uniform";
+    if (count < 1) { count = 1; }
+    if (valueRange < 1) { valueRange = 1; }
+
+    const char* const distNames[] = { "uniform", "zipf", "clustered", "sequential" };
+    int dist = 0;
+    while (dist < 4 && distName != distNames[dist])
+        ++dist;
+    if (dist == 4) {
+        cerr << "Unknown distribution " << distName << endl;
+        return EXIT_FAILURE;
+    }
+
+    IntSetWorkload workload(seed);
+    workload.setDistribution(IntSetWorkload::Distribution(dist));
+    workload.setValueRange(valueRange);
+    istringstream script(workload.script(count));
+    NullBuffer discard;
+    streambuf* savedIn = cin.rdbuf(script.rdbuf());
+    streambuf* savedOut = cout.rdbuf(&discard);
+    streambuf* savedErr = cerr.rdbuf(&discard);
+
+    // Same loop as main in Assign02.cpp, in batch mode (argc == 2),
+    // with a timer around each dispatched command.
+    IntSet is1, is2, is3;
+    map<char, vector<long long> > latencies;
+    chrono::steady_clock::time_point began = chrono::steady_clock::now();
+    for (;;) {
+        char choice = get_user_command();
+        if (choice == 'q' || !cin)
+            break;
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        run_command(choice, is1, is2, is3, 2);
+        chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+        latencies[choice].push_back(
+            chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count());
+    }
+    double seconds = chrono::duration<double>(
+                         chrono::steady_clock::now() - began).count();
+
+    cin.rdbuf(savedIn);
+    cout.rdbuf(savedOut);
+    cerr.rdbuf(savedErr);
+
+    cout << count << " commands in " << fixed << setprecision(3) << seconds
+         << " s: " << setprecision(0) << count / seconds << " commands/s"
+         << endl;
+    cout << "final sizes: is1 " << is1.size() << ", is2 " << is2.size()
+         << ", is3 " << is3.size() << endl;
+    cout << "memory: is1 " << is1.memoryUsage() << ", is2 "
+         << is2.memoryUsage() << ", is3 " << is3.memoryUsage()
+         << " bytes; storage peak " << IntSetStorage::peakBytes()
+         << " bytes" << endl;
+    cout << "cmd" << right << setw(10) << "count" << setw(12) << "mean_us"
+         << setw(12) << "p50_us" << setw(12) << "p90_us" << setw(12)
+         << "p99_us" << setw(12) << "p999_us" << setw(12) << "max_us"
+         << endl;
+    for (map<char, vector<long long> >::iterator it = latencies.begin();
+         it != latencies.end(); ++it) {
+        vector<long long>& ns = it->second;
+        sort(ns.begin(), ns.end());
+        double total = 0;
+        for (size_t i = 0; i < ns.size(); ++i)
+            total += double(ns[i]);
+        cout << left << setw(3) << it->first << right << setw(10) << ns.size()
+             << setprecision(2)
+             << setw(12) << total / double(ns.size()) / 1e3
+             << setw(12) << percentile(ns, 0.50) / 1e3
+             << setw(12) << percentile(ns, 0.90) / 1e3
+             << setw(12) << percentile(ns, 0.99) / 1e3
+             << setw(12) << percentile(ns, 0.999) / 1e3
+             << setw(12) << double(ns.back()) / 1e3 << endl;
+    }
+    if (IntSetStats::enabled())
+        IntSetStats::dumpStats(cout);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+// FILE: WorkloadGen.cpp
+//       Command-line front end to IntSetWorkload: writes generated
+//       sets in the IntSetFile binary format and/or a command script
+//       for the interactive test program.
+//
+// USAGE: intset_workload [--dist=uniform|zipf|clustered|sequential]
+//                        [--range=N] [--zipf=S] [--cluster=L]
+//                        [--seed=N] [--size=N] [--overlap=P]
+//                        [--lhs=FILE] [--rhs=FILE]
+//                        [--script=FILE] [--commands=N] [--mix=SPEC]
+//   --dist, --range, --zipf, --cluster, --mix: IntSetWorkload settings
+//               (defaults: uniform, 1000000, 1.0, 64, its default mix)
+//   --seed:     random seed (default 1)
+//   --size:     members per set (default 100000)
+//   --overlap:  % of lhs's members that rhs shares (default 50)
+//   --lhs:      write a set of --size members to FILE
+//   --rhs:      also write its partner (requires --lhs)
+//   --script:   write --commands commands (default 100000) to FILE;
+//               replay it with "cs3358_abm_assignment2 x < FILE"
+//
+// Sets are generated before the script, from the same seed, so a
+// given command line always writes the same files.
+
+#include "IntSetFile.h"
+#include "IntSetWorkload.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+using namespace std;
+
+namespace
+{
+    bool parseOption(const char* arg, const char* flag, string& value)
+    {
+        size_t len = strlen(flag);
+        if (strncmp(arg, flag, len) != 0 || arg[len] != '=')
+            return false;
+        value = arg + len + 1;
+        return true;
+    }
+
+    bool parseDistribution(const string& name, IntSetWorkload::Distribution& dist)
+    {
+        const char* const names[] = { "uniform", "zipf", "clustered", "sequential" };
+        for (int d = 0; d < 4; ++d) {
+            if (name == names[d]) {
+                dist = IntSetWorkload::Distribution(d);
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    IntSetWorkload workload;
+    unsigned seed = 1;
+    int size = 100000;
+    int overlap = 50;
+    long commands = 100000;
+    string lhsPath, rhsPath, scriptPath;
+
+    for (int a = 1; a < argc; ++a) {
+        string value;
+        IntSetWorkload::Distribution dist;
+        if (parseOption(argv[a], "--dist", value) &&
+            parseDistribution(value, dist)) {
+            workload.setDistribution(dist);
+        } else if (parseOption(argv[a], "--range", value) && atoi(value.c_str()) > 0) {
+            workload.setValueRange(atoi(value.c_str()));
+        } else if (parseOption(argv[a], "--zipf", value) && atof(value.c_str()) > 0) {
+            workload.setZipfExponent(atof(value.c_str()));
+        } else if (parseOption(argv[a], "--cluster", value) && atoi(value.c_str()) > 0) {
+            workload.setClusterLength(atoi(value.c_str()));
+        } else if (parseOption(argv[a], "--mix", value) && workload.setMix(value)) {
+            continue;
+        } else if (parseOption(argv[a], "--seed", value)) {
+            seed = unsigned(strtoul(value.c_str(), NULL, 10));
+        } else if (parseOption(argv[a], "--size", value) && atoi(value.c_str()) >= 0) {
+            size = atoi(value.c_str());
+        } else if (parseOption(argv[a], "--overlap", value) &&
+                   atoi(value.c_str()) >= 0 && atoi(value.c_str()) <= 100) {
+            overlap = atoi(value.c_str());
+        } else if (parseOption(argv[a], "--commands", value) && atol(value.c_str()) >= 0) {
+            commands = atol(value.c_str());
+        } else if (parseOption(argv[a], "--lhs", lhsPath) ||
+                   parseOption(argv[a], "--rhs", rhsPath) ||
+                   parseOption(argv[a], "--script", scriptPath)) {
+            continue;
+        } else {
+            cerr << "Bad option " << argv[a] << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (!rhsPath.empty() && lhsPath.empty()) {
+        cerr << "--rhs needs --lhs" << endl;
+        return EXIT_FAILURE;
+    }
+    long long needed = rhsPath.empty() ? size : 2LL * size;
+    if (!lhsPath.empty() && needed > workload.valueRange()) {
+        cerr << "--range must be at least " << needed << endl;
+        return EXIT_FAILURE;
+    }
+    workload.reseed(seed);
+
+    if (!lhsPath.empty()) {
+        IntSet lhs, rhs;
+        if (rhsPath.empty())
+            lhs = workload.makeSet(size);
+        else
+            workload.makePair(size, overlap, lhs, rhs);
+        if (!IntSetFile::saveFile(lhs, lhsPath) ||
+            (!rhsPath.empty() && !IntSetFile::saveFile(rhs, rhsPath))) {
+            cerr << "Could not write the set files" << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!scriptPath.empty()) {
+        ofstream out(scriptPath.c_str());
+        out << workload.script(commands);
+        if (!out) {
+            cerr << "Could not write " << scriptPath << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}